@@ -0,0 +1,521 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include "vsynth/Oscillator.h"
+#include "vsynth/Wavetable.h"
+#include "vsynth/ADSREnvelope.h"
+#include "vsynth/Effects.h"
+#include "vsynth/Synthesizer.h"
+#include "vsynth/Oversampler.h"
+#include "vsynth/ConvolutionReverb.h"
+#include "vsynth/FFTAnalyzer.h"
+#include "vsynth/Recorder.h"
+
+// Microbenchmarks for the DSP hot paths.
+// Every benchmark reports time_per_sample; the Synthesizer ones also report
+// voices_per_core, the voice count one core sustains in real time.
+
+namespace {
+
+const int BLOCK_SIZE = 256;
+
+void setSampleCounters(benchmark::State& state, int64_t samples)
+{
+    state.SetItemsProcessed(samples);
+    state.counters["time_per_sample"] = benchmark::Counter(
+        static_cast<double>(samples), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+const char* waveformName(WaveformType waveform)
+{
+    switch (waveform) {
+        case WaveformType::SINE: return "sine";
+        case WaveformType::SQUARE: return "square";
+        case WaveformType::SAWTOOTH: return "saw";
+        case WaveformType::TRIANGLE: return "triangle";
+        case WaveformType::NOISE: return "noise";
+        case WaveformType::BANDLIMITED_SQUARE: return "bl_square";
+        case WaveformType::BANDLIMITED_SAWTOOTH: return "bl_saw";
+        case WaveformType::BANDLIMITED_TRIANGLE: return "bl_triangle";
+    }
+    return "unknown";
+}
+
+// Args: waveform
+void BM_OscillatorProcess(benchmark::State& state)
+{
+    WaveformType waveform = static_cast<WaveformType>(state.range(0));
+    Wavetable::initialize();
+    Oscillator oscillator(440.0f, 44100);
+    oscillator.setWaveform(waveform);
+    state.SetLabel(waveformName(waveform));
+
+    for (auto _ : state) {
+        float sum = 0.0f;
+        for (int i = 0; i < BLOCK_SIZE; ++i) {
+            sum += oscillator.process();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+// Args: waveform
+void BM_OscillatorRenderBlock(benchmark::State& state)
+{
+    WaveformType waveform = static_cast<WaveformType>(state.range(0));
+    Wavetable::initialize();
+    Oscillator oscillator(440.0f, 44100);
+    oscillator.setWaveform(waveform);
+    state.SetLabel(waveformName(waveform));
+    std::vector<float> out(BLOCK_SIZE);
+
+    for (auto _ : state) {
+        oscillator.renderBlock(out.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+// Cycles through attack/decay/sustain/release so every stage is measured
+void BM_ADSREnvelopeProcess(benchmark::State& state)
+{
+    ADSRParameters parameters(44100);
+    parameters.setAttack(0.01f);
+    parameters.setDecay(0.02f);
+    parameters.setSustain(0.6f);
+    parameters.setRelease(0.03f);
+    ADSREnvelope envelope(&parameters);
+    envelope.trigger();
+    int64_t position = 0;
+
+    for (auto _ : state) {
+        float sum = 0.0f;
+        for (int i = 0; i < BLOCK_SIZE; ++i) {
+            sum += envelope.process();
+        }
+        benchmark::DoNotOptimize(sum);
+
+        position += BLOCK_SIZE;
+        if (position % 4096 == 0) {
+            envelope.release();
+        } else if (!envelope.isActive()) {
+            envelope.trigger();
+        }
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+// Args: EnvelopeCurve. Same cycle as above, a block at a time
+void BM_ADSREnvelopeRenderBlock(benchmark::State& state)
+{
+    ADSRParameters parameters(44100);
+    parameters.setCurve(static_cast<EnvelopeCurve>(state.range(0)));
+    parameters.setAttack(0.01f);
+    parameters.setDecay(0.02f);
+    parameters.setSustain(0.6f);
+    parameters.setRelease(0.03f);
+    ADSREnvelope envelope(&parameters);
+    envelope.trigger();
+    std::vector<float> out(BLOCK_SIZE);
+    int64_t position = 0;
+
+    for (auto _ : state) {
+        envelope.renderBlock(out.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+
+        position += BLOCK_SIZE;
+        if (position % 4096 == 0) {
+            envelope.release();
+        } else if (!envelope.isActive()) {
+            envelope.trigger();
+        }
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+void BM_DelayEffectProcess(benchmark::State& state)
+{
+    DelayEffect delay(44100);
+    delay.setDelayTime(0.3f);
+    delay.setFeedback(0.4f);
+    delay.setMix(0.3f);
+    float input = 0.5f;
+
+    for (auto _ : state) {
+        float sum = 0.0f;
+        for (int i = 0; i < BLOCK_SIZE; ++i) {
+            sum += delay.process(input);
+            input = -input;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+// Stereo block processing in each DelayMode, with the time gliding
+void BM_DelayEffectModes(benchmark::State& state)
+{
+    DelayEffect delay(44100);
+    delay.setMode(static_cast<DelayMode>(state.range(0)));
+    delay.setFeedback(0.4f);
+    delay.setMix(0.3f);
+    std::vector<float> left(BLOCK_SIZE);
+    std::vector<float> right(BLOCK_SIZE);
+    float time = 0.3f;
+
+    for (auto _ : state) {
+        for (int i = 0; i < BLOCK_SIZE; ++i) {
+            left[i] = (i % 2 == 0) ? 0.5f : -0.5f;
+            right[i] = -left[i];
+        }
+        time = (time > 0.5f) ? 0.3f : time + 0.01f;
+        delay.setDelayTime(time);
+        delay.processStereo(left.data(), right.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(left.data());
+        benchmark::DoNotOptimize(right.data());
+        benchmark::ClobberMemory();
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+void BM_ReverbEffectProcess(benchmark::State& state)
+{
+    ReverbEffect reverb(44100);
+    reverb.setRoomSize(0.7f);
+    reverb.setMix(0.3f);
+    float input = 0.5f;
+
+    for (auto _ : state) {
+        float sum = 0.0f;
+        for (int i = 0; i < BLOCK_SIZE; ++i) {
+            sum += reverb.process(input);
+            input = -input;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+void BM_ReverbEffectProcessStereo(benchmark::State& state)
+{
+    ReverbEffect reverb(44100);
+    reverb.setRoomSize(0.7f);
+    reverb.setMix(0.3f);
+    std::vector<float> input(BLOCK_SIZE);
+    std::vector<float> left(BLOCK_SIZE);
+    std::vector<float> right(BLOCK_SIZE);
+    for (int i = 0; i < BLOCK_SIZE; ++i) {
+        input[i] = (i % 2 == 0) ? 0.5f : -0.5f;
+    }
+
+    for (auto _ : state) {
+        reverb.processStereo(input.data(), left.data(), right.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(left.data());
+        benchmark::DoNotOptimize(right.data());
+        benchmark::ClobberMemory();
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+// Decaying noise impulse response of state.range(0) milliseconds
+void BM_ConvolutionReverb(benchmark::State& state)
+{
+    const int sampleRate = 44100;
+    const int length = static_cast<int>(state.range(0) * sampleRate / 1000);
+    std::vector<float> impulse(length);
+    uint32_t seed = 1;
+    for (int i = 0; i < length; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+        impulse[i] = noise * std::exp(-6.9f * i / length);
+    }
+    
+    ConvolutionReverb reverb(sampleRate);
+    reverb.loadImpulseResponse(std::move(impulse), sampleRate);
+    if (!reverb.waitForLoad()) {
+        state.SkipWithError("Impulse response failed to load");
+        return;
+    }
+    std::vector<float> buffer(BLOCK_SIZE);
+    
+    for (auto _ : state) {
+        for (int i = 0; i < BLOCK_SIZE; ++i) {
+            buffer[i] = (i % 2 == 0) ? 0.5f : -0.5f;
+        }
+        reverb.processBlock(buffer.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+// Holds voices notes; a long release keeps voices sounding when a note
+// number repeats, so any count up to the polyphony stays active.
+// A short render after each note lifts its envelope off zero first.
+void startVoices(Synthesizer& synth, int voices)
+{
+    float block[16];
+    synth.setRelease(1000.0f);
+    for (int i = 0; i < voices; ++i) {
+        synth.noteOn(24 + i % 96, 0.5f);
+        synth.renderBlock(block, 16);
+    }
+}
+
+void setSynthCounters(benchmark::State& state, Synthesizer& synth, int sampleRate, int64_t samples)
+{
+    setSampleCounters(state, samples);
+    const int voices = synth.getActiveVoiceCount();
+    state.counters["voices"] = voices;
+    state.counters["voices_per_core"] = benchmark::Counter(
+        static_cast<double>(voices) * samples / sampleRate, benchmark::Counter::kIsRate);
+}
+
+// Args: voices, sample rate
+void BM_SynthesizerProcess(benchmark::State& state)
+{
+    const int voices = static_cast<int>(state.range(0));
+    const int sampleRate = static_cast<int>(state.range(1));
+    Synthesizer synth(sampleRate, voices);
+    startVoices(synth, voices);
+
+    for (auto _ : state) {
+        float sum = 0.0f;
+        for (int i = 0; i < BLOCK_SIZE; ++i) {
+            sum += synth.process();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    setSynthCounters(state, synth, sampleRate, state.iterations() * BLOCK_SIZE);
+}
+
+// Args: voices, sample rate
+void BM_SynthesizerRenderBlock(benchmark::State& state)
+{
+    const int voices = static_cast<int>(state.range(0));
+    const int sampleRate = static_cast<int>(state.range(1));
+    Synthesizer synth(sampleRate, voices);
+    startVoices(synth, voices);
+    std::vector<float> out(BLOCK_SIZE);
+
+    for (auto _ : state) {
+        synth.renderBlock(out.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    setSynthCounters(state, synth, sampleRate, state.iterations() * BLOCK_SIZE);
+}
+
+// Args: voices. Envelope and mix settings change every block, so the
+// parameters are always gliding and rendered in sub-blocks
+void BM_SynthesizerAutomation(benchmark::State& state)
+{
+    const int voices = static_cast<int>(state.range(0));
+    const int sampleRate = 44100;
+    Synthesizer synth(sampleRate, voices);
+    startVoices(synth, voices);
+    std::vector<float> out(BLOCK_SIZE);
+    int64_t block = 0;
+
+    for (auto _ : state) {
+        const float position = static_cast<float>(block++ % 64) / 64.0f;
+        synth.setSustain(0.4f + 0.4f * position);
+        synth.setRelease(0.2f + position);
+        synth.setReverb(position);
+        synth.setDelay(1.0f - position);
+        synth.renderBlock(out.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    setSynthCounters(state, synth, sampleRate, state.iterations() * BLOCK_SIZE);
+}
+
+// Args: filter type, voices; sawtooth voices whose filter envelope keeps
+// every cutoff moving
+void BM_SynthesizerFilter(benchmark::State& state)
+{
+    const int voices = static_cast<int>(state.range(1));
+    const int sampleRate = 44100;
+    Synthesizer synth(sampleRate, voices);
+    synth.setWaveform(static_cast<int>(WaveformType::SAWTOOTH));
+    synth.setFilterType(static_cast<FilterType>(state.range(0)));
+    synth.setFilterCutoff(400.0f);
+    synth.setFilterResonance(0.6f);
+    synth.setFilterEnvelopeAmount(4.0f);
+    synth.setFilterKeyTracking(0.5f);
+    synth.setFilterSustain(0.0f);
+    synth.setFilterDecay(1000.0f);
+    startVoices(synth, voices);
+    std::vector<float> out(BLOCK_SIZE);
+
+    for (auto _ : state) {
+        synth.renderBlock(out.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    setSynthCounters(state, synth, sampleRate, state.iterations() * BLOCK_SIZE);
+}
+
+void synthesizerArgs(benchmark::internal::Benchmark* benchmark)
+{
+    for (int sampleRate : {44100, 48000, 96000}) {
+        for (int voices : {1, 16, Synthesizer::MAX_VOICES}) {
+            benchmark->Args({voices, sampleRate});
+        }
+    }
+    benchmark->ArgNames({"voices", "rate"});
+}
+
+// Args: oversampling factor, quality; 16 voices at 44.1 kHz
+void BM_SynthesizerOversampled(benchmark::State& state)
+{
+    const int sampleRate = 44100;
+    Synthesizer synth(sampleRate, 16);
+    synth.setOversampling(static_cast<int>(state.range(0)),
+                          static_cast<OversamplingQuality>(state.range(1)));
+    startVoices(synth, 16);
+    std::vector<float> out(BLOCK_SIZE);
+
+    for (auto _ : state) {
+        synth.renderBlock(out.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    setSynthCounters(state, synth, sampleRate, state.iterations() * BLOCK_SIZE);
+}
+
+// Args: oversampling factor, quality; one upsample + downsample round trip
+void BM_OversamplerRoundTrip(benchmark::State& state)
+{
+    Oversampler oversampler(BLOCK_SIZE);
+    oversampler.configure(static_cast<int>(state.range(0)),
+                          static_cast<OversamplingQuality>(state.range(1)));
+    std::vector<float> buffer(BLOCK_SIZE);
+    for (int i = 0; i < BLOCK_SIZE; ++i) {
+        buffer[i] = std::sin(0.05f * static_cast<float>(i));
+    }
+
+    for (auto _ : state) {
+        float* upsampled = oversampler.upsample(buffer.data(), BLOCK_SIZE);
+        oversampler.downsample(upsampled, buffer.data(), BLOCK_SIZE);
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+    setSampleCounters(state, state.iterations() * BLOCK_SIZE);
+}
+
+void oversamplingArgs(benchmark::internal::Benchmark* benchmark)
+{
+    for (int factor : {1, 2, 4, 8}) {
+        for (int quality = 0; quality <= static_cast<int>(OversamplingQuality::HIGH); ++quality) {
+            benchmark->Args({factor, quality});
+        }
+    }
+    benchmark->ArgNames({"factor", "quality"});
+}
+
+// Args: FFT size
+void BM_FFTAnalyzerProcessBuffer(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0));
+    FFTAnalyzer analyzer(size);
+    std::vector<float> buffer(size);
+    Oscillator oscillator(1000.0f, 44100);
+    oscillator.renderBlock(buffer.data(), size);
+
+    for (auto _ : state) {
+        analyzer.processBuffer(buffer);
+        benchmark::ClobberMemory();
+    }
+    setSampleCounters(state, state.iterations() * size);
+}
+
+// Args: FFT size, hop size. Streams one second of audio through the STFT
+void BM_FFTAnalyzerSTFT(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0));
+    const int sampleRate = 44100;
+    FFTAnalyzer analyzer(size);
+    analyzer.setHopSize(static_cast<int>(state.range(1)));
+    analyzer.setAveraging(SpectrumAveraging::EXPONENTIAL);
+    std::vector<float> buffer(sampleRate);
+    Oscillator oscillator(1000.0f, sampleRate);
+    oscillator.renderBlock(buffer.data(), sampleRate);
+
+    int64_t frames = 0;
+    for (auto _ : state) {
+        frames += analyzer.pushSamples(buffer.data(), buffer.size());
+        benchmark::ClobberMemory();
+    }
+    setSampleCounters(state, state.iterations() * sampleRate);
+    state.counters["frames"] = benchmark::Counter(static_cast<double>(frames), benchmark::Counter::kIsRate);
+}
+
+// Args: seconds of recorded audio
+void BM_RecorderExportWAV(benchmark::State& state)
+{
+    const int sampleRate = 44100;
+    const int samples = static_cast<int>(state.range(0)) * sampleRate;
+    Recorder recorder(sampleRate);
+    recorder.startRecording();
+    Oscillator oscillator(440.0f, sampleRate);
+    std::vector<float> audio(samples);
+    for (float& sample : audio) {
+        sample = oscillator.process();
+    }
+    const float* planes[] = {audio.data()};
+    recorder.recordAudio(planes, samples);
+    recorder.stopRecording();
+
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "vsynth_bench_export.wav").string();
+
+    // exportToWAV reports every export on stdout
+    std::streambuf* console = std::cout.rdbuf();
+    std::ostringstream discard;
+    std::cout.rdbuf(discard.rdbuf());
+
+    for (auto _ : state) {
+        recorder.exportToWAV(filename);
+        discard.str("");
+    }
+
+    std::cout.rdbuf(console);
+    std::filesystem::remove(filename);
+
+    setSampleCounters(state, state.iterations() * static_cast<int64_t>(samples));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(samples) * 2);
+}
+
+} // namespace
+
+BENCHMARK(BM_OscillatorProcess)->DenseRange(0, static_cast<int>(WaveformType::BANDLIMITED_TRIANGLE));
+BENCHMARK(BM_OscillatorRenderBlock)->DenseRange(0, static_cast<int>(WaveformType::BANDLIMITED_TRIANGLE));
+BENCHMARK(BM_ADSREnvelopeProcess);
+BENCHMARK(BM_ADSREnvelopeRenderBlock)->DenseRange(0, static_cast<int>(EnvelopeCurve::ANALOG))->ArgName("curve");
+BENCHMARK(BM_DelayEffectProcess);
+BENCHMARK(BM_DelayEffectModes)->DenseRange(0, static_cast<int>(DelayMode::FLANGER))->ArgName("mode");
+BENCHMARK(BM_ReverbEffectProcess);
+BENCHMARK(BM_ReverbEffectProcessStereo);
+BENCHMARK(BM_ConvolutionReverb)->Arg(500)->Arg(2000)->Arg(8000)->ArgName("ir_ms");
+BENCHMARK(BM_SynthesizerProcess)->Apply(synthesizerArgs);
+BENCHMARK(BM_SynthesizerRenderBlock)->Apply(synthesizerArgs);
+BENCHMARK(BM_SynthesizerAutomation)->Arg(16)->Arg(Synthesizer::MAX_VOICES)->ArgName("voices");
+BENCHMARK(BM_SynthesizerFilter)
+    ->ArgsProduct({benchmark::CreateDenseRange(0, static_cast<int>(FilterType::LADDER), 1), {16, 64, 512}})
+    ->ArgNames({"filter", "voices"});
+BENCHMARK(BM_SynthesizerOversampled)->Apply(oversamplingArgs);
+BENCHMARK(BM_OversamplerRoundTrip)->Apply(oversamplingArgs);
+BENCHMARK(BM_FFTAnalyzerProcessBuffer)->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(BM_FFTAnalyzerSTFT)->Args({1024, 256})->Args({4096, 1024})->Args({16384, 4096})
+    ->ArgNames({"size", "hop"})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RecorderExportWAV)->Arg(10)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
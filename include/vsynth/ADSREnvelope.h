@@ -1,6 +1,8 @@
 #ifndef ADSRENVELOPE_H
 #define ADSRENVELOPE_H
 
+#include <cstdint>
+
 enum class EnvelopeState {
     IDLE,
     ATTACK,
@@ -9,29 +11,66 @@ enum class EnvelopeState {
     RELEASE
 };
 
-class ADSREnvelope
+// Shape of the attack, decay and release ramps
+enum class EnvelopeCurve {
+    LINEAR,         // Straight ramps
+    EXPONENTIAL,    // Straight lines in dB over 60 dB: the attack swells, decay and release fall away
+    ANALOG          // RC charge and discharge: the attack bends over, decay and release fall away
+};
+
+// One stage as the recurrence level = level * multiplier + addend, which
+// covers every curve: a multiplier of 1 is a straight line, any other
+// approaches (or leaves) addend / (1 - multiplier) exponentially. powers[j]
+// and sums[j] step UNROLL samples at once from one level:
+// level[n + j + 1] = powers[j] * level[n] + sums[j] * addend.
+struct EnvelopeSegment {
+    static constexpr int UNROLL = 8;
+    
+    float multiplier;
+    float addend;
+    // Samples from the stage's nominal start level to its end level
+    int length;
+    float powers[UNROLL];
+    float sums[UNROLL];
+};
+
+// Envelope settings and the segments derived from them. Envelopes only hold
+// their stage and level and read these through a pointer, so one set of
+// parameters drives any number of voices and changing a setting costs the
+// same however many voices are sounding.
+class ADSRParameters
 {
 public:
-    ADSREnvelope(int sampleRate);
-    ~ADSREnvelope() = default;
-    
-    void trigger();
-    void release();
-    float process();
+    ADSRParameters(int sampleRate);
+    ~ADSRParameters() = default;
     
     void setAttack(float attack);
     void setDecay(float decay);
     void setSustain(float sustain);
     void setRelease(float release);
+    void setCurve(EnvelopeCurve curve);
+    // Sounding envelopes keep their stage and level; only the segments change
+    void setSampleRate(int sampleRate);
     
-    bool isActive() const;
-    EnvelopeState getState() const { return m_state; }
+    float getSustain() const { return m_sustain; }
+    EnvelopeCurve getCurve() const { return m_curve; }
+    int getSampleRate() const { return m_sampleRate; }
+    
+    // Attack from 0 to 1, decay from 1 to the sustain level, and release
+    // from 1 to 0 (a release scales its addend by the level it starts from,
+    // so it lasts the release time from any level)
+    const EnvelopeSegment& attackSegment() const { return m_attackSegment; }
+    const EnvelopeSegment& decaySegment() const { return m_decaySegment; }
+    const EnvelopeSegment& releaseSegment() const { return m_releaseSegment; }
+    
+    // Changes whenever the segments do, so envelopes can retune mid-stage
+    uint32_t version() const { return m_version; }
     
 private:
-    void calculateRates();
+    void calculateSegments();
     
     int m_sampleRate;
-    float m_deltaTime;
+    EnvelopeCurve m_curve;
     
     // ADSR parameters (in seconds)
     float m_attack;
@@ -39,16 +78,55 @@ private:
     float m_sustain;  // Level (0.0 to 1.0)
     float m_release;
     
+    EnvelopeSegment m_attackSegment;
+    EnvelopeSegment m_decaySegment;
+    EnvelopeSegment m_releaseSegment;
+    uint32_t m_version;
+};
+
+class ADSREnvelope
+{
+public:
+    // parameters must outlive the envelope and every copy of it
+    ADSREnvelope(const ADSRParameters* parameters);
+    ~ADSREnvelope() = default;
+    
+    // Attacks from the current level, so a retriggered voice doesn't click
+    void trigger();
+    // Fades to silence over the release time from whatever level it is at
+    void release();
+    void reset();
+    float process();
+    
+    // Render envelope levels for a block. Each stage runs as one
+    // branch-free loop up to its end or the end of the block.
+    void renderBlock(float* out, int frames);
+    
+    bool isActive() const;
+    EnvelopeState getState() const { return m_state; }
+    float getLevel() const { return m_currentLevel; }
+    
+private:
+    // Sets up the segment of state starting from the current level
+    void enterStage(EnvelopeState state);
+    // Recomputes the current stage's addend and length after a parameter change
+    void retune();
+    const EnvelopeSegment& segment() const;
+    float stageTarget() const;
+    // Samples for the recurrence to get from one level to another
+    static int stepsTo(float multiplier, float addend, float from, float to);
+    
+    const ADSRParameters* m_parameters;
+    uint32_t m_version;
+    
     // Internal state
     EnvelopeState m_state;
     float m_currentLevel;
-    float m_targetLevel;
-    float m_rate;
-    
-    // Calculated rates (per sample)
-    float m_attackRate;
-    float m_decayRate;
-    float m_releaseRate;
+    // The current segment's addend (scaled for a release) and samples left
+    float m_addend;
+    int m_remaining;
+    // Level the release started from
+    float m_releaseLevel;
 };
 
 #endif // ADSRENVELOPE_H
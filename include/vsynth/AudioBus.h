@@ -0,0 +1,46 @@
+#ifndef AUDIOBUS_H
+#define AUDIOBUS_H
+
+#include <vector>
+#include "SIMD.h"
+
+// Planar block of audio: one cache-line aligned buffer per channel, so
+// every stage runs plain contiguous loops over each channel and extra
+// channels cost vector work rather than extra per-sample calls.
+// Interleaving only happens at the device or file boundary, through
+// writeInterleaved() and writePlanar(), which also map the bus onto any
+// output channel count: one output channel gets the average of the bus
+// channels, outputs past the bus channels are silent.
+class AudioBus
+{
+public:
+    AudioBus(int channels, int capacity);
+    ~AudioBus() = default;
+
+    int channels() const { return m_channels; }
+    // Longest block, in frames, the bus holds
+    int capacity() const { return m_capacity; }
+
+    float* channel(int index) { return m_data.data() + static_cast<size_t>(index) * m_stride; }
+    const float* channel(int index) const { return m_data.data() + static_cast<size_t>(index) * m_stride; }
+    // Pointers to every channel, for the planar interfaces
+    float* const* planes() { return m_planes.data(); }
+    const float* const* planes() const { return m_planes.data(); }
+
+    void clear(int frames);
+
+    // out holds frames * outputChannels samples
+    void writeInterleaved(float* out, int outputChannels, int frames) const;
+    // out holds outputChannels planes of at least frames samples
+    void writePlanar(float* const* out, int outputChannels, int frames) const;
+
+private:
+    int m_channels;
+    int m_capacity;
+    // Floats between channels, a whole number of cache lines
+    int m_stride;
+    simd::AlignedVector<float> m_data;
+    std::vector<float*> m_planes;
+};
+
+#endif // AUDIOBUS_H
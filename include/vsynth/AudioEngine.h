@@ -4,9 +4,69 @@
 #include <portaudio.h>
 #include <vector>
 #include <memory>
-#include <mutex>
+#include <atomic>
+#include <array>
+#include <string>
 #include "Synthesizer.h"
 #include "Recorder.h"
+#include "StreamingRecorder.h"
+#include "SpectrumTap.h"
+#include "SpectrumAnalysisThread.h"
+#include "SPSCQueue.h"
+#include "CallbackProfiler.h"
+
+enum class CommandType {
+    NOTE_ON,
+    NOTE_OFF,
+    SET_ATTACK,
+    SET_DECAY,
+    SET_SUSTAIN,
+    SET_RELEASE,
+    SET_ENVELOPE_CURVE,
+    SET_WAVEFORM,
+    SET_OSCILLATOR_COUNT,
+    SET_VIBRATO_RATE,
+    SET_VIBRATO_DEPTH,
+    SET_FILTER_TYPE,
+    SET_FILTER_CUTOFF,
+    SET_FILTER_RESONANCE,
+    SET_FILTER_ENVELOPE_AMOUNT,
+    SET_FILTER_KEY_TRACKING,
+    SET_FILTER_ATTACK,
+    SET_FILTER_DECAY,
+    SET_FILTER_SUSTAIN,
+    SET_FILTER_RELEASE,
+    SET_PAN,
+    SET_STEREO_SPREAD,
+    SET_REVERB,
+    SET_DELAY,
+    SET_DELAY_MODE,
+    SET_DELAY_TIME,
+    SET_DELAY_FEEDBACK,
+    SET_DELAY_MOD_RATE,
+    SET_DELAY_MOD_DEPTH,
+    SET_TEMPO,
+    SET_DELAY_SYNC,
+    SET_REVERB_ROOM_SIZE,
+    SET_REVERB_DAMPING,
+    SET_REVERB_WIDTH,
+    SET_CONVOLUTION_MIX,
+    SET_STEAL_POLICY,
+    SET_OVERSAMPLING,
+    START_RECORDING,
+    STOP_RECORDING,
+    START_PLAYBACK,
+    STOP_PLAYBACK
+};
+
+// Message sent from the UI thread to the audio callback
+struct AudioCommand {
+    CommandType type;
+    int intValue;       // Note number, waveform, filter type, oscillator count, oversampling factor
+                        // or recording sequence number
+    float floatValue;   // Velocity or parameter value (oversampling quality index)
+    int sampleOffset;   // Frame (relative to the block that drains it) at which to apply
+};
 
 class AudioEngine
 {
@@ -14,26 +74,66 @@ public:
     AudioEngine();
     ~AudioEngine();
     
-    bool initialize(int sampleRate = 44100, int framesPerBuffer = 256);
+    // maxVoices sets the polyphony; every voice is preallocated here.
+    // renderThreads worker threads help the audio callback render voices
+    // (0 keeps all rendering on the callback thread).
+    // outputChannels is clamped to what the device offers: one channel gets
+    // the mono downmix, channels past the stereo pair are silent. With
+    // interleaved false the device gets one buffer per channel, copied
+    // straight from the planar bus.
+    bool initialize(int sampleRate = 44100, int framesPerBuffer = 256,
+                    int maxVoices = Synthesizer::DEFAULT_VOICES, int renderThreads = 0,
+                    int outputChannels = Synthesizer::CHANNELS, bool interleaved = false);
     void shutdown();
     
     bool start();
     void stop();
     
-    void noteOn(int note, float velocity);
-    void noteOff(int note);
+    // All control methods are meant to be called from a single (UI) thread.
+    // They only enqueue a command; the audio callback applies it.
+    void noteOn(int note, float velocity, int sampleOffset = 0);
+    void noteOff(int note, int sampleOffset = 0);
     
     // Parameter setters
     void setAttack(float attack);
     void setDecay(float decay);
     void setSustain(float sustain);
     void setRelease(float release);
+    void setEnvelopeCurve(EnvelopeCurve curve);
     void setWaveform(int waveform);
     void setOscillatorCount(int count);
     void setVibratoRate(float rate);
     void setVibratoDepth(float depth);
+    void setFilterType(FilterType type);
+    void setFilterCutoff(float cutoff);
+    void setFilterResonance(float resonance);
+    void setFilterEnvelopeAmount(float octaves);
+    void setFilterKeyTracking(float amount);
+    void setFilterAttack(float attack);
+    void setFilterDecay(float decay);
+    void setFilterSustain(float sustain);
+    void setFilterRelease(float release);
+    void setPan(float pan);
+    void setStereoSpread(float spread);
     void setReverb(float reverb);
     void setDelay(float delay);
+    void setDelayMode(DelayMode mode);
+    void setDelayTime(float time);
+    void setDelayFeedback(float feedback);
+    void setDelayModulationRate(float rate);
+    void setDelayModulationDepth(float depth);
+    void setTempo(float bpm);
+    void setDelaySync(float beats);
+    void setReverbRoomSize(float roomSize);
+    void setReverbDamping(float damping);
+    void setReverbWidth(float width);
+    void setConvolutionMix(float mix);
+    // Loads directly rather than through a command: the impulse response is
+    // prepared on a loader thread and handed to the audio thread lock-free
+    void loadImpulseResponse(const std::string& filename);
+    void setStealPolicy(VoiceStealPolicy policy);
+    // factor 1 (off), 2, 4 or 8; see Synthesizer::setOversampling()
+    void setOversampling(int factor, OversamplingQuality quality);
     
     // Recording
     void startRecording();
@@ -42,12 +142,36 @@ public:
     void startPlayback();
     void stopPlayback();
     bool isPlaying() const;
-    void exportToFile(const std::string& filename);
+    // Fails while recording, and waits for a stop the audio thread has not
+    // applied yet; returns false if nothing was exported
+    bool exportToFile(const std::string& filename);
+    
+    // Records the output straight to a WAV file (RF64 past 4 GB) from a disk
+    // writer thread, with constant memory use. Stopping waits for the file to
+    // be complete.
+    bool startStreamingRecording(const std::string& filename);
+    void stopStreamingRecording();
+    bool isStreamingRecording() const;
     
-    // FFT data access
-    std::vector<float> getFFTData();
+    // Spectrum of the output, analyzed off the audio and GUI threads.
+    // Copies the newest one into spectrum; returns false if nothing new.
+    bool getSpectrum(std::vector<float>& spectrum);
+    // Restarts the analysis with new STFT settings (call from the GUI thread)
+    void setSpectrumSettings(const SpectrumSettings& settings);
+    SpectrumSettings getSpectrumSettings() const;
     
     int getSampleRate() const { return m_sampleRate; }
+    int getOutputChannels() const { return m_outputChannels; }
+    
+    // Voice statistics
+    int getMaxVoices() const;
+    int getActiveVoiceCount() const;
+    uint64_t getVoiceStealCount() const;
+    
+    // Callback timing: DSP load, deadline misses, underflows and per-stage
+    // times. Safe from any thread; never blocks the audio callback.
+    ProfilerSnapshot getProfilerSnapshot() const;
+    void resetProfiler();
     
 private:
     static int audioCallback(const void* inputBuffer, void* outputBuffer,
@@ -56,23 +180,64 @@ private:
                            PaStreamCallbackFlags statusFlags,
                            void* userData);
     
-    int processAudio(float* output, unsigned long framesPerBuffer);
+    // output is interleaved, or an array of channel buffers (see initialize)
+    int processAudio(void* output, unsigned long framesPerBuffer);
+    // Plays the recorded events due at the current playback position
+    void playDueEvents();
+    // Renders frames into output starting at frame offset
+    void renderSamples(void* output, unsigned long offset, unsigned long frames);
+    void writeOutput(void* output, unsigned long offset, int frames);
+    void writeSilence(void* output, unsigned long frames);
+    
+    void pushCommand(CommandType type, int intValue, float floatValue, int sampleOffset = 0);
+    void drainCommands();
+    void applyCommand(const AudioCommand& command);
     
     PaStream* m_stream;
     std::unique_ptr<Synthesizer> m_synthesizer;
     std::unique_ptr<Recorder> m_recorder;
+    std::unique_ptr<StreamingRecorder> m_streamingRecorder;
     
     int m_sampleRate;
     int m_framesPerBuffer;
+    int m_outputChannels;
+    bool m_interleaved;
     bool m_isInitialized;
     bool m_isRunning;
     
-    std::mutex m_audioMutex;
+    // UI -> audio thread commands
+    static const size_t COMMAND_QUEUE_SIZE = 1024;
+    // How long an export waits for the audio thread to apply a stop
+    static constexpr int EXPORT_WAIT_MS = 1000;
+    SPSCQueue<AudioCommand, COMMAND_QUEUE_SIZE> m_commandQueue;
+    
+    // Commands drained from the queue, sorted by sampleOffset (audio thread only)
+    std::array<AudioCommand, COMMAND_QUEUE_SIZE> m_pendingCommands;
+    size_t m_pendingCount;
+    
+    // Recorder state mirrored by the audio thread for the UI
+    std::atomic<bool> m_recordingActive;
+    // Recording state last requested by the UI and the sequence number sent
+    // with that start/stop (UI thread only); the audio thread echoes each
+    // number back once it has applied the command
+    bool m_recordingRequested;
+    int m_recordingSequence;
+    std::atomic<int> m_recordingAcknowledged;
+    std::atomic<bool> m_playbackActive;
+    
+    // Audio callback instrumentation (written by the audio thread only)
+    CallbackProfiler m_profiler;
+    
+    // Stereo output of the synthesizer, mapped onto the device channels
+    static constexpr int OUTPUT_BLOCK_SIZE = 1024;
+    AudioBus m_outputBus;
+    std::vector<float*> m_outputPlanes;
     
-    // FFT buffer for analysis
-    std::vector<float> m_fftBuffer;
-    size_t m_fftBufferIndex;
-    static const size_t FFT_SIZE = 1024;
+    // Output history for the spectrum analysis thread (written by the audio
+    // thread), fed the mono downmix
+    SpectrumTap m_spectrumTap;
+    std::vector<float> m_spectrumBuffer;
+    std::unique_ptr<SpectrumAnalysisThread> m_spectrumAnalysis;
 };
 
 #endif // AUDIOENGINE_H
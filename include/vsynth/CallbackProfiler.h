@@ -0,0 +1,132 @@
+#ifndef CALLBACKPROFILER_H
+#define CALLBACKPROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Processing stages timed inside one audio callback
+enum class ProfilerStage {
+    EVENTS = 0,     // Command queue and playback events
+    VOICES,         // Vibrato and voice rendering
+    EFFECTS,        // Delay and reverb
+    RECORDER,       // Audio recording
+    FFT_TAP,        // Copy into the analysis buffer
+    COUNT
+};
+
+// Copy of the profiler statistics, taken from any thread
+struct ProfilerSnapshot {
+    static constexpr int STAGE_COUNT = static_cast<int>(ProfilerStage::COUNT);
+    // Load histogram: 5% bins from 0 to 100%, the last bin is >= 100% (deadline missed)
+    static constexpr int LOAD_BINS = 21;
+    // Callback duration histogram: bin i counts durations in [2^i, 2^(i+1)) microseconds
+    static constexpr int DURATION_BINS = 16;
+
+    uint64_t callbacks = 0;
+    uint64_t underflows = 0;          // Output underflows reported by the audio driver
+    uint64_t deadlineMisses = 0;      // Callbacks that took longer than their buffer period
+
+    float lastLoad = 0.0f;            // Render time / buffer period of the last callback
+    float averageLoad = 0.0f;         // Smoothed over roughly the last second
+    float peakLoad = 0.0f;
+
+    double worstCallbackMicros = 0.0;
+    double worstIntervalMicros = 0.0; // Longest gap between two callback starts
+
+    std::array<double, STAGE_COUNT> stageAverageMicros{};
+    std::array<double, STAGE_COUNT> stageWorstMicros{};
+
+    std::array<uint64_t, LOAD_BINS> loadHistogram{};
+    std::array<uint64_t, DURATION_BINS> durationHistogram{};
+};
+
+// Audio callback instrumentation. The audio thread is the only writer and
+// every statistic is a relaxed atomic, so readers never block it; a snapshot
+// may mix values from two consecutive callbacks.
+class CallbackProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CallbackProfiler();
+    ~CallbackProfiler() = default;
+
+    void setSampleRate(int sampleRate) { m_sampleRate = sampleRate; }
+
+    // Audio thread
+    void beginCallback(unsigned long frames);
+    void addStageTime(ProfilerStage stage, Clock::duration time);
+    void endCallback(bool outputUnderflow);
+
+    // Any thread
+    ProfilerSnapshot snapshot() const;
+    // Clears the statistics at the start of the next callback
+    void reset() { m_resetRequested.store(true, std::memory_order_relaxed); }
+
+    // Times the enclosing scope into a stage
+    class ScopedStage
+    {
+    public:
+        ScopedStage(CallbackProfiler* profiler, ProfilerStage stage)
+            : m_profiler(profiler)
+            , m_stage(stage)
+            , m_start(profiler ? Clock::now() : Clock::time_point())
+        {
+        }
+        ~ScopedStage()
+        {
+            if (m_profiler) {
+                m_profiler->addStageTime(m_stage, Clock::now() - m_start);
+            }
+        }
+
+    private:
+        CallbackProfiler* m_profiler;
+        ProfilerStage m_stage;
+        Clock::time_point m_start;
+    };
+
+private:
+    void clear();
+
+    // Single writer, so a plain load/store is enough and avoids locked instructions
+    static void increment(std::atomic<uint64_t>& target)
+    {
+        target.store(target.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    static void storeMax(std::atomic<uint64_t>& target, uint64_t value)
+    {
+        if (value > target.load(std::memory_order_relaxed)) {
+            target.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr int STAGE_COUNT = ProfilerSnapshot::STAGE_COUNT;
+
+    int m_sampleRate;
+    std::atomic<bool> m_resetRequested;
+
+    // Current callback (audio thread only)
+    Clock::time_point m_callbackStart;
+    Clock::time_point m_previousStart;
+    unsigned long m_frames;
+    std::array<uint64_t, STAGE_COUNT> m_stageNanos;
+
+    // Published statistics
+    std::atomic<uint64_t> m_callbacks;
+    std::atomic<uint64_t> m_underflows;
+    std::atomic<uint64_t> m_deadlineMisses;
+    std::atomic<float> m_lastLoad;
+    std::atomic<float> m_averageLoad;
+    std::atomic<float> m_peakLoad;
+    std::atomic<uint64_t> m_worstCallbackNanos;
+    std::atomic<uint64_t> m_worstIntervalNanos;
+    std::array<std::atomic<uint64_t>, STAGE_COUNT> m_stageTotalNanos;
+    std::array<std::atomic<uint64_t>, STAGE_COUNT> m_stageWorstNanos;
+    std::array<std::atomic<uint64_t>, ProfilerSnapshot::LOAD_BINS> m_loadHistogram;
+    std::array<std::atomic<uint64_t>, ProfilerSnapshot::DURATION_BINS> m_durationHistogram;
+};
+
+#endif // CALLBACKPROFILER_H
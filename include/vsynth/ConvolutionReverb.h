@@ -0,0 +1,142 @@
+#ifndef CONVOLUTIONREVERB_H
+#define CONVOLUTIONREVERB_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fftw3.h>
+#include "SIMD.h"
+
+// Convolution with a recorded impulse response (IR), without latency.
+// The IR is split non-uniformly: its first HEAD_LENGTH taps are applied
+// directly in the time domain, the rest by uniformly partitioned FFT
+// convolution (overlap-save with a frequency-domain delay line) in
+// segments whose partitions grow PARTITION_GROWTH times per segment up to
+// MAX_PARTITION_SIZE. Each segment starts late enough that its spectrum
+// multiplies can be spread over the HEAD_LENGTH blocks of one of its
+// partitions, so the work per block stays small and even while the cost
+// per sample grows only with the log of the IR length.
+//
+// Loading, resampling and transforming the IR run on a background thread;
+// the audio thread picks the finished IR up lock-free at its next block.
+class ConvolutionReverb
+{
+public:
+    static constexpr int HEAD_LENGTH = 128;
+    static constexpr int PARTITION_GROWTH = 8;
+    static constexpr int MAX_PARTITION_SIZE = 8192;
+    // Longer IRs are truncated
+    static constexpr int MAX_IR_SECONDS = 20;
+
+    ConvolutionReverb(int sampleRate);
+    ~ConvolutionReverb();
+
+    ConvolutionReverb(const ConvolutionReverb&) = delete;
+    ConvolutionReverb& operator=(const ConvolutionReverb&) = delete;
+
+    // Starts loading an IR WAV file (mixed to mono, resampled to the
+    // sample rate, normalized to unit energy) in the background. A load
+    // already running is finished first. Not for the audio thread.
+    void loadImpulseResponse(const std::string& filename);
+    void loadImpulseResponse(std::vector<float> samples, int sampleRate);
+    // Waits for the current load; true if it produced an IR
+    bool waitForLoad();
+    bool isLoading() const { return m_loading.load(std::memory_order_acquire); }
+
+    // Audio thread. Passes the input through until an IR is loaded.
+    float process(float input);
+    void processBlock(float* buffer, int frames);
+    // Stereo in place: the IR is mono, so the mid signal is convolved and
+    // the reverb added to both channels
+    void processStereo(float* left, float* right, int frames);
+
+    void setMix(float mix);
+
+private:
+    // One uniformly partitioned part of the IR: partitions of blockSize
+    // taps, transformed at twice that size
+    struct Segment {
+        Segment(int blockSize, int partitions);
+        ~Segment();
+
+        int blockSize;
+        int partitions;
+        // Floats per spectrum (blockSize + 1 interleaved bins, padded to a cache line)
+        int stride;
+        // HEAD_LENGTH blocks per partition, the multiply work is spread over them
+        int phases;
+
+        // Partition spectra of the IR, pre-scaled by the inverse FFT size
+        simd::AlignedVector<float> filters;
+        // Ring of the last partitions input spectra, newest at newestSpectrum
+        simd::AlignedVector<float> spectra;
+        int newestSpectrum;
+        // Previous and current input block, the overlap-save FFT frame
+        simd::AlignedVector<float> input;
+        int inputFill;
+        simd::AlignedVector<float> accumulator;
+        simd::AlignedVector<float> inverse;
+        // The block being played and the one being computed
+        simd::AlignedVector<float> output;
+        simd::AlignedVector<float> nextOutput;
+        int outputPosition;
+        // Next multiply slice, phases when idle
+        int phase;
+
+        fftwf_plan forwardPlan;
+        fftwf_plan inversePlan;
+    };
+
+    // A prepared IR together with its convolution state
+    struct Kernel {
+        simd::AlignedVector<float> head;     // First HEAD_LENGTH taps, reversed
+        std::vector<std::unique_ptr<Segment>> segments;
+    };
+
+    // acc[i] += a[i] * b[i] over count interleaved complex values
+    using MultiplyKernel = void (*)(const float* a, const float* b, float* acc, int count);
+    // out[i] = sum over t < HEAD_LENGTH of taps[t] * in[i + t]
+    using HeadKernel = void (*)(const float* in, const float* taps, float* out, int count);
+
+    static void multiplyAccumulateScalar(const float* a, const float* b, float* acc, int count);
+    static void headScalar(const float* in, const float* taps, float* out, int count);
+#ifdef VSYNTH_X86
+    static void multiplyAccumulateAVX2(const float* a, const float* b, float* acc, int count);
+    static void headAVX2(const float* in, const float* taps, float* out, int count);
+#endif
+
+    // Loader thread
+    void prepare(std::vector<float> samples, int sampleRate);
+    Kernel* buildKernel(const std::vector<float>& ir);
+    void publish(Kernel* kernel);
+    void reclaimRetired();
+
+    // Audio thread: processBlock() with right == nullptr, else processStereo()
+    void render(float* left, float* right, int frames);
+    // Audio thread: called after every full HEAD_LENGTH input block
+    void advanceSegment(Segment& segment, const float* block);
+
+    int m_sampleRate;
+    float m_mix;
+    MultiplyKernel m_multiplyKernel;
+    HeadKernel m_headKernel;
+
+    // Owned by the audio thread
+    Kernel* m_kernel;
+    // Loader to audio thread, and the replaced IR back for deletion
+    std::atomic<Kernel*> m_pending;
+    std::atomic<Kernel*> m_retired;
+
+    // The last HEAD_LENGTH - 1 inputs, then the block being filled
+    simd::AlignedVector<float> m_history;
+    int m_blockFill;
+    simd::AlignedVector<float> m_wet;
+
+    std::thread m_loader;
+    std::atomic<bool> m_loading;
+    std::atomic<bool> m_loadSucceeded;
+};
+
+#endif // CONVOLUTIONREVERB_H
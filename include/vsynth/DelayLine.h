@@ -0,0 +1,71 @@
+#ifndef DELAYLINE_H
+#define DELAYLINE_H
+
+#include <cstdint>
+#include <vector>
+
+// Circular sample buffer with integer and fractional (third-order Lagrange)
+// reads. The buffer is a power of two long, so wrapping is a mask.
+// Read before writing: delay 1 is the last sample written.
+class DelayLine
+{
+public:
+    // Longest delay, in samples, that readLagrange() accepts
+    DelayLine(int maxDelay);
+    ~DelayLine() = default;
+
+    void clear();
+    int maxDelay() const { return m_maxDelay; }
+
+    void write(float sample)
+    {
+        m_buffer[m_writePosition & m_mask] = sample;
+        ++m_writePosition;
+    }
+
+    float read(int delay) const
+    {
+        return m_buffer[(m_writePosition - static_cast<uint32_t>(delay)) & m_mask];
+    }
+
+    // Weights of the samples at delays -1, 0, +1 and +2 around the integer
+    // part of a delay, for its fraction in [0, 1). Several lines read at the
+    // same delay can share them.
+    static void lagrangeCoefficients(float fraction, float* coefficients)
+    {
+        const float plus1 = fraction + 1.0f;
+        const float minus1 = fraction - 1.0f;
+        const float minus2 = fraction - 2.0f;
+        coefficients[0] = -fraction * minus1 * minus2 * (1.0f / 6.0f);
+        coefficients[1] = plus1 * minus1 * minus2 * 0.5f;
+        coefficients[2] = -plus1 * fraction * minus2 * 0.5f;
+        coefficients[3] = plus1 * fraction * minus1 * (1.0f / 6.0f);
+    }
+
+    // delay is the integer part, at least 2
+    float readInterpolated(int delay, const float* coefficients) const
+    {
+        const uint32_t position = m_writePosition - static_cast<uint32_t>(delay);
+        return coefficients[0] * m_buffer[(position + 1) & m_mask]
+             + coefficients[1] * m_buffer[position & m_mask]
+             + coefficients[2] * m_buffer[(position - 1) & m_mask]
+             + coefficients[3] * m_buffer[(position - 2) & m_mask];
+    }
+
+    // delay in [2, maxDelay()]
+    float readLagrange(float delay) const
+    {
+        const int whole = static_cast<int>(delay);
+        float coefficients[4];
+        lagrangeCoefficients(delay - static_cast<float>(whole), coefficients);
+        return readInterpolated(whole, coefficients);
+    }
+
+private:
+    std::vector<float> m_buffer;
+    uint32_t m_mask;
+    uint32_t m_writePosition;
+    int m_maxDelay;
+};
+
+#endif // DELAYLINE_H
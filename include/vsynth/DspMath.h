@@ -0,0 +1,12 @@
+#ifndef DSPMATH_H
+#define DSPMATH_H
+
+// Math helpers shared by the filter and window designs
+namespace dsp {
+
+// Zeroth-order modified Bessel function of the first kind (Kaiser window)
+double besselI0(double x);
+
+} // namespace dsp
+
+#endif // DSPMATH_H
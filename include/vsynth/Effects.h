@@ -3,56 +3,206 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <string>
+#include "SIMD.h"
+#include "DelayLine.h"
+#include "ConvolutionReverb.h"
 
+// Routing of the delay lines
+enum class DelayMode {
+    ECHO = 0,       // A feedback echo per channel
+    PING_PONG,      // Echoes alternate between left and right
+    CHORUS,         // Short delays swept in quadrature, no feedback
+    FLANGER         // Very short swept delays with feedback
+};
+
+// How fractional delays are read
+enum class DelayInterpolation {
+    LAGRANGE = 0,   // Third order; follows modulation sample by sample
+    ALLPASS         // Flat magnitude for fixed echoes; glides are less clean
+};
+
+// Stereo delay built on two DelayLines. The delay time glides to new
+// settings (one-pole, about SMOOTHING_TIME) and is read with fractional
+// interpolation, so time changes and modulation don't click. The echo
+// time can follow a tempo. CHORUS and FLANGER sweep the lines with a
+// quadrature LFO (a rotating phasor: no per-sample sin or division).
 class DelayEffect
 {
 public:
-    DelayEffect(int sampleRate, float maxDelayTime = 1.0f);
+    static constexpr float SMOOTHING_TIME = 0.05f;
+    
+    DelayEffect(int sampleRate, float maxDelayTime = 2.0f);
     ~DelayEffect() = default;
     
     float process(float input);
+    // Mono in and out (the two channels are averaged)
+    void processBlock(float* buffer, int frames);
+    // Stereo in place
+    void processStereo(float* left, float* right, int frames);
+    
+    void setMode(DelayMode mode);
+    void setInterpolation(DelayInterpolation interpolation);
+    // Echo time in seconds (ECHO and PING_PONG) unless synced to the tempo
     void setDelayTime(float delayTime);
+    // Ignored in CHORUS mode
     void setFeedback(float feedback);
     void setMix(float mix);
+    // LFO rate in Hz and sweep depth 0-1 for CHORUS and FLANGER
+    void setModulationRate(float rate);
+    void setModulationDepth(float depth);
+    // With beats > 0 the echo time is beats quarter notes at tempo bpm
+    void setTempo(float bpm);
+    void setSyncBeats(float beats);
+    void clear();
+    
+    DelayMode getMode() const { return m_mode; }
     
 private:
-    std::vector<float> m_delayBuffer;
-    int m_bufferSize;
-    int m_writeIndex;
-    int m_readIndex;
+    static constexpr int MAX_BLOCK_SIZE = 256;
+    
+    // Recomputes the delay (and sweep) the smoothing heads for
+    void updateTargets();
+    // Stores the glided delay at the end of a block
+    void settleDelay(double delay);
+    void updateEchoWeights();
+    // ECHO and PING_PONG; without Stereo only the left line runs (mono ECHO)
+    template <bool Stereo>
+    void renderEcho(float* left, float* right, int frames);
+    template <bool Stereo>
+    void renderAllpass(float* left, float* right, int frames);
+    // CHORUS and FLANGER
+    void renderModulated(float* left, float* right, int frames);
+    
+    int m_sampleRate;
+    DelayMode m_mode;
+    DelayInterpolation m_interpolation;
     float m_delayTime;
     float m_feedback;
     float m_mix;
-    int m_sampleRate;
+    float m_modulationRate;
+    float m_modulationDepth;
+    float m_tempo;
+    float m_syncBeats;
+    
+    DelayLine m_left;
+    DelayLine m_right;
+    
+    // Delay and LFO sweep in samples: targets and their smoothed values.
+    // The delay glides in double precision: in float a one-pole step
+    // rounds to nothing samples short of a long target.
+    double m_targetDelay;
+    float m_targetSweep;
+    double m_delay;
+    float m_sweep;
+    double m_smoothing;
+    // Echo read weights for the current delay, refreshed while it glides
+    int m_echoWhole;
+    float m_echoCoefficients[4];
+    
+    // Quadrature LFO: sin/cos of the phase, rotated by the per-sample step
+    float m_lfoSin;
+    float m_lfoCos;
+    float m_lfoStepSin;
+    float m_lfoStepCos;
+    
+    // Allpass interpolation: the delay it is tuned to, its integer part,
+    // coefficient and last outputs
+    double m_allpassTuning;
+    int m_allpassDelay;
+    float m_allpassCoefficient;
+    float m_allpassLeft;
+    float m_allpassRight;
+    
+    std::vector<float> m_scratch;
 };
 
+// Freeverb-style stereo reverb: NUM_COMBS damped comb filters in parallel
+// followed by NUM_ALLPASS allpasses in series, per channel. The right
+// channel's lines are slightly longer so the channels decorrelate.
+// Every delay line lives in one arena and is power-of-two sized, so
+// wrapping is a mask. The combs of both channels are interleaved: row t of
+// the comb area holds sample t of all 2 * NUM_COMBS combs, one comb per
+// SIMD lane: the AVX2 kernel reads all comb taps with two gathers and
+// writes a row with two stores, the SSE2 kernel with four of each (its
+// taps are loaded lane by lane).
 class ReverbEffect
 {
 public:
+    static constexpr int NUM_COMBS = 8;
+    static constexpr int NUM_ALLPASS = 4;
+    
     ReverbEffect(int sampleRate);
     ~ReverbEffect() = default;
     
     float process(float input);
+    // Mono in and out (the two reverb channels are summed)
+    void processBlock(float* buffer, int frames);
+    // Mono in, stereo out: dry input plus the reverb spread by the width
+    void processStereo(const float* input, float* left, float* right, int frames);
+    // Stereo in place; like Freeverb the reverb is fed the sum of the channels
+    void processStereo(float* left, float* right, int frames);
+    
     void setRoomSize(float roomSize);
     void setDamping(float damping);
+    // 0 folds both reverb channels to the centre, 1 keeps them fully apart
+    void setWidth(float width);
     void setMix(float mix);
+    void clear();
     
 private:
-    // Simple Schroeder reverb implementation
-    std::vector<std::vector<float>> m_combBuffers;
-    std::vector<std::vector<float>> m_allpassBuffers;
-    std::vector<int> m_combIndices;
-    std::vector<int> m_allpassIndices;
-    std::vector<float> m_combFeedback;
-    std::vector<float> m_allpassFeedback;
+    static constexpr int COMB_LANES = 2 * NUM_COMBS;
+    // Longest block the scratch buffers of processBlock() hold
+    static constexpr int MAX_BLOCK_SIZE = 256;
     
+    // Runs the combs of both channels over a block, writing their sums
+    using CombKernel = void (*)(ReverbEffect& reverb, const float* input,
+                                float* left, float* right, int frames);
+    static void combsScalar(ReverbEffect& reverb, const float* input,
+                            float* left, float* right, int frames);
+#ifdef VSYNTH_X86
+    static void combsSSE2(ReverbEffect& reverb, const float* input,
+                          float* left, float* right, int frames);
+    static void combsAVX2(ReverbEffect& reverb, const float* input,
+                          float* left, float* right, int frames);
+#endif
+    // Reverb of frames (at most MAX_BLOCK_SIZE) input samples into m_left/m_right
+    void renderWet(const float* input, int frames);
+    void allpasses(float* samples, int channel, int frames);
+    
+    int m_sampleRate;
     float m_roomSize;
     float m_damping;
+    float m_width;
     float m_mix;
-    int m_sampleRate;
     
-    static const int NUM_COMBS = 4;
-    static const int NUM_ALLPASS = 2;
+    // Derived from room size and damping
+    float m_feedback;
+    float m_damp1;
+    float m_damp2;
+    
+    CombKernel m_combKernel;
+    
+    // Comb rows first, then 2 * NUM_ALLPASS allpass lines
+    simd::AlignedVector<float> m_arena;
+    int m_combMask;
+    int m_allpassOffset;
+    int m_allpassLength;
+    int m_allpassMask;
+    // Write position shared by every line (wraps freely, lines are masked)
+    uint32_t m_position;
+    
+    // Lane order: left combs, then right combs
+    alignas(32) int32_t m_combDelays[COMB_LANES];
+    // Per-instance damping low-pass state, one per comb
+    alignas(32) float m_combFilters[COMB_LANES];
+    int m_allpassDelays[2 * NUM_ALLPASS];
+    
+    std::vector<float> m_left;
+    std::vector<float> m_right;
+    // Mid of a stereo input
+    std::vector<float> m_input;
 };
 
 class Effects
@@ -62,15 +212,34 @@ public:
     ~Effects() = default;
     
     float process(float input);
+    void processBlock(float* buffer, int frames);
+    // Stereo in place: the delay, reverb and convolution all run in stereo
+    void processStereo(float* left, float* right, int frames);
     
     void setReverbAmount(float amount);
     void setDelayAmount(float amount);
     void setDelayTime(float time);
     void setDelayFeedback(float feedback);
+    void setDelayMode(DelayMode mode);
+    void setDelayInterpolation(DelayInterpolation interpolation);
+    void setDelayModulationRate(float rate);
+    void setDelayModulationDepth(float depth);
+    // Tempo in bpm and echo length in beats (0 = free time)
+    void setTempo(float bpm);
+    void setDelaySync(float beats);
+    void setReverbRoomSize(float roomSize);
+    void setReverbDamping(float damping);
+    void setReverbWidth(float width);
+    
+    // Loads in the background; see ConvolutionReverb
+    void loadImpulseResponse(const std::string& filename);
+    bool waitForImpulseResponse();
+    void setConvolutionMix(float mix);
     
 private:
     std::unique_ptr<DelayEffect> m_delay;
     std::unique_ptr<ReverbEffect> m_reverb;
+    std::unique_ptr<ConvolutionReverb> m_convolution;
     int m_sampleRate;
 };
 
@@ -3,42 +3,128 @@
 
 #include <vector>
 #include <complex>
+#include <string>
+#include <mutex>
 #include <fftw3.h>
+#include "SIMD.h"
+
+enum class WindowType {
+    HANN = 0,
+    BLACKMAN_HARRIS,    // 4-term, -92 dB sidelobes
+    FLAT_TOP,           // Accurate peak amplitudes, wide main lobe
+    KAISER              // Adjustable with beta
+};
+
+enum class SpectrumAveraging {
+    NONE = 0,
+    EXPONENTIAL,        // Smoothed power: amount is the weight of the previous average
+    PEAK_HOLD           // Held peaks: amount is the power kept per frame
+};
 
 class FFTAnalyzer
 {
 public:
+    static constexpr int MIN_FFT_SIZE = 256;
+    static constexpr int MAX_FFT_SIZE = 16384;
+
+    // fftSize is rounded up to a power of two in [MIN_FFT_SIZE, MAX_FFT_SIZE].
+    // Plans are made with FFTW_MEASURE; import wisdom first to make that instant.
     FFTAnalyzer(int fftSize = 1024);
     ~FFTAnalyzer();
     
+    FFTAnalyzer(const FFTAnalyzer&) = delete;
+    FFTAnalyzer& operator=(const FFTAnalyzer&) = delete;
+    
+    // Analyzes the last fftSize samples of audioBuffer (zero-padded if shorter)
     void processBuffer(const std::vector<float>& audioBuffer);
-    std::vector<float> getMagnitudeSpectrum();
+    
+    // Streaming STFT: a frame is analyzed every hop samples once fftSize
+    // samples have arrived. Returns the number of frames analyzed.
+    int pushSamples(const float* samples, size_t count);
+    void setHopSize(int hopSize);
+    int getHopSize() const { return m_hopSize; }
+    // Forgets streamed samples and the running average
+    void resetStream();
+    
+    // Normalized 0-1 over the 60 dB below the peak, fftSize / 2 + 1 bins
+    const std::vector<float>& getMagnitudeSpectrum() const { return m_magnitudeSpectrum; }
     std::vector<float> getBinFrequencies(int sampleRate);
     
+    // The spectrum in numBands log-spaced bands across the band range, each the
+    // summed power of all its bins, normalized like getMagnitudeSpectrum()
+    const std::vector<float>& getBandSpectrum(int numBands);
+    // Frequency range of the bands (clamped to Nyquist); 20 Hz to 20 kHz at 44.1 kHz by default
+    void setBandRange(int sampleRate, float minFrequency = 20.0f, float maxFrequency = 20000.0f);
+    
     void setWindowFunction(bool useWindow = true);
+    void setWindowType(WindowType type, float kaiserBeta = 9.0f);
+    WindowType getWindowType() const { return m_windowType; }
+    void setAveraging(SpectrumAveraging mode, float amount = 0.5f);
     
     int getFFTSize() const { return m_fftSize; }
     
+    // FFTW wisdom cache, shared by every analyzer in the process
+    static bool importWisdom(const std::string& filename);
+    static bool exportWisdom(const std::string& filename);
+    
+    // The FFTW planner is not thread-safe; every FFTW user in the process
+    // makes and destroys its plans under this
+    static std::mutex& plannerMutex();
+    
 private:
-    void applyWindow();
-    void computeFFT();
+    void buildWindow();
+    void analyzeFrame();
+    void buildBandMap(int numBands);
+    
+    // Runtime-dispatched spectrum kernels (AVX2 or scalar, chosen from simd::detect())
+    using PowerKernel = void (*)(const fftwf_complex* bins, float* averagePower, int count, float scale,
+                                 float newWeight, float keepWeight, float holdWeight);
+    using DecibelKernel = float (*)(const float* power, float* decibels, int count);
+    using NormalizeKernel = void (*)(float* values, int count, float floor, float inverseRange);
     
     int m_fftSize;
+    int m_hopSize;
     bool m_useWindow;
+    WindowType m_windowType;
+    float m_kaiserBeta;
+    SpectrumAveraging m_averaging;
+    float m_averagingAmount;
     
     // FFTW data
     float* m_inputBuffer;
     fftwf_complex* m_outputBuffer;
     fftwf_plan m_plan;
     
-    // Window function
+    // Window function and the scale that makes a full-scale sine read 1.0
     std::vector<float> m_window;
+    float m_windowScale;
+    
+    // Streaming input history (ring of fftSize samples)
+    std::vector<float> m_history;
+    size_t m_historyIndex;
+    size_t m_samplesUntilFrame;
     
     // Results
+    std::vector<float> m_averagePower;
+    bool m_hasAverage;
     std::vector<float> m_magnitudeSpectrum;
     
+    // Log-frequency band map: band b sums bins [m_bandFirstBin[b], m_bandEndBin[b])
+    int m_bandSampleRate;
+    float m_bandMinFrequency;
+    float m_bandMaxFrequency;
+    std::vector<int> m_bandFirstBin;
+    std::vector<int> m_bandEndBin;
+    std::vector<float> m_bandPower;
+    std::vector<float> m_bandSpectrum;
+    
+    PowerKernel m_powerKernel;
+    DecibelKernel m_decibelKernel;
+    NormalizeKernel m_normalizeKernel;
+    
     // Constants
     static constexpr float PI = 3.14159265359f;
+    static constexpr float DISPLAY_RANGE_DB = 60.0f;
 };
 
 #endif // FFTANALYZER_H
@@ -15,7 +15,7 @@
 #include <QTimer>
 #include "AudioEngine.h"
 #include "KeyboardWidget.h"
-#include "FFTAnalyzer.h"
+#include "SpectrumWidget.h"
 
 class MainWindow : public QMainWindow
 {
@@ -30,23 +30,51 @@ private slots:
     void onDecayChanged(int value);
     void onSustainChanged(int value);
     void onReleaseChanged(int value);
+    void onEnvelopeCurveChanged(int index);
     void onWaveformChanged(int index);
     void onOscillatorCountChanged(int count);
+    void onOversamplingChanged();
     void onVibratoRateChanged(int value);
     void onVibratoDepthChanged(int value);
+    void onFilterTypeChanged(int index);
+    void onFilterCutoffChanged(int value);
+    void onFilterResonanceChanged(int value);
+    void onFilterEnvelopeAmountChanged(int value);
+    void onFilterKeyTrackingChanged(int value);
+    void onFilterAttackChanged(int value);
+    void onFilterDecayChanged(int value);
+    void onFilterSustainChanged(int value);
+    void onFilterReleaseChanged(int value);
+    void onPanChanged(int value);
+    void onStereoSpreadChanged(int value);
     void onReverbChanged(int value);
     void onDelayChanged(int value);
+    void onDelayModeChanged(int index);
+    void onDelayTimeChanged(int value);
+    void onDelayFeedbackChanged(int value);
+    void onDelaySyncChanged();
+    void onDelayModulationRateChanged(int value);
+    void onDelayModulationDepthChanged(int value);
+    void onRoomSizeChanged(int value);
+    void onDampingChanged(int value);
+    void onConvolutionChanged(int value);
+    void onLoadImpulseResponseClicked();
     void onRecordToggled();
     void onPlayToggled();
     void onExportClicked();
+    void onDiskRecordToggled();
+    void onSpectrumSettingsChanged();
     void updateFFTDisplay();
+    void updatePerformanceMeter();
 
 private:
     void setupUI();
     void setupADSRControls(QGroupBox* parent);
     void setupOscillatorControls(QGroupBox* parent);
+    void setupFilterControls(QGroupBox* parent);
     void setupEffectsControls(QGroupBox* parent);
     void setupRecordingControls(QGroupBox* parent);
+    void setupPerformanceMeter(QGroupBox* parent);
 
     // UI Components
     QWidget* m_centralWidget;
@@ -57,9 +85,11 @@ private:
     // Control groups
     QGroupBox* m_adsrGroup;
     QGroupBox* m_oscillatorGroup;
+    QGroupBox* m_filterGroup;
     QGroupBox* m_effectsGroup;
     QGroupBox* m_recordingGroup;
     QGroupBox* m_fftGroup;
+    QGroupBox* m_performanceGroup;
     
     // ADSR controls
     QSlider* m_attackSlider;
@@ -70,6 +100,7 @@ private:
     QLabel* m_decayLabel;
     QLabel* m_sustainLabel;
     QLabel* m_releaseLabel;
+    QComboBox* m_envelopeCurveCombo;
     
     // Oscillator controls
     QComboBox* m_waveformCombo;
@@ -78,26 +109,82 @@ private:
     QSlider* m_vibratoDepthSlider;
     QLabel* m_vibratoRateLabel;
     QLabel* m_vibratoDepthLabel;
+    QSlider* m_panSlider;
+    QSlider* m_spreadSlider;
+    QLabel* m_panLabel;
+    QLabel* m_spreadLabel;
+    QComboBox* m_oversamplingCombo;
+    QComboBox* m_oversamplingQualityCombo;
+    
+    // Filter controls
+    QComboBox* m_filterTypeCombo;
+    QSlider* m_filterCutoffSlider;
+    QSlider* m_filterResonanceSlider;
+    QSlider* m_filterEnvelopeSlider;
+    QSlider* m_filterKeyTrackingSlider;
+    QLabel* m_filterCutoffLabel;
+    QLabel* m_filterResonanceLabel;
+    QLabel* m_filterEnvelopeLabel;
+    QLabel* m_filterKeyTrackingLabel;
+    QSlider* m_filterAttackSlider;
+    QSlider* m_filterDecaySlider;
+    QSlider* m_filterSustainSlider;
+    QSlider* m_filterReleaseSlider;
+    QLabel* m_filterAttackLabel;
+    QLabel* m_filterDecayLabel;
+    QLabel* m_filterSustainLabel;
+    QLabel* m_filterReleaseLabel;
     
     // Effects controls
     QSlider* m_reverbSlider;
     QSlider* m_delaySlider;
     QLabel* m_reverbLabel;
     QLabel* m_delayLabel;
+    QSlider* m_roomSizeSlider;
+    QSlider* m_dampingSlider;
+    QLabel* m_roomSizeLabel;
+    QLabel* m_dampingLabel;
+    QSlider* m_convolutionSlider;
+    QLabel* m_convolutionLabel;
+    QPushButton* m_impulseResponseButton;
+    QLabel* m_impulseResponseLabel;
+    QComboBox* m_delayModeCombo;
+    QSlider* m_delayTimeSlider;
+    QSlider* m_delayFeedbackSlider;
+    QLabel* m_delayTimeLabel;
+    QLabel* m_delayFeedbackLabel;
+    QComboBox* m_delaySyncCombo;
+    QSpinBox* m_tempoSpin;
+    QSlider* m_delayModRateSlider;
+    QSlider* m_delayModDepthSlider;
+    QLabel* m_delayModRateLabel;
+    QLabel* m_delayModDepthLabel;
     
     // Recording controls
     QPushButton* m_recordButton;
     QPushButton* m_playButton;
     QPushButton* m_exportButton;
+    QPushButton* m_diskRecordButton;
+    
+    // Performance meter
+    QProgressBar* m_loadMeter;
+    QLabel* m_performanceLabel;
+    QPushButton* m_resetMeterButton;
     
     // Keyboard and visualization
     KeyboardWidget* m_keyboard;
-    QProgressBar* m_fftDisplay[32]; // Simple FFT visualization
+    static constexpr int SPECTRUM_BANDS = 192;
+    SpectrumWidget* m_spectrumWidget;
+    QComboBox* m_spectrumViewCombo;
+    QComboBox* m_fftSizeCombo;
+    QComboBox* m_fftWindowCombo;
+    QComboBox* m_fftAveragingCombo;
     
     // Core components
     AudioEngine* m_audioEngine;
-    FFTAnalyzer* m_fftAnalyzer;
+    std::vector<float> m_spectrum;
     QTimer* m_fftTimer;
+    QTimer* m_meterTimer;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,61 @@
+#ifndef OFFLINERENDERER_H
+#define OFFLINERENDERER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "Synthesizer.h"
+#include "Recorder.h"
+#include "WavWriter.h"
+
+// Renders a note event list through Synthesizer (and its effects) without an
+// audio device, in large blocks and as fast as the CPU allows.
+// Events land on their exact sample: blocks are split at event positions.
+class OfflineRenderer
+{
+public:
+    static constexpr int DEFAULT_BLOCK_SIZE = 4096;
+
+    OfflineRenderer(int sampleRate = 44100, int maxVoices = Synthesizer::DEFAULT_VOICES,
+                    int renderThreads = 0);
+    ~OfflineRenderer() = default;
+
+    // Configure sound parameters here before rendering
+    Synthesizer& synthesizer() { return *m_synthesizer; }
+    int getSampleRate() const { return m_sampleRate; }
+
+    void setBlockSize(int frames);
+    // Channels written out: 2 (default) for the stereo output, 1 for its
+    // mono downmix, more for stereo followed by silent channels
+    void setChannels(int channels);
+    int getChannels() const { return m_channels; }
+    // Time rendered after the last event so releases and effects can ring out
+    void setTailSeconds(float seconds);
+
+    // Renders events (sorted by sample position, at this renderer's sample rate)
+    // followed by the tail; output is streamed to writer when given, which
+    // must have been opened with getChannels() channels.
+    // Returns the number of frames rendered.
+    uint64_t render(const std::vector<NoteEvent>& events, WavWriter* writer = nullptr);
+    bool renderToWAV(const std::vector<NoteEvent>& events, const std::string& filename);
+
+    // Wall-clock time of the last render()
+    double getLastRenderSeconds() const { return m_lastRenderSeconds; }
+
+private:
+    void applyEvent(const NoteEvent& event);
+
+    int m_sampleRate;
+    int m_blockSize;
+    int m_channels;
+    float m_tailSeconds;
+    double m_lastRenderSeconds;
+
+    std::unique_ptr<Synthesizer> m_synthesizer;
+    // Planar synthesizer output, and the same block interleaved for the writer
+    AudioBus m_bus;
+    std::vector<float> m_buffer;
+};
+
+#endif // OFFLINERENDERER_H
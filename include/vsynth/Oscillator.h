@@ -8,7 +8,11 @@ enum class WaveformType {
     SQUARE,
     SAWTOOTH,
     TRIANGLE,
-    NOISE
+    NOISE,
+    // Alias-free wavetable versions (see Wavetable)
+    BANDLIMITED_SQUARE,
+    BANDLIMITED_SAWTOOTH,
+    BANDLIMITED_TRIANGLE
 };
 
 class Oscillator
@@ -19,21 +23,35 @@ public:
     
     float process();
     
+    // Render a block of samples. frequencyScale, if given, multiplies the
+    // frequency per sample (used for vibrato) without touching m_frequency.
+    void renderBlock(float* out, int frames, const float* frequencyScale = nullptr);
+    
     void setFrequency(float frequency);
     void setWaveform(WaveformType waveform);
     void setAmplitude(float amplitude);
     void setPhase(float phase);
     
+    // Stateless kernel shared with VoicePool: renders one oscillator whose
+    // phase (and noise filter state) is stored by the caller
+    static void renderWaveform(WaveformType waveform, float* out, int frames,
+                               float& phase, float increment,
+                               const float* frequencyScale, float& noiseState);
+    
     float getFrequency() const { return m_frequency; }
     WaveformType getWaveform() const { return m_waveform; }
     float getAmplitude() const { return m_amplitude; }
     
 private:
-    float generateSine();
-    float generateSquare();
-    float generateSawtooth();
-    float generateTriangle();
-    float generateNoise();
+    static float generateSine(float phase);
+    static float generateSquare(float phase);
+    static float generateSawtooth(float phase);
+    static float generateTriangle(float phase);
+    static float generateNoise(float& noiseState);
+    
+    template <typename Generator>
+    static void renderWith(Generator generate, float* out, int frames, float& phase,
+                           float increment, const float* frequencyScale);
     
     float m_frequency;
     float m_amplitude;
@@ -0,0 +1,97 @@
+#ifndef OSCILLATORBANK_H
+#define OSCILLATORBANK_H
+
+#include "Oscillator.h"
+#include "SIMD.h"
+
+// Phase/increment storage and SIMD renderer for every oscillator of every voice.
+// Data is planar: plane o holds oscillator o of all voices, so one SIMD register
+// covers the same oscillator of 8 (AVX2) or 4 (SSE2) neighbouring voices.
+// Every oscillator has its own left and right level (its pan), so a stereo
+// render costs one extra multiply-add per lane rather than a second pass.
+// The kernel is chosen once at construction from simd::detect(); band-limited
+// wavetable waveforms use AVX2 gathers, or the scalar kernel without AVX2.
+class OscillatorBank
+{
+public:
+    // Voice count is padded so every plane is a whole number of 16-lane groups
+    static constexpr int LANE_PADDING = 16;
+    // Longest block render() accepts
+    static constexpr int MAX_FRAMES = 64;
+
+    OscillatorBank(int voiceCapacity, int oscillatorsPerVoice);
+    ~OscillatorBank() = default;
+
+    // Distance between two planes, and between two frames of a gains buffer
+    int stride() const { return m_stride; }
+    int oscillatorsPerVoice() const { return m_oscillatorsPerVoice; }
+    simd::InstructionSet instructionSet() const { return m_instructionSet; }
+
+    // Resets voice slot to oscillatorCount oscillators at the given increments
+    // (radians per sample) and pans (-1 left to 1 right, nullptr centres
+    // them); the oscillators beyond oscillatorCount are muted
+    void setVoice(int voice, int oscillatorCount, const float* increments, const float* pans = nullptr);
+    void copyVoice(int from, int to);
+    // Multiplies every increment, e.g. to keep pitch when the sample rate changes
+    void scaleIncrements(float ratio);
+
+    // Left and right level of a pan position: equal power, scaled so the
+    // centre keeps unit level in both channels
+    static void panLevels(float pan, float& left, float& right);
+
+    // Adds sum over voices [begin, end) and oscillators [0, oscillatorCount) of
+    // waveform * level * gains[t * stride() + voice] to left[t] and right[t],
+    // with each oscillator's level for that channel.
+    // begin must be a multiple of LANE_PADDING; frames must not exceed MAX_FRAMES.
+    // frequencyScale (per frame) multiplies every increment (vibrato).
+    void render(WaveformType waveform, int begin, int end, int oscillatorCount,
+                const float* frequencyScale, const float* gains, float* left, float* right,
+                int frames);
+
+    // Renders voices [begin, end) without mixing them, for per-voice
+    // processing: voice v's panned oscillator sum goes to leftLanes[t * stride() + v]
+    // and rightLanes[t * stride() + v], with no gain. Lanes up to the end of
+    // the last SIMD group are written too. frames must not exceed MAX_FRAMES.
+    void renderPerVoice(WaveformType waveform, int begin, int end, int oscillatorCount,
+                        const float* frequencyScale, float* leftLanes, float* rightLanes,
+                        int frames);
+
+private:
+    // PerVoice kernels write left and right as lanes (see renderPerVoice)
+    using Kernel = void (*)(OscillatorBank& bank, WaveformType waveform, int begin, int end,
+                            int oscillatorCount, const float* frequencyScale,
+                            const float* gains, float* left, float* right, int frames);
+
+    template <bool PerVoice>
+    static void renderScalar(OscillatorBank& bank, WaveformType waveform, int begin, int end,
+                             int oscillatorCount, const float* frequencyScale,
+                             const float* gains, float* left, float* right, int frames);
+#ifdef VSYNTH_X86
+    template <bool PerVoice>
+    static void renderSSE2(OscillatorBank& bank, WaveformType waveform, int begin, int end,
+                           int oscillatorCount, const float* frequencyScale,
+                           const float* gains, float* left, float* right, int frames);
+    template <bool PerVoice>
+    static void renderAVX2(OscillatorBank& bank, WaveformType waveform, int begin, int end,
+                           int oscillatorCount, const float* frequencyScale,
+                           const float* gains, float* left, float* right, int frames);
+#endif
+
+    int index(int osc, int voice) const { return osc * m_stride + voice; }
+
+    int m_capacity;
+    int m_stride;
+    int m_oscillatorsPerVoice;
+    simd::InstructionSet m_instructionSet;
+    Kernel m_kernel;
+    Kernel m_perVoiceKernel;
+
+    // Planar oscillator state (m_oscillatorsPerVoice planes of m_stride lanes)
+    simd::AlignedVector<float> m_phases;
+    simd::AlignedVector<float> m_increments;
+    simd::AlignedVector<float> m_leftLevels;
+    simd::AlignedVector<float> m_rightLevels;
+    simd::AlignedVector<float> m_noiseStates;
+};
+
+#endif // OSCILLATORBANK_H
@@ -0,0 +1,99 @@
+#ifndef OVERSAMPLER_H
+#define OVERSAMPLER_H
+
+#include <vector>
+#include "SIMD.h"
+
+// Filter length / stopband trade-off of the oversampling filters
+enum class OversamplingQuality {
+    FAST = 0,      // About 60 dB stopband, passband to 16 kHz at 44.1 kHz
+    BALANCED,      // About 80 dB, passband to 18 kHz
+    HIGH           // About 100 dB, passband to 20 kHz
+};
+
+// 2x/4x/8x up- and downsampler built from cascaded polyphase half-band FIR
+// stages (Kaiser-windowed sinc). A half-band filter has every other tap zero
+// except the centre one, so each 2x stage splits into a symmetric FIR branch
+// and a pure delay branch: half the work of a plain FIR at the high rate.
+// The FIR kernel is chosen once at construction from simd::detect().
+// Buffers are sized for MAX_FACTOR at construction, so configure(),
+// upsample() and downsample() never allocate and are safe on the audio thread.
+class Oversampler
+{
+public:
+    static constexpr int MAX_FACTOR = 8;
+    static constexpr int MAX_STAGES = 3;
+    // Coefficient pairs of the longest (HIGH quality, first stage) half-band
+    static constexpr int MAX_HALF_LENGTH = 32;
+
+    // maxFrames is the longest block (at the base rate) either direction accepts
+    Oversampler(int maxFrames);
+    ~Oversampler() = default;
+
+    // factor is rounded to 1, 2, 4 or 8 (1 passes samples through untouched).
+    // Designs the filters and clears their state.
+    void configure(int factor, OversamplingQuality quality);
+    void reset();
+
+    int factor() const { return m_factor; }
+    OversamplingQuality quality() const { return m_quality; }
+    // Group delay of an upsample() + downsample() round trip, in base-rate frames
+    float latency() const;
+    simd::InstructionSet instructionSet() const { return m_instructionSet; }
+
+    // Interpolates frames samples into frames * factor() samples in an
+    // internal buffer, valid (and writable) until the next upsample() call
+    float* upsample(const float* in, int frames);
+    // Filters and decimates frames * factor() samples of in into frames samples
+    // of out. in may be the buffer returned by upsample().
+    void downsample(const float* in, float* out, int frames);
+
+private:
+    // out[i] = sum over t < halfLength of coefficients[t] * (in[i + t] + in[i + 2 * halfLength - 1 - t])
+    using FirKernel = void (*)(const float* in, const float* coefficients, int halfLength,
+                               float* out, int count);
+
+    static void firScalar(const float* in, const float* coefficients, int halfLength,
+                          float* out, int count);
+#ifdef VSYNTH_X86
+    static void firAVX2(const float* in, const float* coefficients, int halfLength,
+                        float* out, int count);
+#endif
+
+    // One 2x half-band stage. Inputs are appended after the last
+    // 2 * halfLength - 1 samples of the previous block, so the FIR reads a
+    // contiguous history.
+    struct Stage {
+        int halfLength;
+        simd::AlignedVector<float> coefficients;
+        simd::AlignedVector<float> history;
+        // Odd input phase of a decimator, delayed by halfLength samples
+        std::vector<float> delay;
+    };
+
+    void designStage(Stage& stage, int halfLength, float beta, float gain);
+    // frames low-rate samples in, 2 * frames out
+    void upsampleStage(Stage& stage, const float* in, float* out, int frames);
+    // 2 * frames high-rate samples in, frames out
+    void downsampleStage(Stage& stage, const float* in, float* out, int frames);
+
+    int m_maxFrames;
+    int m_factor;
+    int m_stageCount;
+    OversamplingQuality m_quality;
+    simd::InstructionSet m_instructionSet;
+    FirKernel m_kernel;
+
+    // Stage 0 runs between the base rate and 2x, stage 1 between 2x and 4x...
+    Stage m_upStages[MAX_STAGES];
+    Stage m_downStages[MAX_STAGES];
+
+    // Stages copy their input into the history before writing their output,
+    // so every stage of a cascade can work in the same buffer
+    simd::AlignedVector<float> m_upsampled;
+    simd::AlignedVector<float> m_decimated;
+    // FIR branch output of the stage being processed
+    simd::AlignedVector<float> m_firOutput;
+};
+
+#endif // OVERSAMPLER_H
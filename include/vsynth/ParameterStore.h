@@ -0,0 +1,117 @@
+#ifndef PARAMETERSTORE_H
+#define PARAMETERSTORE_H
+
+#include <array>
+#include <cstdint>
+
+// Synthesizer parameters that are read by the voices and effects
+enum class ParameterId {
+    ATTACK,
+    DECAY,
+    SUSTAIN,
+    RELEASE,
+    VIBRATO_RATE,
+    VIBRATO_DEPTH,
+    FILTER_CUTOFF,
+    FILTER_RESONANCE,
+    FILTER_ENVELOPE_AMOUNT,
+    FILTER_KEY_TRACKING,
+    FILTER_ATTACK,
+    FILTER_DECAY,
+    FILTER_SUSTAIN,
+    FILTER_RELEASE,
+    REVERB_MIX,
+    REVERB_ROOM_SIZE,
+    REVERB_DAMPING,
+    REVERB_WIDTH,
+    DELAY_MIX,
+    DELAY_FEEDBACK,
+    CONVOLUTION_MIX,
+    COUNT
+};
+
+// How a parameter moves to a new value
+enum class RampType {
+    NONE,       // Jumps (times, where a jump has no audible step)
+    LINEAR,     // Straight line over a fixed time
+    ONE_POLE    // Exponential approach with a time constant
+};
+
+// A value that glides to its target instead of jumping
+class SmoothedParameter
+{
+public:
+    SmoothedParameter();
+    ~SmoothedParameter() = default;
+    
+    // time is the linear ramp length or the one-pole time constant, in
+    // seconds. blockFrames is the usual advance() length.
+    void configure(RampType type, float time, int sampleRate, int blockFrames);
+    void setTarget(float target);
+    void setImmediate(float value);
+    // Moves frames samples along the ramp; returns whether the value changed
+    bool advance(int frames);
+    
+    float value() const { return m_value; }
+    float target() const { return m_target; }
+    bool isSmoothing() const { return m_value != m_target; }
+    
+private:
+    RampType m_type;
+    float m_value;
+    float m_target;
+    
+    // Linear: ramp length, step per sample and samples left
+    int m_rampFrames;
+    float m_step;
+    int m_remaining;
+    
+    // One-pole: per-sample decay of the distance, and over blockFrames
+    float m_pole;
+    float m_blockPole;
+    int m_blockFrames;
+};
+
+// Every smoothed synthesizer parameter in one place. Writes only set a
+// target, so they cost O(1) whatever reads the parameter; the owner calls
+// advance() once per sub-block and pushes the parameters that changed to
+// their consumers (one shared envelope setting for all voices, one effect
+// setter). While anything is ramping the owner renders in sub-blocks of
+// SUB_BLOCK_SIZE frames, so a ramp moves in steps too small to hear.
+// Audio thread only.
+class ParameterStore
+{
+public:
+    static constexpr int COUNT = static_cast<int>(ParameterId::COUNT);
+    static constexpr int SUB_BLOCK_SIZE = 32;
+    
+    ParameterStore(int sampleRate);
+    ~ParameterStore() = default;
+    
+    // Also sets the value without a ramp and marks it changed
+    void configure(ParameterId id, RampType type, float time, float value);
+    
+    void set(ParameterId id, float value);
+    float get(ParameterId id) const { return m_parameters[index(id)].value(); }
+    float target(ParameterId id) const { return m_parameters[index(id)].target(); }
+    bool isSmoothing() const { return m_smoothing != 0; }
+    // Ends every ramp at its target (the change is reported by advance())
+    void settle();
+    
+    // Advances every moving ramp by frames and returns the parameters whose
+    // value changed since the last call, as a mask of bit(id)
+    uint32_t advance(int frames);
+    
+    static constexpr uint32_t bit(ParameterId id) { return 1u << index(id); }
+    
+private:
+    static constexpr int index(ParameterId id) { return static_cast<int>(id); }
+    
+    int m_sampleRate;
+    std::array<SmoothedParameter, COUNT> m_parameters;
+    // Masks of the parameters still ramping and changed since advance()
+    uint32_t m_smoothing;
+    uint32_t m_changed;
+};
+
+#endif // PARAMETERSTORE_H
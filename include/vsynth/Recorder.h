@@ -5,21 +5,24 @@
 #include <string>
 #include <fstream>
 #include <memory>
+#include <cstdint>
 
+// Note event at an exact sample position, counted from the start of the recording
 struct NoteEvent {
-    float timestamp;
+    uint64_t samplePosition;
     int note;
     float velocity;
     bool isNoteOn;
     
-    NoteEvent(float t, int n, float v, bool on) 
-        : timestamp(t), note(n), velocity(v), isNoteOn(on) {}
+    NoteEvent(uint64_t position, int n, float v, bool on) 
+        : samplePosition(position), note(n), velocity(v), isNoteOn(on) {}
 };
 
 class Recorder
 {
 public:
-    Recorder(int sampleRate);
+    // Audio is recorded and exported with channels channels
+    Recorder(int sampleRate, int channels = 1);
     ~Recorder() = default;
     
     void startRecording();
@@ -30,39 +33,53 @@ public:
     void stopPlayback();
     bool isPlaying() const { return m_isPlaying; }
     
+    // Stamped with the number of audio samples recorded so far
     void recordNoteEvent(int note, float velocity, bool isNoteOn);
-    void recordAudioSample(float sample);
+    // One plane per channel, stored interleaved
+    void recordAudio(const float* const* planes, int frames);
     
-    // Export functions
-    void exportToWAV(const std::string& filename);
-    void exportToMIDI(const std::string& filename);
-    void exportNoteEvents(const std::string& filename);
+    // Export functions; return false if nothing was written
+    bool exportToWAV(const std::string& filename);
+    bool exportToMIDI(const std::string& filename);
+    bool exportNoteEvents(const std::string& filename);
     
-    // Playback
-    void processPlayback(float deltaTime);
-    std::vector<NoteEvent> getEventsToPlay();
+    // Replaces the recorded note events with those of an exportNoteEvents() file
+    bool importNoteEvents(const std::string& filename);
+    const std::vector<NoteEvent>& getNoteEvents() const { return m_noteEvents; }
+    int getSampleRate() const { return m_sampleRate; }
+    int getChannels() const { return m_channels; }
+    
+    // Playback (audio thread, never allocates). An event is due once the
+    // playback position reaches its sample position; the caller splits its
+    // block at framesUntilNextEvent() so every event lands on its exact sample.
+    // Returns the next due event and consumes it, or nullptr when none is due
+    const NoteEvent* nextDueEvent();
+    // Frames until the next event is due (0 if one is due now), -1 if none is left
+    int64_t framesUntilNextEvent() const;
+    // Moves playback on by frames rendered; stops once the release tail has played
+    void advancePlayback(unsigned long frames);
     
     void clear();
     
 private:
     void writeWAVHeader(std::ofstream& file, int dataSize);
-    void writeMIDIFile(const std::string& filename);
+    bool writeMIDIFile(const std::string& filename);
     
     int m_sampleRate;
+    int m_channels;
     bool m_isRecording;
     bool m_isPlaying;
     
     // Note events recording
     std::vector<NoteEvent> m_noteEvents;
-    float m_recordingTime;
+    uint64_t m_recordedFrames;
     
-    // Audio recording
+    // Audio recording, interleaved
     std::vector<float> m_audioBuffer;
     
     // Playback state
-    float m_playbackTime;
+    uint64_t m_playbackPosition;
     size_t m_playbackIndex;
-    std::vector<NoteEvent> m_eventsToPlay;
 };
 
 #endif // RECORDER_H
@@ -0,0 +1,59 @@
+#ifndef RENDERTHREADPOOL_H
+#define RENDERTHREADPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Small pool of real-time worker threads for splitting one audio block into jobs.
+// Jobs are claimed from a single atomic counter, so dispatch is lock-free and the
+// calling (audio) thread works through the queue as well: if workers are slow to
+// wake, the caller simply runs the remaining jobs itself.
+// Workers are pinned to cores and given real-time priority where the OS allows it.
+class RenderThreadPool
+{
+public:
+    using JobFunction = void (*)(void* context, int job);
+
+    explicit RenderThreadPool(int threadCount);
+    ~RenderThreadPool();
+
+    RenderThreadPool(const RenderThreadPool&) = delete;
+    RenderThreadPool& operator=(const RenderThreadPool&) = delete;
+
+    int threadCount() const { return static_cast<int>(m_threads.size()); }
+
+    // Runs function(context, i) for every i in [0, jobCount) and returns once all
+    // of them have finished. Must only be called from one thread at a time.
+    void run(int jobCount, JobFunction function, void* context);
+
+private:
+    void workerLoop(int index);
+    void executeJobs(uint32_t generation);
+    static void configureWorkerThread(std::thread& thread, int index);
+
+    // The claim counter packs generation | job count | next job so a worker that
+    // wakes late can never claim a job of a newer generation by mistake
+    static uint64_t pack(uint32_t generation, uint32_t jobCount, uint32_t next)
+    {
+        return (static_cast<uint64_t>(generation) << 40) | (static_cast<uint64_t>(jobCount) << 20) | next;
+    }
+    static uint32_t generationOf(uint64_t v) { return static_cast<uint32_t>(v >> 40); }
+    static uint32_t jobCountOf(uint64_t v) { return static_cast<uint32_t>((v >> 20) & 0xFFFFF); }
+    static uint32_t nextJobOf(uint64_t v) { return static_cast<uint32_t>(v & 0xFFFFF); }
+
+    std::vector<std::thread> m_threads;
+
+    // Job parameters, only written while no job can be claimed
+    JobFunction m_function;
+    void* m_context;
+    uint32_t m_currentGeneration;
+
+    alignas(64) std::atomic<uint32_t> m_generation;   // Workers wait on this
+    alignas(64) std::atomic<uint64_t> m_claimCounter;
+    alignas(64) std::atomic<int> m_finishedJobs;
+    alignas(64) std::atomic<bool> m_running;
+};
+
+#endif // RENDERTHREADPOOL_H
@@ -0,0 +1,69 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Instruction set helpers for the runtime-dispatched DSP kernels.
+// Kernels are compiled for several targets in the same translation unit
+// (using VSYNTH_TARGET_AVX2 on the AVX2 variants) and selected once at
+// construction time from simd::detect().
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VSYNTH_X86 1
+#endif
+
+#if defined(VSYNTH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define VSYNTH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define VSYNTH_TARGET_AVX2
+#endif
+
+namespace simd {
+
+enum class InstructionSet {
+    SCALAR = 0,
+    SSE2,
+    AVX2
+};
+
+// Best instruction set supported by this CPU. The VSYNTH_SIMD environment
+// variable ("scalar", "sse2" or "avx2") can lower it for testing.
+InstructionSet detect();
+const char* name(InstructionSet set);
+
+// Alignment used for all SIMD-accessed buffers (one cache line)
+constexpr size_t ALIGNMENT = 64;
+
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(ALIGNMENT));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+} // namespace simd
+
+#endif // SIMD_H
@@ -0,0 +1,64 @@
+#ifndef SPECTRUMANALYSISTHREAD_H
+#define SPECTRUMANALYSISTHREAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "FFTAnalyzer.h"
+#include "SpectrumTap.h"
+#include "TripleBuffer.h"
+
+// How the analysis thread runs its STFT
+struct SpectrumSettings {
+    int fftSize = 2048;
+    int hopSize = 512;          // Samples between frames (75% overlap by default)
+    WindowType window = WindowType::HANN;
+    SpectrumAveraging averaging = SpectrumAveraging::EXPONENTIAL;
+    float averagingAmount = 0.6f;
+    // Publish this many log-frequency bands instead of the raw bins (0 = bins)
+    int bands = 0;
+    int sampleRate = 44100;     // Sets the band frequencies
+};
+
+// Streams everything written to a SpectrumTap through an overlapping STFT in
+// its own thread and publishes finished spectra through a triple buffer, so
+// neither the audio callback nor the GUI ever waits for the analysis.
+class SpectrumAnalysisThread
+{
+public:
+    SpectrumAnalysisThread(const SpectrumTap& tap, const SpectrumSettings& settings = SpectrumSettings());
+    ~SpectrumAnalysisThread();
+
+    SpectrumAnalysisThread(const SpectrumAnalysisThread&) = delete;
+    SpectrumAnalysisThread& operator=(const SpectrumAnalysisThread&) = delete;
+
+    void start();
+    void stop();
+
+    // Reader thread (GUI): copies the newest spectrum (normalized magnitudes,
+    // settings.bands bands or fftSize / 2 + 1 bins). Returns false if none was
+    // published since the last call.
+    bool getLatestSpectrum(std::vector<float>& spectrum);
+
+    int getFFTSize() const { return m_analyzer->getFFTSize(); }
+    const SpectrumSettings& getSettings() const { return m_settings; }
+
+private:
+    void run();
+    void analyzeNewSamples();
+
+    const SpectrumTap& m_tap;
+    SpectrumSettings m_settings;
+    std::unique_ptr<FFTAnalyzer> m_analyzer;
+    std::vector<float> m_chunk;
+    uint64_t m_readPosition;
+
+    TripleBuffer<std::vector<float>> m_spectra;
+
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+};
+
+#endif // SPECTRUMANALYSISTHREAD_H
@@ -0,0 +1,44 @@
+#ifndef SPECTRUMTAP_H
+#define SPECTRUMTAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lock-free history of the audio output for analysis. The audio thread writes
+// every sample into a ring; readers copy the latest window in time order and
+// retry (seqlock style) if the audio thread overwrote it meanwhile, so the
+// audio thread never waits and never sees readers.
+class SpectrumTap
+{
+public:
+    // Ring capacity in samples; keep windows well below it so readers rarely retry
+    static constexpr size_t CAPACITY = 1 << 16;
+
+    SpectrumTap();
+
+    // Audio thread
+    void write(const float* samples, size_t count);
+
+    // Any thread: copies the latest count samples, oldest first. Returns false
+    // if fewer than count samples were written yet or the window kept being
+    // overwritten. endPosition receives the position after the last sample.
+    bool snapshot(float* destination, size_t count, uint64_t* endPosition = nullptr) const;
+    // Copies count samples starting at absolute position start. Returns false
+    // if they were not all written yet or have been overwritten since.
+    bool read(uint64_t start, float* destination, size_t count) const;
+
+    // Total samples written so far
+    uint64_t position() const { return m_published.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    std::vector<float> m_ring;
+    // Reserved is stored before the samples are written, published after
+    alignas(64) std::atomic<uint64_t> m_reserved;
+    alignas(64) std::atomic<uint64_t> m_published;
+};
+
+#endif // SPECTRUMTAP_H
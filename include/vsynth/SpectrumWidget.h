@@ -0,0 +1,73 @@
+#ifndef SPECTRUMWIDGET_H
+#define SPECTRUMWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QPolygonF>
+#include <QRect>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <array>
+#include <vector>
+
+// Live spectrum curve over a scrolling waterfall. The waterfall history is a
+// preallocated circular QImage: each new spectrum overwrites one scanline
+// through a colour palette, so adding a frame never allocates. Only the
+// regions that changed are repainted.
+class SpectrumWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum class ViewMode {
+        SPECTRUM = 0,
+        WATERFALL,
+        BOTH
+    };
+
+    explicit SpectrumWidget(QWidget *parent = nullptr);
+    ~SpectrumWidget() = default;
+
+    void setViewMode(ViewMode mode);
+    ViewMode viewMode() const { return m_viewMode; }
+    // Spectra kept in the waterfall
+    void setHistoryLength(int rows);
+
+    // Adds one spectrum of normalized (0-1) values, lowest frequency first
+    void addSpectrum(const std::vector<float>& spectrum);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void resetHistory(int columns);
+    void updateLayout();
+    void updateCurve();
+    void drawCurve(QPainter& painter);
+    void drawWaterfall(QPainter& painter);
+
+    ViewMode m_viewMode;
+    QRect m_curveRect;
+    QRect m_waterfallRect;
+
+    // Circular spectrogram: one row per spectrum, the newest at m_newestRow
+    QImage m_history;
+    int m_historyLength;
+    int m_newestRow;
+    std::array<QRgb, 256> m_palette;
+
+    // Latest spectrum and its curve in widget coordinates
+    std::vector<float> m_current;
+    QPolygonF m_curve;
+    int m_curveTop;
+
+    // Colors
+    QColor m_backgroundColor;
+    QColor m_gridColor;
+    QColor m_curveColor;
+    QColor m_fillColor;
+};
+
+#endif // SPECTRUMWIDGET_H
@@ -0,0 +1,72 @@
+#ifndef STREAMINGRECORDER_H
+#define STREAMINGRECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WavWriter.h"
+
+// Records audio straight to disk with constant memory use.
+// The audio thread copies samples into a lock-free single-producer ring;
+// a writer thread drains it in large chunks into a WAV (RF64 past 4 GB) file.
+// start() and stop() are called from the UI thread, write() from the audio thread.
+class StreamingRecorder
+{
+public:
+    // Ring capacity in frames, about 6 seconds at 44.1 kHz
+    static constexpr size_t RING_FRAMES = 1 << 18;
+
+    StreamingRecorder(int sampleRate, int channels = 1);
+    ~StreamingRecorder();
+
+    StreamingRecorder(const StreamingRecorder&) = delete;
+    StreamingRecorder& operator=(const StreamingRecorder&) = delete;
+
+    bool start(const std::string& filename);
+    // Blocks until every captured sample is on disk and the header is patched
+    void stop();
+    bool isRecording() const { return m_capturing.load(std::memory_order_relaxed); }
+
+    // Audio thread: never blocks or allocates; frames that don't fit in the
+    // ring (disk too slow) are dropped and counted
+    void write(const float* samples, int frames);
+    // Same, from one plane per channel, interleaved straight into the ring
+    void writePlanar(const float* const* planes, int frames);
+
+    uint64_t getFramesRecorded() const { return m_framesRecorded.load(std::memory_order_relaxed); }
+    uint64_t getDroppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+private:
+    // Reserves frames in the ring for the audio thread and has copy(ring
+    // offset, first frame, frame count) fill them, in at most two pieces
+    template <typename Copy>
+    void push(int frames, Copy copy);
+    void writerLoop();
+    // Writes everything currently in the ring; returns the number of samples written
+    size_t drain();
+
+    int m_sampleRate;
+    int m_channels;
+
+    // RING_FRAMES whole frames, so a frame never wraps around the end
+    std::vector<float> m_ring;
+    size_t m_ringSize;
+    alignas(64) std::atomic<uint64_t> m_writePosition;  // Total samples pushed (audio thread)
+    alignas(64) std::atomic<uint64_t> m_readPosition;   // Total samples written (writer thread)
+
+    // Capture flag and the audio thread's in-flight marker; stop() clears the
+    // flag, then waits for the marker so no write() is left touching the ring
+    alignas(64) std::atomic<bool> m_capturing;
+    alignas(64) std::atomic<bool> m_writeInFlight;
+
+    std::atomic<bool> m_writerRunning;
+    std::atomic<uint64_t> m_framesRecorded;
+    std::atomic<uint64_t> m_droppedFrames;
+
+    WavWriter m_file;
+    std::thread m_writerThread;
+};
+
+#endif // STREAMINGRECORDER_H
@@ -3,74 +3,172 @@
 
 #include <vector>
 #include <memory>
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <string>
 #include "Oscillator.h"
 #include "ADSREnvelope.h"
 #include "Effects.h"
+#include "VoicePool.h"
+#include "RenderThreadPool.h"
+#include "CallbackProfiler.h"
+#include "Oversampler.h"
+#include "AudioBus.h"
+#include "ParameterStore.h"
 
-struct Voice {
-    int note;
-    float velocity;
-    std::vector<std::unique_ptr<Oscillator>> oscillators;
-    std::unique_ptr<ADSREnvelope> envelope;
-    bool isActive;
-    float phase;
-    
-    Voice(int n, float v, int oscillatorCount, int sampleRate);
-    ~Voice() = default;
-    
-    float process(float deltaTime);
-    void release();
+// Which voice a note-on takes over when the pool is full
+enum class VoiceStealPolicy {
+    OLDEST = 0,        // The voice started longest ago
+    QUIETEST,          // The lowest envelope level * velocity
+    SAME_NOTE,         // Retrigger a voice already playing the note, else oldest
+    RELEASED_FIRST     // The oldest voice in its release stage, else oldest
 };
 
 class Synthesizer
 {
 public:
-    Synthesizer(int sampleRate);
+    static constexpr int DEFAULT_VOICES = 64;
+    static constexpr int MAX_VOICES = 512;
+    static constexpr int MAX_RENDER_THREADS = 16;
+    // The voices, effects and limiter all run in stereo
+    static constexpr int CHANNELS = 2;
+    
+    // maxVoices is clamped to [1, MAX_VOICES]; all voices are allocated here.
+    // renderThreads extra worker threads share voice rendering with the
+    // audio thread (0 renders everything on the audio thread).
+    Synthesizer(int sampleRate, int maxVoices = DEFAULT_VOICES, int renderThreads = 0);
     ~Synthesizer();
     
+    // Note handling never allocates: voices are claimed from a preallocated pool
     void noteOn(int note, float velocity);
     void noteOff(int note);
     
+    // Mono: the average of the two channels
     float process();
+    void renderBlock(float* out, int frames);
+    // Stereo, into one plane per channel
+    void renderBlock(float* left, float* right, int frames);
     
-    // Parameter setters
+    // Parameter setters. Continuous parameters (levels, mixes, vibrato,
+    // filter, reverb and delay feedback settings) glide to the new value; every
+    // setter costs the same however many voices are sounding.
     void setAttack(float attack);
     void setDecay(float decay);
     void setSustain(float sustain);
     void setRelease(float release);
+    void setEnvelopeCurve(EnvelopeCurve curve);
     void setWaveform(int waveform);
     void setOscillatorCount(int count);
     void setVibratoRate(float rate);
     void setVibratoDepth(float depth);
+    // Placement of new voices: pan (-1 left to 1 right), and how far their
+    // detuned oscillators are fanned out to either side (0-1)
+    void setPan(float pan);
+    void setStereoSpread(float spread);
+    // Per-voice filter: cutoff in Hz, resonance 0-1, envelope amount in
+    // octaves at full filter envelope (-8 to 8), key tracking 0-1 (1 follows
+    // the keyboard exactly), and the filter envelope's own ADSR
+    void setFilterType(FilterType type);
+    void setFilterCutoff(float cutoff);
+    void setFilterResonance(float resonance);
+    void setFilterEnvelopeAmount(float octaves);
+    void setFilterKeyTracking(float amount);
+    void setFilterAttack(float attack);
+    void setFilterDecay(float decay);
+    void setFilterSustain(float sustain);
+    void setFilterRelease(float release);
     void setReverb(float reverb);
     void setDelay(float delay);
+    void setDelayMode(DelayMode mode);
+    void setDelayTime(float time);
+    void setDelayFeedback(float feedback);
+    void setDelayModulationRate(float rate);
+    void setDelayModulationDepth(float depth);
+    // Echo length in beats at the tempo, 0 for the free delay time
+    void setTempo(float bpm);
+    void setDelaySync(float beats);
+    void setReverbRoomSize(float roomSize);
+    void setReverbDamping(float damping);
+    void setReverbWidth(float width);
+    
+    // Convolution reverb. The impulse response WAV is loaded and prepared
+    // in the background and swapped in lock-free, so loading is safe while
+    // rendering (from one other thread).
+    void loadImpulseResponse(const std::string& filename);
+    // Waits for the load; true if an impulse response is now in use
+    bool waitForImpulseResponse();
+    void setConvolutionMix(float mix);
+    
+    void setStealPolicy(VoiceStealPolicy policy);
+    // Jumps every gliding parameter to its new value, for settings made
+    // before a render starts
+    void settleParameters() { m_parameters.settle(); }
+    
+    // Renders the voices at factor (1, 2, 4 or 8) times the sample rate and
+    // decimates them, and runs the output limiter oversampled as well, so
+    // naive waveforms and clipping do not alias. Never allocates; resets the
+    // oversampling filters.
+    void setOversampling(int factor, OversamplingQuality quality = OversamplingQuality::BALANCED);
+    int getOversampling() const { return m_voiceOversamplers[0].factor(); }
+    OversamplingQuality getOversamplingQuality() const { return m_voiceOversamplers[0].quality(); }
+    
+    // Times the voice and effect stages of every render (nullptr disables)
+    void setProfiler(CallbackProfiler* profiler) { m_profiler = profiler; }
+    VoiceStealPolicy getStealPolicy() const { return m_stealPolicy; }
+    
+    // Safe to read from any thread
+    int getMaxVoices() const { return m_voices.capacity(); }
+    int getRenderThreadCount() const { return m_renderThreads ? m_renderThreads->threadCount() : 0; }
+    int getActiveVoiceCount() const { return m_activeVoices.load(std::memory_order_relaxed); }
+    uint64_t getVoiceStealCount() const { return m_voiceSteals.load(std::memory_order_relaxed); }
     
 private:
-    void cleanupVoices();
-    float noteToFrequency(int note);
+    // Advances the parameter ramps over the next frames and pushes the
+    // values that changed to the voices and effects
+    void applyParameters(int frames);
+    void renderChunk(float* left, float* right, int frames);
+    void renderVoices(float* left, float* right, int frames);
+    int findVoiceToSteal(int note) const;
+    int findOldestVoice(bool releasedOnly) const;
+    int findQuietestVoice() const;
     
     int m_sampleRate;
     float m_deltaTime;
     
-    std::vector<std::unique_ptr<Voice>> m_voices;
-    static const int MAX_VOICES = 16; // Polyphony limit
+    VoicePool m_voices;
+    std::unique_ptr<RenderThreadPool> m_renderThreads;
+    VoiceStealPolicy m_stealPolicy;
+    
+    // Voice statistics published for other threads
+    std::atomic<int> m_activeVoices;
+    std::atomic<uint64_t> m_voiceSteals;
     
     // Global parameters
-    float m_attack;
-    float m_decay;
-    float m_sustain;
-    float m_release;
+    ParameterStore m_parameters;
     int m_waveform;
     int m_oscillatorCount;
-    float m_vibratoRate;
-    float m_vibratoDepth;
+    float m_pan;
+    float m_spread;
     
     // Effects
     std::unique_ptr<Effects> m_effects;
     
     // Vibrato LFO
     float m_vibratoPhase;
+    
+    // Voices are decimated from the oversampled rate; the effects stage's
+    // nonlinear output (the limiter) is upsampled around it. One per channel.
+    std::vector<Oversampler> m_voiceOversamplers;
+    std::vector<Oversampler> m_effectsOversamplers;
+    
+    CallbackProfiler* m_profiler;
+    
+    // Preallocated block buffers (renderBlock splits longer requests)
+    static constexpr int MAX_BLOCK_SIZE = VoicePool::MAX_BLOCK_SIZE;
+    std::vector<float> m_vibratoBuffer;
+    // Oversampled voices, and the stereo output of the mono renderBlock()
+    AudioBus m_voiceBus;
+    AudioBus m_outputBus;
 };
 
 #endif // SYNTHESIZER_H
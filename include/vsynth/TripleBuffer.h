@@ -0,0 +1,50 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+
+// Lock-free triple buffer: one writer thread publishes whole values, one reader
+// thread always picks up the newest complete one. Neither side ever waits, and
+// values are reused in place, so nothing is allocated after construction.
+template <typename T>
+class TripleBuffer
+{
+public:
+    explicit TripleBuffer(const T& initial = T())
+        : m_buffers{initial, initial, initial}
+    {
+    }
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side: fill back(), then publish() it
+    T& back() { return m_buffers[m_back]; }
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader side: update() swaps in the newest published value, if any;
+    // front() stays valid until the next update()
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& front() const { return m_buffers[m_front]; }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int FRESH = 4;
+
+    std::array<T, 3> m_buffers;
+    alignas(64) int m_back = 0;                  // Writer only
+    alignas(64) std::atomic<int> m_middle{1};    // Shared slot, FRESH once published
+    alignas(64) int m_front = 2;                 // Reader only
+};
+
+#endif // TRIPLEBUFFER_H
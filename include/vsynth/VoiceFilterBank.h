@@ -0,0 +1,112 @@
+#ifndef VOICEFILTERBANK_H
+#define VOICEFILTERBANK_H
+
+#include <algorithm>
+#include <array>
+#include "OscillatorBank.h"
+#include "SIMD.h"
+
+enum class FilterType {
+    OFF = 0,
+    LOWPASS,    // 12 dB/oct state-variable
+    BANDPASS,   // State-variable, unity gain at the cutoff
+    HIGHPASS,   // 12 dB/oct state-variable
+    LADDER      // 24 dB/oct 4-pole ladder low-pass
+};
+
+// Resonant filter state for every voice, in the OscillatorBank lane layout:
+// each state variable is a plane of stride lanes, so one SIMD register
+// filters the same channel of 8 (AVX2) or 4 (SSE2) neighbouring voices.
+// Both filters are topology-preserving (zero-delay feedback) designs, which
+// stay stable and keep their tuning while the cutoff moves.
+// Cutoffs are control-rate: every voice gets a new tuning each
+// CONTROL_INTERVAL frames, looked up from a table of octaves above
+// MIN_CUTOFF, so modulating a cutoff is an addition and no per-sample tan()
+// is needed. The kernel is chosen once at construction from simd::detect().
+class VoiceFilterBank
+{
+public:
+    static constexpr int CONTROL_INTERVAL = 16;
+    // Tuning rows process() reads at most
+    static constexpr int MAX_UPDATES = OscillatorBank::MAX_FRAMES / CONTROL_INTERVAL;
+    static constexpr float MIN_CUTOFF = 20.0f;
+    // Cutoffs the table covers, above MIN_CUTOFF (past 20 kHz)
+    static constexpr int TABLE_OCTAVES = 11;
+    static constexpr int STEPS_PER_OCTAVE = 32;
+
+    // stride is OscillatorBank::stride() of the bank feeding the filters
+    VoiceFilterBank(int stride, int sampleRate);
+    ~VoiceFilterBank() = default;
+
+    simd::InstructionSet instructionSet() const { return m_instructionSet; }
+
+    // Rebuilds the tuning table; never allocates
+    void setSampleRate(int sampleRate);
+
+    static float octavesFor(float cutoff);
+    // Tuning process() reads for a cutoff octaves above MIN_CUTOFF; cutoffs
+    // are kept below Nyquist
+    float tuning(float octaves) const
+    {
+        const float position = std::max(0.0f, std::min(static_cast<float>(TABLE_SIZE - 1),
+                                                        octaves * STEPS_PER_OCTAVE));
+        const int index = std::min(TABLE_SIZE - 2, static_cast<int>(position));
+        const float frac = position - static_cast<float>(index);
+        return m_tuningTable[index] + frac * (m_tuningTable[index + 1] - m_tuningTable[index]);
+    }
+
+    // Clears a voice's filter memory and sets its tuning until the next update
+    void resetVoice(int voice, float tuning);
+    void copyVoice(int from, int to);
+    // Clears every voice's filter memory (the filters read it differently)
+    void clear();
+
+    // Filters voices [begin, end) of leftLanes and rightLanes, laid out as
+    // OscillatorBank::renderPerVoice() writes them, multiplies them by gains
+    // (same layout) and adds the sum over the voices to left and right.
+    // Row r of tunings (stride lanes each) takes over at frame
+    // firstUpdate + r * CONTROL_INTERVAL; before that the voices keep their
+    // last tuning. resonance is 0-1; begin must be a multiple of
+    // OscillatorBank::LANE_PADDING and frames must not exceed MAX_FRAMES.
+    void process(FilterType type, float resonance, int begin, int end, const float* tunings,
+                 int firstUpdate, const float* leftLanes, const float* rightLanes,
+                 const float* gains, float* left, float* right, int frames);
+
+private:
+    // Every kernel gets the arguments of process() plus the bank
+    using Kernel = void (*)(VoiceFilterBank& bank, FilterType type, float resonance, int begin,
+                            int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                            const float* rightLanes, const float* gains, float* left, float* right,
+                            int frames);
+
+    static void processScalar(VoiceFilterBank& bank, FilterType type, float resonance, int begin,
+                              int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                              const float* rightLanes, const float* gains, float* left, float* right,
+                              int frames);
+#ifdef VSYNTH_X86
+    static void processSSE2(VoiceFilterBank& bank, FilterType type, float resonance, int begin,
+                            int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                            const float* rightLanes, const float* gains, float* left, float* right,
+                            int frames);
+    static void processAVX2(VoiceFilterBank& bank, FilterType type, float resonance, int begin,
+                            int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                            const float* rightLanes, const float* gains, float* left, float* right,
+                            int frames);
+#endif
+
+    // The state-variable filter uses states 0 and 1, the ladder all four
+    static constexpr int STATES = 4;
+
+    static constexpr int TABLE_SIZE = TABLE_OCTAVES * STEPS_PER_OCTAVE + 1;
+
+    int m_stride;
+    simd::InstructionSet m_instructionSet;
+    Kernel m_kernel;
+    std::array<float, TABLE_SIZE> m_tuningTable;
+
+    // STATES planes per channel, then the tuning in use by each voice
+    simd::AlignedVector<float> m_states;
+    simd::AlignedVector<float> m_tunings;
+};
+
+#endif // VOICEFILTERBANK_H
@@ -0,0 +1,173 @@
+#ifndef VOICEPOOL_H
+#define VOICEPOOL_H
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include "Oscillator.h"
+#include "OscillatorBank.h"
+#include "ADSREnvelope.h"
+#include "VoiceFilterBank.h"
+#include "SIMD.h"
+#include "RenderThreadPool.h"
+
+// Fixed-capacity voice storage, allocated once at construction.
+// Voice data is kept as structure-of-arrays and active voices are packed
+// into slots [0, activeCount()), so claiming a voice is O(1) and rendering
+// walks contiguous memory. Freeing a voice moves the last active voice
+// into its slot, so slot indices are only stable until the next free().
+// With a RenderThreadPool attached, voices that would take too long on the
+// calling thread (judged from their measured render time against the block
+// period) are split into contiguous lane ranges rendered in parallel into
+// private buffers.
+// With the filter on, voices are rendered unmixed into their lanes, run
+// through their own filter and only then scaled by their envelope and mixed.
+class VoicePool
+{
+public:
+    static constexpr int MAX_OSCILLATORS = 3;
+    // Longest block renderBlock() renders in one pass
+    static constexpr int MAX_BLOCK_SIZE = 512;
+    // Smallest voice range worth handing to a worker
+    static constexpr int MIN_VOICES_PER_JOB = 2 * OscillatorBank::LANE_PADDING;
+    // The voices are split across the render threads once rendering them on
+    // the calling thread would take more than this share of the block period
+    static constexpr double THREADED_LOAD = 0.25;
+    // Voices rendered unmixed and filtered per pass
+    static constexpr int FILTER_VOICES_PER_PASS = 4 * OscillatorBank::LANE_PADDING;
+    
+    VoicePool(int capacity, int sampleRate);
+    ~VoicePool() = default;
+    
+    int capacity() const { return m_capacity; }
+    int activeCount() const { return m_activeCount; }
+    bool isFull() const { return m_activeCount >= m_capacity; }
+    
+    // Claims the next free slot (the pool must not be full) and returns it
+    int allocate();
+    // Reinitializes a slot (new or stolen) for a note; the caller triggers
+    // it. The voice sits at pan (-1 left to 1 right)
+    // with its detuned oscillators fanned spread to either side.
+    void startVoice(int slot, int note, float velocity, int oscillatorCount,
+                    float pan = 0.0f, float spread = 0.0f);
+    // Starts the envelopes of a voice set up by startVoice()
+    void trigger(int slot);
+    // Restarts a sounding voice's envelopes from their current levels
+    void retrigger(int slot, float velocity);
+    void free(int slot);
+    
+    void release(int slot);
+    int note(int slot) const { return m_notes[slot]; }
+    uint64_t age(int slot) const { return m_ages[slot]; }
+    float level(int slot) const { return m_envelopes[slot].getLevel() * m_velocities[slot]; }
+    bool isReleasing(int slot) const { return m_envelopes[slot].getState() == EnvelopeState::RELEASE; }
+    // Settings of every voice's envelope, shared rather than copied per voice
+    ADSRParameters& envelopeParameters() { return m_envelopeParameters; }
+    // The filter envelope runs at the filter's control rate, once per
+    // VoiceFilterBank::CONTROL_INTERVAL frames, and only while the filter is on
+    ADSRParameters& filterEnvelopeParameters() { return m_filterEnvelopeParameters; }
+    
+    // Per-voice filter. The cutoff (Hz) moves by envelopeAmount octaves
+    // (either sign) at full filter envelope, and by keyTracking (0-1) octaves
+    // per octave the note is above or below middle C.
+    void setFilterType(FilterType type);
+    void setFilterCutoff(float cutoff);
+    void setFilterResonance(float resonance) { m_filterResonance = resonance; }
+    void setFilterEnvelopeAmount(float octaves) { m_filterEnvelopeAmount = octaves; }
+    void setFilterKeyTracking(float amount) { m_filterKeyTracking = amount; }
+    FilterType filterType() const { return m_filterType; }
+    
+    // Adds all active voices to left and right and frees voices whose
+    // envelope finished. frequencyScale is the shared vibrato multiplier
+    // (one value per frame).
+    void renderBlock(float* left, float* right, int frames, WaveformType waveform,
+                     const float* frequencyScale);
+    
+    // Attaches worker threads for renderBlock (nullptr renders single-threaded).
+    // Allocates per-job buffers, so call it before the audio stream starts.
+    void setRenderThreads(RenderThreadPool* threads);
+    
+    // Rate the voices render at (the oversampled rate when oversampling);
+    // sounding voices keep their pitch and envelope timing
+    void setSampleRate(int sampleRate);
+    int sampleRate() const { return m_sampleRate; }
+    
+    simd::InstructionSet instructionSet() const { return m_oscillators.instructionSet(); }
+    
+private:
+    // Scratch owned by one render job, so jobs never share writable memory
+    struct RenderJob {
+        simd::AlignedVector<float> gains;
+        std::vector<float> envelopeBuffer;
+        // Unmixed voices and their filter tunings (filter on only)
+        simd::AlignedVector<float> leftLanes;
+        simd::AlignedVector<float> rightLanes;
+        simd::AlignedVector<float> tunings;
+        std::vector<float> filterEnvelopeBuffer;
+        std::vector<float> leftOutput;
+        std::vector<float> rightOutput;
+    };
+    
+    // Adds voices [begin, end) to left and right; begin must be a multiple of LANE_PADDING
+    void renderVoices(int begin, int end, RenderJob& job, float* left, float* right, int frames);
+    static void renderJob(void* context, int job);
+    // Folds the time voices took to render frames into m_nanosPerVoiceFrame
+    void measureRenderTime(std::chrono::steady_clock::duration time, int voices, int frames);
+    // Filter cutoff of a voice, in octaves above VoiceFilterBank::MIN_CUTOFF,
+    // at a filter envelope level
+    float filterOctaves(int slot, float envelope) const;
+    static int controlRate(int sampleRate) { return std::max(1, sampleRate / VoiceFilterBank::CONTROL_INTERVAL); }
+    
+
+    int m_capacity;
+    int m_sampleRate;
+    int m_activeCount;
+    uint64_t m_nextAge;
+    
+    // Per-voice data
+    std::vector<int> m_notes;
+    std::vector<float> m_velocities;
+    std::vector<int> m_oscillatorCounts;
+    std::vector<uint64_t> m_ages;
+    ADSRParameters m_envelopeParameters;
+    std::vector<ADSREnvelope> m_envelopes;
+    ADSRParameters m_filterEnvelopeParameters;
+    std::vector<ADSREnvelope> m_filterEnvelopes;
+    
+    // Oscillator phases and increments for every slot
+    OscillatorBank m_oscillators;
+    
+    // Filter state of every slot and the shared filter settings
+    VoiceFilterBank m_filters;
+    FilterType m_filterType;
+    float m_filterCutoffOctaves;
+    float m_filterResonance;
+    float m_filterEnvelopeAmount;
+    float m_filterKeyTracking;
+    // Frames since the last filter control update (the grid every voice
+    // and job updates on)
+    int m_controlPhase;
+    
+    // Per-job voice gains (envelope * velocity) are laid out frame-major with
+    // m_oscillators.stride() lanes per frame so the bank reads them as vectors;
+    // a job only writes the lanes of its own voices
+    std::vector<RenderJob> m_jobs;
+    RenderThreadPool* m_threads;
+    // Smoothed render time per voice and frame, timed on job 0, and whether
+    // the last block was split (the split stops below half THREADED_LOAD)
+    double m_nanosPerVoiceFrame;
+    bool m_threaded;
+    std::chrono::steady_clock::duration m_jobTime;
+    
+    // Parameters of the block being rendered, read by the jobs
+    float* m_blockLeft;
+    float* m_blockRight;
+    int m_blockFrames;
+    int m_voicesPerJob;
+    int m_oscillatorCount;
+    WaveformType m_waveform;
+    const float* m_frequencyScale;
+};
+
+#endif // VOICEPOOL_H
@@ -0,0 +1,29 @@
+#ifndef WAVREADER_H
+#define WAVREADER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Reads a whole WAV file into memory as interleaved floats in [-1, 1].
+// Handles 8/16/24/32-bit PCM and 32-bit float, plain or WAVE_FORMAT_EXTENSIBLE.
+class WavReader
+{
+public:
+    WavReader();
+    ~WavReader() = default;
+
+    bool load(const std::string& filename);
+
+    const std::vector<float>& samples() const { return m_samples; }
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+    uint64_t frames() const { return m_channels > 0 ? m_samples.size() / m_channels : 0; }
+
+private:
+    std::vector<float> m_samples;
+    int m_sampleRate;
+    int m_channels;
+};
+
+#endif // WAVREADER_H
@@ -0,0 +1,38 @@
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+
+// Streams 16-bit PCM to a WAV file block by block; the header sizes are
+// patched in close(), so the length doesn't need to be known up front.
+// Files larger than 4 GB are written as RF64 (EBU Tech 3306).
+class WavWriter
+{
+public:
+    WavWriter();
+    ~WavWriter();
+
+    bool open(const std::string& filename, int sampleRate, int channels = 1);
+    // Writes frames interleaved frames (frames * channels samples), clamped to [-1, 1]
+    bool write(const float* samples, int frames);
+    void close();
+
+    bool isOpen() const { return m_file.is_open(); }
+    uint64_t framesWritten() const { return m_framesWritten; }
+
+private:
+    static constexpr int HEADER_SIZE = 80;
+
+    void writeHeader(uint64_t dataSize);
+
+    std::ofstream m_file;
+    int m_sampleRate;
+    int m_channels;
+    uint64_t m_framesWritten;
+    std::vector<int16_t> m_pcmBuffer;
+};
+
+#endif // WAVWRITER_H
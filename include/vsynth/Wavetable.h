@@ -0,0 +1,52 @@
+#ifndef WAVETABLE_H
+#define WAVETABLE_H
+
+#include <vector>
+#include "Oscillator.h"
+
+// Band-limited single-cycle tables for the BANDLIMITED_* waveforms.
+// Each waveform has one mip level per octave; level k holds only the
+// harmonics that stay below Nyquist for the octave it covers. Tables are
+// built once (initialize()) and shared read-only by every voice.
+class Wavetable
+{
+public:
+    static constexpr int TABLE_SIZE = 2048;
+    static constexpr int NUM_LEVELS = 10;
+    // Two guard samples per level so interpolation never wraps the index
+    static constexpr int LEVEL_STRIDE = TABLE_SIZE + 2;
+    
+    // Builds every table. Call from a non-realtime thread before rendering.
+    static void initialize();
+    
+    static bool isWavetable(WaveformType waveform);
+    // Table for a BANDLIMITED_* waveform, nullptr for the others
+    static const Wavetable* forWaveform(WaveformType waveform);
+    
+    // Mip level for a phase increment in radians per sample
+    int levelFor(float increment) const;
+    
+    const float* data() const { return m_samples.data(); }
+    const float* level(int index) const { return m_samples.data() + index * LEVEL_STRIDE; }
+    
+    // Linearly interpolated read, phase in [0, 2*pi)
+    static float lookup(const float* table, float phase)
+    {
+        float position = phase * PHASE_TO_INDEX;
+        int index = static_cast<int>(position);
+        float frac = position - static_cast<float>(index);
+        return table[index] + frac * (table[index + 1] - table[index]);
+    }
+    
+    static constexpr float PHASE_TO_INDEX = static_cast<float>(TABLE_SIZE) / (2.0f * static_cast<float>(M_PI));
+    
+private:
+    Wavetable(WaveformType waveform);
+    
+    // Fourier amplitude of harmonic k (cosine and sine parts)
+    static void harmonic(WaveformType waveform, int k, float& cosine, float& sine);
+    
+    std::vector<float> m_samples;
+};
+
+#endif // WAVETABLE_H
@@ -1,111 +1,354 @@
 #include "vsynth/ADSREnvelope.h"
 #include <algorithm>
+#include <climits>
+#include <cmath>
 
-ADSREnvelope::ADSREnvelope(int sampleRate)
+namespace {
+// How far past (converging) or behind (diverging) a curved segment's end
+// points its asymptote lies, relative to the segment's height: 0.001 puts
+// the curve's bend 60 dB deep
+constexpr double EXPONENTIAL_RATIO = 0.001;
+// An analog envelope charges towards a higher voltage than it stops at
+// (fast start, gently bending over) and discharges towards zero
+constexpr double ANALOG_ATTACK_RATIO = 0.3;
+constexpr double ANALOG_DECAY_RATIO = 0.01;
+
+// Segment from level start to level end over seconds. converging curves
+// approach the end level and slow down; diverging ones leave the start
+// level slowly and speed up.
+EnvelopeSegment makeSegment(double start, double end, float seconds, int sampleRate,
+                            double ratio, bool converging)
+{
+    EnvelopeSegment segment;
+    segment.length = std::max(1, static_cast<int>(std::lround(seconds * sampleRate)));
+    
+    double multiplier = 1.0;
+    double addend = (end - start) / segment.length;
+    if (ratio > 0.0 && end != start) {
+        // Asymptote the level moves away from or towards
+        const double asymptote = converging ? end + (end - start) * ratio
+                                            : start - (end - start) * ratio;
+        multiplier = std::pow((end - asymptote) / (start - asymptote), 1.0 / segment.length);
+        addend = asymptote * (1.0 - multiplier);
+    }
+    segment.multiplier = static_cast<float>(multiplier);
+    segment.addend = static_cast<float>(addend);
+    
+    double power = 1.0;
+    double sum = 0.0;
+    for (int j = 0; j < EnvelopeSegment::UNROLL; ++j) {
+        sum += power;
+        power *= multiplier;
+        segment.powers[j] = static_cast<float>(power);
+        segment.sums[j] = static_cast<float>(sum);
+    }
+    return segment;
+}
+}
+
+ADSRParameters::ADSRParameters(int sampleRate)
     : m_sampleRate(sampleRate)
-    , m_deltaTime(1.0f / static_cast<float>(sampleRate))
+    , m_curve(EnvelopeCurve::LINEAR)
     , m_attack(0.1f)
     , m_decay(0.2f)
     , m_sustain(0.7f)
     , m_release(0.5f)
+    , m_version(0)
+{
+    calculateSegments();
+}
+
+void ADSRParameters::setAttack(float attack)
+{
+    m_attack = std::max(0.001f, attack);
+    calculateSegments();
+}
+
+void ADSRParameters::setDecay(float decay)
+{
+    m_decay = std::max(0.001f, decay);
+    calculateSegments();
+}
+
+void ADSRParameters::setSustain(float sustain)
+{
+    m_sustain = std::max(0.0f, std::min(1.0f, sustain));
+    calculateSegments();
+}
+
+void ADSRParameters::setRelease(float release)
+{
+    m_release = std::max(0.001f, release);
+    calculateSegments();
+}
+
+void ADSRParameters::setCurve(EnvelopeCurve curve)
+{
+    m_curve = curve;
+    calculateSegments();
+}
+
+void ADSRParameters::setSampleRate(int sampleRate)
+{
+    m_sampleRate = sampleRate;
+    calculateSegments();
+}
+
+void ADSRParameters::calculateSegments()
+{
+    double attackRatio = 0.0;
+    double decayRatio = 0.0;
+    bool attackConverges = true;
+    switch (m_curve) {
+        case EnvelopeCurve::LINEAR:
+            break;
+        case EnvelopeCurve::EXPONENTIAL:
+            attackRatio = EXPONENTIAL_RATIO;
+            decayRatio = EXPONENTIAL_RATIO;
+            attackConverges = false;
+            break;
+        case EnvelopeCurve::ANALOG:
+            attackRatio = ANALOG_ATTACK_RATIO;
+            decayRatio = ANALOG_DECAY_RATIO;
+            break;
+    }
+    
+    m_attackSegment = makeSegment(0.0, 1.0, m_attack, m_sampleRate, attackRatio, attackConverges);
+    m_decaySegment = makeSegment(1.0, m_sustain, m_decay, m_sampleRate, decayRatio, true);
+    m_releaseSegment = makeSegment(1.0, 0.0, m_release, m_sampleRate, decayRatio, true);
+    ++m_version;
+}
+
+ADSREnvelope::ADSREnvelope(const ADSRParameters* parameters)
+    : m_parameters(parameters)
+    , m_version(parameters->version())
     , m_state(EnvelopeState::IDLE)
     , m_currentLevel(0.0f)
-    , m_targetLevel(0.0f)
-    , m_rate(0.0f)
+    , m_addend(0.0f)
+    , m_remaining(0)
+    , m_releaseLevel(0.0f)
 {
-    calculateRates();
 }
 
 void ADSREnvelope::trigger()
 {
-    m_state = EnvelopeState::ATTACK;
-    m_targetLevel = 1.0f;
-    m_rate = m_attackRate;
+    enterStage(EnvelopeState::ATTACK);
 }
 
 void ADSREnvelope::release()
 {
     if (m_state != EnvelopeState::IDLE) {
-        m_state = EnvelopeState::RELEASE;
-        m_targetLevel = 0.0f;
-        m_rate = m_releaseRate;
+        enterStage(EnvelopeState::RELEASE);
     }
 }
 
-float ADSREnvelope::process()
+void ADSREnvelope::reset()
+{
+    m_state = EnvelopeState::IDLE;
+    m_currentLevel = 0.0f;
+    m_remaining = 0;
+}
+
+const EnvelopeSegment& ADSREnvelope::segment() const
 {
     switch (m_state) {
-        case EnvelopeState::IDLE:
-            m_currentLevel = 0.0f;
-            break;
-            
         case EnvelopeState::ATTACK:
-            m_currentLevel += m_rate;
-            if (m_currentLevel >= m_targetLevel) {
-                m_currentLevel = m_targetLevel;
-                m_state = EnvelopeState::DECAY;
-                m_targetLevel = m_sustain;
-                m_rate = -m_decayRate;
-            }
-            break;
-            
+            return m_parameters->attackSegment();
+        case EnvelopeState::DECAY:
+            return m_parameters->decaySegment();
+        default:
+            return m_parameters->releaseSegment();
+    }
+}
+
+float ADSREnvelope::stageTarget() const
+{
+    switch (m_state) {
+        case EnvelopeState::ATTACK:
+            return 1.0f;
         case EnvelopeState::DECAY:
-            m_currentLevel += m_rate;
-            if (m_currentLevel <= m_targetLevel) {
-                m_currentLevel = m_targetLevel;
-                m_state = EnvelopeState::SUSTAIN;
-                m_rate = 0.0f;
-            }
-            break;
-            
         case EnvelopeState::SUSTAIN:
-            m_currentLevel = m_sustain;
-            break;
-            
-        case EnvelopeState::RELEASE:
-            m_currentLevel += m_rate;
-            if (m_currentLevel <= 0.0f) {
-                m_currentLevel = 0.0f;
-                m_state = EnvelopeState::IDLE;
-                m_rate = 0.0f;
-            }
-            break;
+            return m_parameters->getSustain();
+        default:
+            return 0.0f;
     }
-    
-    return std::max(0.0f, std::min(1.0f, m_currentLevel));
 }
 
-void ADSREnvelope::setAttack(float attack)
+int ADSREnvelope::stepsTo(float multiplier, float addend, float from, float to)
 {
-    m_attack = std::max(0.001f, attack);
-    calculateRates();
+    double steps;
+    if (multiplier == 1.0f) {
+        if (addend == 0.0f) {
+            return 0;
+        }
+        steps = (static_cast<double>(to) - from) / addend;
+    } else {
+        // level - asymptote shrinks (or grows) by multiplier every sample
+        const double asymptote = addend / (1.0 - static_cast<double>(multiplier));
+        const double ratio = (to - asymptote) / (from - asymptote);
+        if (!(ratio > 0.0)) {
+            return 0;
+        }
+        steps = std::log(ratio) / std::log(static_cast<double>(multiplier));
+    }
+    
+    // Heading away from the target (it moved past the level): snap to it
+    if (!(steps > 0.0)) {
+        return 0;
+    }
+    return steps < static_cast<double>(INT_MAX) ? std::max(1, static_cast<int>(std::ceil(steps - 1.0e-3)))
+                                                : INT_MAX;
 }
 
-void ADSREnvelope::setDecay(float decay)
+void ADSREnvelope::enterStage(EnvelopeState state)
 {
-    m_decay = std::max(0.001f, decay);
-    calculateRates();
+    m_state = state;
+    m_version = m_parameters->version();
+    
+    switch (state) {
+        case EnvelopeState::ATTACK: {
+            const EnvelopeSegment& attack = m_parameters->attackSegment();
+            m_addend = attack.addend;
+            m_remaining = (m_currentLevel == 0.0f) ? attack.length
+                                                   : stepsTo(attack.multiplier, m_addend, m_currentLevel, 1.0f);
+            break;
+        }
+        
+        case EnvelopeState::DECAY: {
+            const EnvelopeSegment& decay = m_parameters->decaySegment();
+            m_addend = decay.addend;
+            m_remaining = decay.length;
+            break;
+        }
+        
+        case EnvelopeState::RELEASE:
+            // The release segment runs from 1; scaling it by the current
+            // level gives the same duration and shape from any level
+            m_releaseLevel = m_currentLevel;
+            m_addend = m_parameters->releaseSegment().addend * m_releaseLevel;
+            m_remaining = (m_releaseLevel > 0.0f) ? m_parameters->releaseSegment().length : 0;
+            break;
+        
+        default:
+            m_remaining = 0;
+            break;
+    }
 }
 
-void ADSREnvelope::setSustain(float sustain)
+void ADSREnvelope::retune()
 {
-    m_sustain = std::max(0.0f, std::min(1.0f, sustain));
+    m_version = m_parameters->version();
+    if (m_state != EnvelopeState::ATTACK && m_state != EnvelopeState::DECAY
+        && m_state != EnvelopeState::RELEASE) {
+        return;
+    }
+    
+    const EnvelopeSegment& current = segment();
+    m_addend = current.addend;
+    if (m_state == EnvelopeState::RELEASE) {
+        m_addend *= m_releaseLevel;
+    }
+    // Sustain raised above a decaying level: the decay would head away from
+    // it, so turn it around and climb to the new level over the decay time,
+    // keeping the decay's multiplier (its curvature)
+    if (m_state == EnvelopeState::DECAY && m_currentLevel < stageTarget()) {
+        const double multiplier = current.multiplier;
+        const double target = stageTarget();
+        if (multiplier == 1.0) {
+            m_addend = static_cast<float>((target - m_currentLevel) / current.length);
+        } else {
+            // Solves power * level + addend * (1 - power) / (1 - multiplier) = target
+            const double power = std::pow(multiplier, current.length);
+            m_addend = static_cast<float>((target - power * m_currentLevel) * (1.0 - multiplier) / (1.0 - power));
+        }
+        m_remaining = current.length;
+        return;
+    }
+    m_remaining = stepsTo(current.multiplier, m_addend, m_currentLevel, stageTarget());
 }
 
-void ADSREnvelope::setRelease(float release)
+float ADSREnvelope::process()
 {
-    m_release = std::max(0.001f, release);
-    calculateRates();
+    // Mid-stage and held samples skip the block machinery
+    if (m_state == EnvelopeState::SUSTAIN) {
+        m_currentLevel = m_parameters->getSustain();
+        return m_currentLevel;
+    }
+    if (m_remaining > 1 && m_version == m_parameters->version()) {
+        --m_remaining;
+        m_currentLevel = m_currentLevel * segment().multiplier + m_addend;
+        return m_currentLevel;
+    }
+    
+    float out;
+    renderBlock(&out, 1);
+    return out;
 }
 
-bool ADSREnvelope::isActive() const
+void ADSREnvelope::renderBlock(float* out, int frames)
 {
-    return m_state != EnvelopeState::IDLE;
+    if (m_version != m_parameters->version()) {
+        retune();
+    }
+    
+    int i = 0;
+    while (i < frames) {
+        if (m_state == EnvelopeState::IDLE) {
+            m_currentLevel = 0.0f;
+            std::fill(out + i, out + frames, 0.0f);
+            return;
+        }
+        
+        if (m_state == EnvelopeState::SUSTAIN) {
+            // Follows the (smoothed) sustain level while it is held
+            m_currentLevel = m_parameters->getSustain();
+            std::fill(out + i, out + frames, m_currentLevel);
+            return;
+        }
+        
+        // Whole stage or rest of the block, without per-sample checks
+        const EnvelopeSegment& current = segment();
+        const int run = std::min(m_remaining, frames - i);
+        const float addend = m_addend;
+        float* stageOut = out + i;
+        float level = m_currentLevel;
+        int k = 0;
+        for (; k + EnvelopeSegment::UNROLL <= run; k += EnvelopeSegment::UNROLL) {
+            for (int j = 0; j < EnvelopeSegment::UNROLL; ++j) {
+                stageOut[k + j] = current.powers[j] * level + current.sums[j] * addend;
+            }
+            level = stageOut[k + EnvelopeSegment::UNROLL - 1];
+        }
+        for (; k < run; ++k) {
+            level = level * current.multiplier + addend;
+            stageOut[k] = level;
+        }
+        m_currentLevel = level;
+        m_remaining -= run;
+        i += run;
+        
+        if (m_remaining == 0) {
+            // Land exactly on the stage's end level
+            m_currentLevel = stageTarget();
+            if (run > 0) {
+                out[i - 1] = m_currentLevel;
+            }
+            switch (m_state) {
+                case EnvelopeState::ATTACK:
+                    enterStage(EnvelopeState::DECAY);
+                    break;
+                case EnvelopeState::DECAY:
+                    enterStage(EnvelopeState::SUSTAIN);
+                    break;
+                default:
+                    enterStage(EnvelopeState::IDLE);
+                    break;
+            }
+        }
+    }
 }
 
-void ADSREnvelope::calculateRates()
+bool ADSREnvelope::isActive() const
 {
-    m_attackRate = 1.0f / (m_attack * static_cast<float>(m_sampleRate));
-    m_decayRate = (1.0f - m_sustain) / (m_decay * static_cast<float>(m_sampleRate));
-    m_releaseRate = -m_sustain / (m_release * static_cast<float>(m_sampleRate));
+    return m_state != EnvelopeState::IDLE;
 }
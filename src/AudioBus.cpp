@@ -0,0 +1,82 @@
+#include "vsynth/AudioBus.h"
+#include <algorithm>
+#include <cstring>
+
+AudioBus::AudioBus(int channels, int capacity)
+    : m_channels(std::max(1, channels))
+    , m_capacity(std::max(1, capacity))
+{
+    const int floatsPerLine = static_cast<int>(simd::ALIGNMENT / sizeof(float));
+    m_stride = (m_capacity + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+    m_data.assign(static_cast<size_t>(m_channels) * m_stride, 0.0f);
+
+    m_planes.resize(m_channels);
+    for (int c = 0; c < m_channels; ++c) {
+        m_planes[c] = channel(c);
+    }
+}
+
+void AudioBus::clear(int frames)
+{
+    for (int c = 0; c < m_channels; ++c) {
+        std::fill(channel(c), channel(c) + frames, 0.0f);
+    }
+}
+
+void AudioBus::writeInterleaved(float* out, int outputChannels, int frames) const
+{
+    if (outputChannels == 1) {
+        const float scale = 1.0f / static_cast<float>(m_channels);
+        std::copy(channel(0), channel(0) + frames, out);
+        for (int c = 1; c < m_channels; ++c) {
+            const float* in = channel(c);
+            for (int i = 0; i < frames; ++i) {
+                out[i] += in[i];
+            }
+        }
+        for (int i = 0; i < frames; ++i) {
+            out[i] *= scale;
+        }
+        return;
+    }
+
+    // The common stereo case gets a loop the compiler turns into unpacks
+    if (outputChannels == 2 && m_channels == 2) {
+        const float* left = channel(0);
+        const float* right = channel(1);
+        for (int i = 0; i < frames; ++i) {
+            out[2 * i] = left[i];
+            out[2 * i + 1] = right[i];
+        }
+        return;
+    }
+
+    for (int c = 0; c < outputChannels; ++c) {
+        if (c < m_channels) {
+            const float* in = channel(c);
+            for (int i = 0; i < frames; ++i) {
+                out[i * outputChannels + c] = in[i];
+            }
+        } else {
+            for (int i = 0; i < frames; ++i) {
+                out[i * outputChannels + c] = 0.0f;
+            }
+        }
+    }
+}
+
+void AudioBus::writePlanar(float* const* out, int outputChannels, int frames) const
+{
+    if (outputChannels == 1) {
+        writeInterleaved(out[0], 1, frames);
+        return;
+    }
+
+    for (int c = 0; c < outputChannels; ++c) {
+        if (c < m_channels) {
+            std::memcpy(out[c], channel(c), frames * sizeof(float));
+        } else {
+            std::fill(out[c], out[c] + frames, 0.0f);
+        }
+    }
+}
@@ -1,15 +1,26 @@
 #include "vsynth/AudioEngine.h"
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 AudioEngine::AudioEngine()
     : m_stream(nullptr)
     , m_sampleRate(44100)
     , m_framesPerBuffer(256)
+    , m_outputChannels(Synthesizer::CHANNELS)
+    , m_interleaved(false)
     , m_isInitialized(false)
     , m_isRunning(false)
-    , m_fftBufferIndex(0)
+    , m_pendingCount(0)
+    , m_recordingActive(false)
+    , m_recordingRequested(false)
+    , m_recordingSequence(0)
+    , m_recordingAcknowledged(0)
+    , m_playbackActive(false)
+    , m_outputBus(Synthesizer::CHANNELS, OUTPUT_BLOCK_SIZE)
+    , m_spectrumBuffer(OUTPUT_BLOCK_SIZE, 0.0f)
 {
-    m_fftBuffer.resize(FFT_SIZE, 0.0f);
 }
 
 AudioEngine::~AudioEngine()
@@ -17,10 +28,12 @@ AudioEngine::~AudioEngine()
     shutdown();
 }
 
-bool AudioEngine::initialize(int sampleRate, int framesPerBuffer)
+bool AudioEngine::initialize(int sampleRate, int framesPerBuffer, int maxVoices, int renderThreads,
+                             int outputChannels, bool interleaved)
 {
     m_sampleRate = sampleRate;
     m_framesPerBuffer = framesPerBuffer;
+    m_interleaved = interleaved;
     
     // Initialize PortAudio
     PaError err = Pa_Initialize();
@@ -30,8 +43,14 @@ bool AudioEngine::initialize(int sampleRate, int framesPerBuffer)
     }
     
     // Create synthesizer and recorder
-    m_synthesizer = std::make_unique<Synthesizer>(m_sampleRate);
-    m_recorder = std::make_unique<Recorder>(m_sampleRate);
+    m_synthesizer = std::make_unique<Synthesizer>(m_sampleRate, maxVoices, renderThreads);
+    m_recorder = std::make_unique<Recorder>(m_sampleRate, Synthesizer::CHANNELS);
+    m_streamingRecorder = std::make_unique<StreamingRecorder>(m_sampleRate, Synthesizer::CHANNELS);
+    m_profiler.setSampleRate(m_sampleRate);
+    m_synthesizer->setProfiler(&m_profiler);
+    SpectrumSettings spectrumSettings;
+    spectrumSettings.sampleRate = m_sampleRate;
+    m_spectrumAnalysis = std::make_unique<SpectrumAnalysisThread>(m_spectrumTap, spectrumSettings);
     
     // Setup stream parameters
     PaStreamParameters outputParameters;
@@ -42,9 +61,13 @@ bool AudioEngine::initialize(int sampleRate, int framesPerBuffer)
         return false;
     }
     
-    outputParameters.channelCount = 1; // Mono output
-    outputParameters.sampleFormat = paFloat32;
-    outputParameters.suggestedLatency = Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
+    const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(outputParameters.device);
+    m_outputChannels = std::clamp(outputChannels, 1, std::max(1, deviceInfo->maxOutputChannels));
+    m_outputPlanes.assign(m_outputChannels, nullptr);
+    
+    outputParameters.channelCount = m_outputChannels;
+    outputParameters.sampleFormat = m_interleaved ? paFloat32 : (paFloat32 | paNonInterleaved);
+    outputParameters.suggestedLatency = deviceInfo->defaultLowOutputLatency;
     outputParameters.hostApiSpecificStreamInfo = nullptr;
     
     // Open stream
@@ -63,6 +86,7 @@ bool AudioEngine::initialize(int sampleRate, int framesPerBuffer)
         return false;
     }
     
+    m_spectrumAnalysis->start();
     m_isInitialized = true;
     return true;
 }
@@ -78,6 +102,15 @@ void AudioEngine::shutdown()
         m_stream = nullptr;
     }
     
+    // Finish the file once the callback can no longer write to it
+    if (m_streamingRecorder) {
+        m_streamingRecorder->stop();
+    }
+    
+    if (m_spectrumAnalysis) {
+        m_spectrumAnalysis->stop();
+    }
+    
     if (m_isInitialized) {
         Pa_Terminate();
         m_isInitialized = false;
@@ -108,171 +141,485 @@ void AudioEngine::stop()
     }
 }
 
-void AudioEngine::noteOn(int note, float velocity)
+void AudioEngine::noteOn(int note, float velocity, int sampleOffset)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->noteOn(note, velocity);
-        if (m_recorder) {
-            m_recorder->recordNoteEvent(note, velocity, true);
-        }
-    }
+    pushCommand(CommandType::NOTE_ON, note, velocity, sampleOffset);
 }
 
-void AudioEngine::noteOff(int note)
+void AudioEngine::noteOff(int note, int sampleOffset)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->noteOff(note);
-        if (m_recorder) {
-            m_recorder->recordNoteEvent(note, 0.0f, false);
-        }
-    }
+    pushCommand(CommandType::NOTE_OFF, note, 0.0f, sampleOffset);
 }
 
 void AudioEngine::setAttack(float attack)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setAttack(attack);
-    }
+    pushCommand(CommandType::SET_ATTACK, 0, attack);
 }
 
 void AudioEngine::setDecay(float decay)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setDecay(decay);
-    }
+    pushCommand(CommandType::SET_DECAY, 0, decay);
 }
 
 void AudioEngine::setSustain(float sustain)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setSustain(sustain);
-    }
+    pushCommand(CommandType::SET_SUSTAIN, 0, sustain);
 }
 
 void AudioEngine::setRelease(float release)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setRelease(release);
-    }
+    pushCommand(CommandType::SET_RELEASE, 0, release);
+}
+
+void AudioEngine::setEnvelopeCurve(EnvelopeCurve curve)
+{
+    pushCommand(CommandType::SET_ENVELOPE_CURVE, static_cast<int>(curve), 0.0f);
 }
 
 void AudioEngine::setWaveform(int waveform)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setWaveform(waveform);
-    }
+    pushCommand(CommandType::SET_WAVEFORM, waveform, 0.0f);
 }
 
 void AudioEngine::setOscillatorCount(int count)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setOscillatorCount(count);
-    }
+    pushCommand(CommandType::SET_OSCILLATOR_COUNT, count, 0.0f);
 }
 
 void AudioEngine::setVibratoRate(float rate)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setVibratoRate(rate);
-    }
+    pushCommand(CommandType::SET_VIBRATO_RATE, 0, rate);
 }
 
 void AudioEngine::setVibratoDepth(float depth)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setVibratoDepth(depth);
-    }
+    pushCommand(CommandType::SET_VIBRATO_DEPTH, 0, depth);
+}
+
+void AudioEngine::setFilterType(FilterType type)
+{
+    pushCommand(CommandType::SET_FILTER_TYPE, static_cast<int>(type), 0.0f);
+}
+
+void AudioEngine::setFilterCutoff(float cutoff)
+{
+    pushCommand(CommandType::SET_FILTER_CUTOFF, 0, cutoff);
+}
+
+void AudioEngine::setFilterResonance(float resonance)
+{
+    pushCommand(CommandType::SET_FILTER_RESONANCE, 0, resonance);
+}
+
+void AudioEngine::setFilterEnvelopeAmount(float octaves)
+{
+    pushCommand(CommandType::SET_FILTER_ENVELOPE_AMOUNT, 0, octaves);
+}
+
+void AudioEngine::setFilterKeyTracking(float amount)
+{
+    pushCommand(CommandType::SET_FILTER_KEY_TRACKING, 0, amount);
+}
+
+void AudioEngine::setFilterAttack(float attack)
+{
+    pushCommand(CommandType::SET_FILTER_ATTACK, 0, attack);
+}
+
+void AudioEngine::setFilterDecay(float decay)
+{
+    pushCommand(CommandType::SET_FILTER_DECAY, 0, decay);
+}
+
+void AudioEngine::setFilterSustain(float sustain)
+{
+    pushCommand(CommandType::SET_FILTER_SUSTAIN, 0, sustain);
+}
+
+void AudioEngine::setFilterRelease(float release)
+{
+    pushCommand(CommandType::SET_FILTER_RELEASE, 0, release);
+}
+
+void AudioEngine::setPan(float pan)
+{
+    pushCommand(CommandType::SET_PAN, 0, pan);
+}
+
+void AudioEngine::setStereoSpread(float spread)
+{
+    pushCommand(CommandType::SET_STEREO_SPREAD, 0, spread);
 }
 
 void AudioEngine::setReverb(float reverb)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_synthesizer) {
-        m_synthesizer->setReverb(reverb);
-    }
+    pushCommand(CommandType::SET_REVERB, 0, reverb);
 }
 
 void AudioEngine::setDelay(float delay)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
+    pushCommand(CommandType::SET_DELAY, 0, delay);
+}
+
+void AudioEngine::setDelayMode(DelayMode mode)
+{
+    pushCommand(CommandType::SET_DELAY_MODE, static_cast<int>(mode), 0.0f);
+}
+
+void AudioEngine::setDelayTime(float time)
+{
+    pushCommand(CommandType::SET_DELAY_TIME, 0, time);
+}
+
+void AudioEngine::setDelayFeedback(float feedback)
+{
+    pushCommand(CommandType::SET_DELAY_FEEDBACK, 0, feedback);
+}
+
+void AudioEngine::setDelayModulationRate(float rate)
+{
+    pushCommand(CommandType::SET_DELAY_MOD_RATE, 0, rate);
+}
+
+void AudioEngine::setDelayModulationDepth(float depth)
+{
+    pushCommand(CommandType::SET_DELAY_MOD_DEPTH, 0, depth);
+}
+
+void AudioEngine::setTempo(float bpm)
+{
+    pushCommand(CommandType::SET_TEMPO, 0, bpm);
+}
+
+void AudioEngine::setDelaySync(float beats)
+{
+    pushCommand(CommandType::SET_DELAY_SYNC, 0, beats);
+}
+
+void AudioEngine::setReverbRoomSize(float roomSize)
+{
+    pushCommand(CommandType::SET_REVERB_ROOM_SIZE, 0, roomSize);
+}
+
+void AudioEngine::setReverbDamping(float damping)
+{
+    pushCommand(CommandType::SET_REVERB_DAMPING, 0, damping);
+}
+
+void AudioEngine::setReverbWidth(float width)
+{
+    pushCommand(CommandType::SET_REVERB_WIDTH, 0, width);
+}
+
+void AudioEngine::setConvolutionMix(float mix)
+{
+    pushCommand(CommandType::SET_CONVOLUTION_MIX, 0, mix);
+}
+
+void AudioEngine::loadImpulseResponse(const std::string& filename)
+{
     if (m_synthesizer) {
-        m_synthesizer->setDelay(delay);
+        m_synthesizer->loadImpulseResponse(filename);
     }
 }
 
+void AudioEngine::setStealPolicy(VoiceStealPolicy policy)
+{
+    pushCommand(CommandType::SET_STEAL_POLICY, static_cast<int>(policy), 0.0f);
+}
+
+void AudioEngine::setOversampling(int factor, OversamplingQuality quality)
+{
+    pushCommand(CommandType::SET_OVERSAMPLING, factor, static_cast<float>(quality));
+}
+
 void AudioEngine::startRecording()
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_recorder) {
-        m_recorder->startRecording();
-    }
+    m_recordingRequested = true;
+    pushCommand(CommandType::START_RECORDING, ++m_recordingSequence, 0.0f);
 }
 
 void AudioEngine::stopRecording()
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_recorder) {
-        m_recorder->stopRecording();
-    }
+    m_recordingRequested = false;
+    pushCommand(CommandType::STOP_RECORDING, ++m_recordingSequence, 0.0f);
 }
 
 bool AudioEngine::isRecording() const
 {
-    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(m_audioMutex));
-    return m_recorder ? m_recorder->isRecording() : false;
+    return m_recordingActive.load(std::memory_order_acquire);
 }
 
 void AudioEngine::startPlayback()
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_recorder) {
-        m_recorder->startPlayback();
-    }
+    pushCommand(CommandType::START_PLAYBACK, 0, 0.0f);
 }
 
 void AudioEngine::stopPlayback()
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_recorder) {
-        m_recorder->stopPlayback();
-    }
+    pushCommand(CommandType::STOP_PLAYBACK, 0, 0.0f);
 }
 
 bool AudioEngine::isPlaying() const
 {
-    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(m_audioMutex));
-    return m_recorder ? m_recorder->isPlaying() : false;
+    return m_playbackActive.load(std::memory_order_acquire);
 }
 
-void AudioEngine::exportToFile(const std::string& filename)
+bool AudioEngine::startStreamingRecording(const std::string& filename)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    if (m_recorder) {
-        // Check file extension (C++20 features)
-        if (filename.ends_with(".wav")) {
-            m_recorder->exportToWAV(filename);
-        } else if (filename.ends_with(".mid") || filename.ends_with(".midi")) {
-            m_recorder->exportToMIDI(filename);
-        } else {
-            m_recorder->exportNoteEvents(filename);
+    return m_streamingRecorder && m_streamingRecorder->start(filename);
+}
+
+void AudioEngine::stopStreamingRecording()
+{
+    if (m_streamingRecorder) {
+        m_streamingRecorder->stop();
+    }
+}
+
+bool AudioEngine::isStreamingRecording() const
+{
+    return m_streamingRecorder && m_streamingRecorder->isRecording();
+}
+
+bool AudioEngine::exportToFile(const std::string& filename)
+{
+    if (!m_recorder) {
+        return false;
+    }
+    
+    if (m_recordingRequested) {
+        std::cerr << "Stop recording before exporting" << std::endl;
+        return false;
+    }
+    
+    // The audio thread only touches the recorded data while recording, and a
+    // start clears it, so exporting is safe once it has applied the last
+    // start/stop. A stopped stream applies nothing until it restarts.
+    if (m_isRunning) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(EXPORT_WAIT_MS);
+        while (m_recordingAcknowledged.load(std::memory_order_acquire) != m_recordingSequence) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                std::cerr << "Recording did not stop in time, not exporting" << std::endl;
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    
+    // Check file extension (C++20 features)
+    if (filename.ends_with(".wav")) {
+        return m_recorder->exportToWAV(filename);
+    } else if (filename.ends_with(".mid") || filename.ends_with(".midi")) {
+        return m_recorder->exportToMIDI(filename);
+    }
+    return m_recorder->exportNoteEvents(filename);
+}
+
+bool AudioEngine::getSpectrum(std::vector<float>& spectrum)
+{
+    return m_spectrumAnalysis && m_spectrumAnalysis->getLatestSpectrum(spectrum);
+}
+
+void AudioEngine::setSpectrumSettings(const SpectrumSettings& settings)
+{
+    if (!m_spectrumAnalysis) {
+        return;
+    }
+    
+    // The audio thread only sees the tap, so the analysis can be swapped freely
+    m_spectrumAnalysis->stop();
+    SpectrumSettings analysisSettings = settings;
+    analysisSettings.sampleRate = m_sampleRate;
+    m_spectrumAnalysis = std::make_unique<SpectrumAnalysisThread>(m_spectrumTap, analysisSettings);
+    m_spectrumAnalysis->start();
+}
+
+SpectrumSettings AudioEngine::getSpectrumSettings() const
+{
+    return m_spectrumAnalysis ? m_spectrumAnalysis->getSettings() : SpectrumSettings();
+}
+
+ProfilerSnapshot AudioEngine::getProfilerSnapshot() const
+{
+    return m_profiler.snapshot();
+}
+
+void AudioEngine::resetProfiler()
+{
+    m_profiler.reset();
+}
+
+int AudioEngine::getMaxVoices() const
+{
+    return m_synthesizer ? m_synthesizer->getMaxVoices() : 0;
+}
+
+int AudioEngine::getActiveVoiceCount() const
+{
+    return m_synthesizer ? m_synthesizer->getActiveVoiceCount() : 0;
+}
+
+uint64_t AudioEngine::getVoiceStealCount() const
+{
+    return m_synthesizer ? m_synthesizer->getVoiceStealCount() : 0;
+}
+
+void AudioEngine::pushCommand(CommandType type, int intValue, float floatValue, int sampleOffset)
+{
+    AudioCommand command{type, intValue, floatValue, std::max(0, sampleOffset)};
+    if (!m_commandQueue.push(command)) {
+        std::cerr << "Audio command queue full, dropping command" << std::endl;
+    }
+}
+
+void AudioEngine::drainCommands()
+{
+    // Insertion sort keeps commands ordered by offset while preserving
+    // the order in which they were sent for equal offsets
+    AudioCommand command;
+    while (m_pendingCount < m_pendingCommands.size() && m_commandQueue.pop(command)) {
+        size_t pos = m_pendingCount++;
+        while (pos > 0 && m_pendingCommands[pos - 1].sampleOffset > command.sampleOffset) {
+            m_pendingCommands[pos] = m_pendingCommands[pos - 1];
+            --pos;
         }
+        m_pendingCommands[pos] = command;
     }
 }
 
-std::vector<float> AudioEngine::getFFTData()
+void AudioEngine::applyCommand(const AudioCommand& command)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
-    return m_fftBuffer;
+    switch (command.type) {
+        case CommandType::NOTE_ON:
+            m_synthesizer->noteOn(command.intValue, command.floatValue);
+            m_recorder->recordNoteEvent(command.intValue, command.floatValue, true);
+            break;
+        case CommandType::NOTE_OFF:
+            m_synthesizer->noteOff(command.intValue);
+            m_recorder->recordNoteEvent(command.intValue, 0.0f, false);
+            break;
+        case CommandType::SET_ATTACK:
+            m_synthesizer->setAttack(command.floatValue);
+            break;
+        case CommandType::SET_DECAY:
+            m_synthesizer->setDecay(command.floatValue);
+            break;
+        case CommandType::SET_SUSTAIN:
+            m_synthesizer->setSustain(command.floatValue);
+            break;
+        case CommandType::SET_RELEASE:
+            m_synthesizer->setRelease(command.floatValue);
+            break;
+        case CommandType::SET_ENVELOPE_CURVE:
+            m_synthesizer->setEnvelopeCurve(static_cast<EnvelopeCurve>(command.intValue));
+            break;
+        case CommandType::SET_WAVEFORM:
+            m_synthesizer->setWaveform(command.intValue);
+            break;
+        case CommandType::SET_OSCILLATOR_COUNT:
+            m_synthesizer->setOscillatorCount(command.intValue);
+            break;
+        case CommandType::SET_VIBRATO_RATE:
+            m_synthesizer->setVibratoRate(command.floatValue);
+            break;
+        case CommandType::SET_VIBRATO_DEPTH:
+            m_synthesizer->setVibratoDepth(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_TYPE:
+            m_synthesizer->setFilterType(static_cast<FilterType>(command.intValue));
+            break;
+        case CommandType::SET_FILTER_CUTOFF:
+            m_synthesizer->setFilterCutoff(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_RESONANCE:
+            m_synthesizer->setFilterResonance(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_ENVELOPE_AMOUNT:
+            m_synthesizer->setFilterEnvelopeAmount(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_KEY_TRACKING:
+            m_synthesizer->setFilterKeyTracking(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_ATTACK:
+            m_synthesizer->setFilterAttack(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_DECAY:
+            m_synthesizer->setFilterDecay(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_SUSTAIN:
+            m_synthesizer->setFilterSustain(command.floatValue);
+            break;
+        case CommandType::SET_FILTER_RELEASE:
+            m_synthesizer->setFilterRelease(command.floatValue);
+            break;
+        case CommandType::SET_PAN:
+            m_synthesizer->setPan(command.floatValue);
+            break;
+        case CommandType::SET_STEREO_SPREAD:
+            m_synthesizer->setStereoSpread(command.floatValue);
+            break;
+        case CommandType::SET_REVERB:
+            m_synthesizer->setReverb(command.floatValue);
+            break;
+        case CommandType::SET_DELAY:
+            m_synthesizer->setDelay(command.floatValue);
+            break;
+        case CommandType::SET_DELAY_MODE:
+            m_synthesizer->setDelayMode(static_cast<DelayMode>(command.intValue));
+            break;
+        case CommandType::SET_DELAY_TIME:
+            m_synthesizer->setDelayTime(command.floatValue);
+            break;
+        case CommandType::SET_DELAY_FEEDBACK:
+            m_synthesizer->setDelayFeedback(command.floatValue);
+            break;
+        case CommandType::SET_DELAY_MOD_RATE:
+            m_synthesizer->setDelayModulationRate(command.floatValue);
+            break;
+        case CommandType::SET_DELAY_MOD_DEPTH:
+            m_synthesizer->setDelayModulationDepth(command.floatValue);
+            break;
+        case CommandType::SET_TEMPO:
+            m_synthesizer->setTempo(command.floatValue);
+            break;
+        case CommandType::SET_DELAY_SYNC:
+            m_synthesizer->setDelaySync(command.floatValue);
+            break;
+        case CommandType::SET_REVERB_ROOM_SIZE:
+            m_synthesizer->setReverbRoomSize(command.floatValue);
+            break;
+        case CommandType::SET_REVERB_DAMPING:
+            m_synthesizer->setReverbDamping(command.floatValue);
+            break;
+        case CommandType::SET_REVERB_WIDTH:
+            m_synthesizer->setReverbWidth(command.floatValue);
+            break;
+        case CommandType::SET_CONVOLUTION_MIX:
+            m_synthesizer->setConvolutionMix(command.floatValue);
+            break;
+        case CommandType::SET_STEAL_POLICY:
+            m_synthesizer->setStealPolicy(static_cast<VoiceStealPolicy>(command.intValue));
+            break;
+        case CommandType::SET_OVERSAMPLING:
+            m_synthesizer->setOversampling(command.intValue,
+                                           static_cast<OversamplingQuality>(static_cast<int>(command.floatValue)));
+            break;
+        case CommandType::START_RECORDING:
+            m_recorder->startRecording();
+            m_recordingAcknowledged.store(command.intValue, std::memory_order_release);
+            break;
+        case CommandType::STOP_RECORDING:
+            m_recorder->stopRecording();
+            m_recordingAcknowledged.store(command.intValue, std::memory_order_release);
+            break;
+        case CommandType::START_PLAYBACK:
+            m_recorder->startPlayback();
+            break;
+        case CommandType::STOP_PLAYBACK:
+            m_recorder->stopPlayback();
+            break;
+    }
 }
 
 int AudioEngine::audioCallback(const void* inputBuffer, void* outputBuffer,
@@ -282,47 +629,132 @@ int AudioEngine::audioCallback(const void* inputBuffer, void* outputBuffer,
                               void* userData)
 {
     AudioEngine* engine = static_cast<AudioEngine*>(userData);
-    return engine->processAudio(static_cast<float*>(outputBuffer), framesPerBuffer);
+    
+    engine->m_profiler.beginCallback(framesPerBuffer);
+    int result = engine->processAudio(outputBuffer, framesPerBuffer);
+    engine->m_profiler.endCallback((statusFlags & paOutputUnderflow) != 0);
+    
+    return result;
 }
 
-int AudioEngine::processAudio(float* output, unsigned long framesPerBuffer)
+int AudioEngine::processAudio(void* output, unsigned long framesPerBuffer)
 {
-    std::lock_guard<std::mutex> lock(m_audioMutex);
+    if (!m_synthesizer || !m_recorder) {
+        writeSilence(output, framesPerBuffer);
+        return paContinue;
+    }
     
-    // Process playback events
-    if (m_recorder && m_recorder->isPlaying()) {
-        float deltaTime = static_cast<float>(framesPerBuffer) / static_cast<float>(m_sampleRate);
-        m_recorder->processPlayback(deltaTime);
-        
-        auto events = m_recorder->getEventsToPlay();
-        for (const auto& event : events) {
-            if (event.isNoteOn) {
-                m_synthesizer->noteOn(event.note, event.velocity);
-            } else {
-                m_synthesizer->noteOff(event.note);
+    {
+        CallbackProfiler::ScopedStage stage(&m_profiler, ProfilerStage::EVENTS);
+        drainCommands();
+    }
+    
+    // Render in segments, applying each command and playback event at its sample offset
+    unsigned long frame = 0;
+    size_t applied = 0;
+    while (frame < framesPerBuffer) {
+        unsigned long end = framesPerBuffer;
+        {
+            CallbackProfiler::ScopedStage stage(&m_profiler, ProfilerStage::EVENTS);
+            while (applied < m_pendingCount &&
+                   static_cast<unsigned long>(m_pendingCommands[applied].sampleOffset) <= frame) {
+                applyCommand(m_pendingCommands[applied++]);
+            }
+            playDueEvents();
+            
+            if (applied < m_pendingCount) {
+                end = std::min(end, static_cast<unsigned long>(m_pendingCommands[applied].sampleOffset));
+            }
+            const int64_t untilEvent = m_recorder->framesUntilNextEvent();
+            if (untilEvent >= 0 && static_cast<uint64_t>(untilEvent) < end - frame) {
+                end = frame + static_cast<unsigned long>(untilEvent);
             }
         }
+        
+        renderSamples(output, frame, end - frame);
+        m_recorder->advancePlayback(end - frame);
+        frame = end;
     }
     
-    // Generate audio
-    for (unsigned long i = 0; i < framesPerBuffer; ++i) {
-        float sample = 0.0f;
-        
-        if (m_synthesizer) {
-            sample = m_synthesizer->process();
+    // Commands scheduled past this block carry over to the next one
+    size_t remaining = 0;
+    for (size_t i = applied; i < m_pendingCount; ++i) {
+        m_pendingCommands[remaining] = m_pendingCommands[i];
+        m_pendingCommands[remaining].sampleOffset -= static_cast<int>(framesPerBuffer);
+        ++remaining;
+    }
+    m_pendingCount = remaining;
+    
+    m_recordingActive.store(m_recorder->isRecording(), std::memory_order_release);
+    m_playbackActive.store(m_recorder->isPlaying(), std::memory_order_release);
+    
+    return paContinue;
+}
+
+void AudioEngine::playDueEvents()
+{
+    while (const NoteEvent* event = m_recorder->nextDueEvent()) {
+        if (event->isNoteOn) {
+            m_synthesizer->noteOn(event->note, event->velocity);
+        } else {
+            m_synthesizer->noteOff(event->note);
         }
+    }
+}
+
+void AudioEngine::renderSamples(void* output, unsigned long offset, unsigned long frames)
+{
+    float* const* planes = m_outputBus.planes();
+    
+    while (frames > 0) {
+        const int count = static_cast<int>(std::min<unsigned long>(frames, OUTPUT_BLOCK_SIZE));
+        m_synthesizer->renderBlock(planes[0], planes[1], count);
         
-        output[i] = sample;
+        {
+            // Record audio samples
+            CallbackProfiler::ScopedStage stage(&m_profiler, ProfilerStage::RECORDER);
+            m_recorder->recordAudio(planes, count);
+            m_streamingRecorder->writePlanar(planes, count);
+        }
         
-        // Record audio sample
-        if (m_recorder) {
-            m_recorder->recordAudioSample(sample);
+        {
+            // Store samples for FFT analysis
+            CallbackProfiler::ScopedStage stage(&m_profiler, ProfilerStage::FFT_TAP);
+            m_outputBus.writeInterleaved(m_spectrumBuffer.data(), 1, count);
+            m_spectrumTap.write(m_spectrumBuffer.data(), count);
         }
         
-        // Store sample for FFT analysis
-        m_fftBuffer[m_fftBufferIndex] = sample;
-        m_fftBufferIndex = (m_fftBufferIndex + 1) % FFT_SIZE;
+        writeOutput(output, offset, count);
+        offset += count;
+        frames -= count;
+    }
+}
+
+void AudioEngine::writeOutput(void* output, unsigned long offset, int frames)
+{
+    if (m_interleaved) {
+        float* out = static_cast<float*>(output) + offset * m_outputChannels;
+        m_outputBus.writeInterleaved(out, m_outputChannels, frames);
+        return;
     }
     
-    return paContinue;
+    float* const* channels = static_cast<float* const*>(output);
+    for (int c = 0; c < m_outputChannels; ++c) {
+        m_outputPlanes[c] = channels[c] + offset;
+    }
+    m_outputBus.writePlanar(m_outputPlanes.data(), m_outputChannels, frames);
+}
+
+void AudioEngine::writeSilence(void* output, unsigned long frames)
+{
+    if (m_interleaved) {
+        float* out = static_cast<float*>(output);
+        std::fill(out, out + frames * m_outputChannels, 0.0f);
+        return;
+    }
+    
+    float* const* channels = static_cast<float* const*>(output);
+    for (int c = 0; c < m_outputChannels; ++c) {
+        std::fill(channels[c], channels[c] + frames, 0.0f);
+    }
 }
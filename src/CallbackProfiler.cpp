@@ -0,0 +1,131 @@
+#include "vsynth/CallbackProfiler.h"
+#include <algorithm>
+#include <bit>
+
+CallbackProfiler::CallbackProfiler()
+    : m_sampleRate(44100)
+    , m_resetRequested(false)
+    , m_frames(0)
+    , m_callbacks(0)
+    , m_underflows(0)
+    , m_deadlineMisses(0)
+    , m_lastLoad(0.0f)
+    , m_averageLoad(0.0f)
+    , m_peakLoad(0.0f)
+    , m_worstCallbackNanos(0)
+    , m_worstIntervalNanos(0)
+{
+    m_stageNanos.fill(0);
+    clear();
+}
+
+void CallbackProfiler::beginCallback(unsigned long frames)
+{
+    if (m_resetRequested.exchange(false, std::memory_order_relaxed)) {
+        clear();
+    }
+
+    m_previousStart = m_callbackStart;
+    m_callbackStart = Clock::now();
+    m_frames = frames;
+    m_stageNanos.fill(0);
+}
+
+void CallbackProfiler::addStageTime(ProfilerStage stage, Clock::duration time)
+{
+    m_stageNanos[static_cast<int>(stage)] +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+void CallbackProfiler::endCallback(bool outputUnderflow)
+{
+    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - m_callbackStart).count();
+    const uint64_t callbacks = m_callbacks.load(std::memory_order_relaxed) + 1;
+
+    // The first interval after start/reset has no previous callback
+    if (callbacks > 1) {
+        const uint64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            m_callbackStart - m_previousStart).count();
+        storeMax(m_worstIntervalNanos, interval);
+    }
+
+    const double period = 1e9 * static_cast<double>(m_frames) / static_cast<double>(m_sampleRate);
+    const float load = period > 0.0 ? static_cast<float>(elapsed / period) : 0.0f;
+
+    // Roughly one second time constant at the current callback rate
+    const float smoothing = static_cast<float>(std::min(1.0, period / 1e9));
+    const float average = m_averageLoad.load(std::memory_order_relaxed);
+    m_averageLoad.store(callbacks == 1 ? load : average + (load - average) * smoothing,
+                        std::memory_order_relaxed);
+    m_lastLoad.store(load, std::memory_order_relaxed);
+    if (load > m_peakLoad.load(std::memory_order_relaxed)) {
+        m_peakLoad.store(load, std::memory_order_relaxed);
+    }
+
+    if (load >= 1.0f) {
+        increment(m_deadlineMisses);
+    }
+    if (outputUnderflow) {
+        increment(m_underflows);
+    }
+
+    const int loadBin = std::min(ProfilerSnapshot::LOAD_BINS - 1, static_cast<int>(load * 20.0f));
+    increment(m_loadHistogram[loadBin]);
+
+    const uint64_t micros = elapsed / 1000;
+    const int durationBin = std::min(ProfilerSnapshot::DURATION_BINS - 1,
+                                     micros == 0 ? 0 : static_cast<int>(std::bit_width(micros)) - 1);
+    increment(m_durationHistogram[durationBin]);
+
+    storeMax(m_worstCallbackNanos, elapsed);
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        m_stageTotalNanos[i].store(m_stageTotalNanos[i].load(std::memory_order_relaxed) + m_stageNanos[i],
+                                   std::memory_order_relaxed);
+        storeMax(m_stageWorstNanos[i], m_stageNanos[i]);
+    }
+
+    m_callbacks.store(callbacks, std::memory_order_relaxed);
+}
+
+ProfilerSnapshot CallbackProfiler::snapshot() const
+{
+    ProfilerSnapshot result;
+    result.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    result.underflows = m_underflows.load(std::memory_order_relaxed);
+    result.deadlineMisses = m_deadlineMisses.load(std::memory_order_relaxed);
+    result.lastLoad = m_lastLoad.load(std::memory_order_relaxed);
+    result.averageLoad = m_averageLoad.load(std::memory_order_relaxed);
+    result.peakLoad = m_peakLoad.load(std::memory_order_relaxed);
+    result.worstCallbackMicros = m_worstCallbackNanos.load(std::memory_order_relaxed) / 1000.0;
+    result.worstIntervalMicros = m_worstIntervalNanos.load(std::memory_order_relaxed) / 1000.0;
+
+    const double callbacks = static_cast<double>(std::max<uint64_t>(1, result.callbacks));
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        result.stageAverageMicros[i] = m_stageTotalNanos[i].load(std::memory_order_relaxed) / callbacks / 1000.0;
+        result.stageWorstMicros[i] = m_stageWorstNanos[i].load(std::memory_order_relaxed) / 1000.0;
+    }
+    for (int i = 0; i < ProfilerSnapshot::LOAD_BINS; ++i) {
+        result.loadHistogram[i] = m_loadHistogram[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < ProfilerSnapshot::DURATION_BINS; ++i) {
+        result.durationHistogram[i] = m_durationHistogram[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void CallbackProfiler::clear()
+{
+    m_callbacks.store(0, std::memory_order_relaxed);
+    m_underflows.store(0, std::memory_order_relaxed);
+    m_deadlineMisses.store(0, std::memory_order_relaxed);
+    m_lastLoad.store(0.0f, std::memory_order_relaxed);
+    m_averageLoad.store(0.0f, std::memory_order_relaxed);
+    m_peakLoad.store(0.0f, std::memory_order_relaxed);
+    m_worstCallbackNanos.store(0, std::memory_order_relaxed);
+    m_worstIntervalNanos.store(0, std::memory_order_relaxed);
+    for (auto& value : m_stageTotalNanos) value.store(0, std::memory_order_relaxed);
+    for (auto& value : m_stageWorstNanos) value.store(0, std::memory_order_relaxed);
+    for (auto& value : m_loadHistogram) value.store(0, std::memory_order_relaxed);
+    for (auto& value : m_durationHistogram) value.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,466 @@
+#include "vsynth/ConvolutionReverb.h"
+#include "vsynth/FFTAnalyzer.h"
+#include "vsynth/WavReader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifdef VSYNTH_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Sinc zero crossings on each side of the resampling filter
+constexpr int RESAMPLE_ZERO_CROSSINGS = 16;
+// Trailing IR samples this far below the peak are dropped (-100 dB)
+constexpr float SILENCE_THRESHOLD = 1e-5f;
+
+// Band-limited (Blackman-windowed sinc) sample rate conversion
+std::vector<float> resample(const std::vector<float>& input, int fromRate, int toRate)
+{
+    const double step = static_cast<double>(fromRate) / toRate;
+    // Lowering the rate needs the cutoff below the new Nyquist frequency
+    const double cutoff = std::min(1.0, 1.0 / step);
+    const double halfWidth = RESAMPLE_ZERO_CROSSINGS / cutoff;
+    const size_t frames = static_cast<size_t>(input.size() / step);
+    const long last = static_cast<long>(input.size()) - 1;
+
+    std::vector<float> output(frames);
+    for (size_t n = 0; n < frames; ++n) {
+        const double position = n * step;
+        const long first = std::max(0L, static_cast<long>(std::ceil(position - halfWidth)));
+        const long end = std::min(last, static_cast<long>(std::floor(position + halfWidth)));
+
+        double sum = 0.0;
+        for (long k = first; k <= end; ++k) {
+            const double x = k - position;
+            const double window = 0.42 + 0.5 * std::cos(M_PI * x / halfWidth)
+                                + 0.08 * std::cos(2.0 * M_PI * x / halfWidth);
+            const double phase = M_PI * cutoff * x;
+            const double sinc = (std::abs(phase) < 1e-9) ? 1.0 : std::sin(phase) / phase;
+            sum += input[k] * cutoff * sinc * window;
+        }
+        output[n] = static_cast<float>(sum);
+    }
+    return output;
+}
+
+} // namespace
+
+ConvolutionReverb::Segment::Segment(int blockSize, int partitions)
+    : blockSize(blockSize)
+    , partitions(partitions)
+    , stride((2 * (blockSize + 1) + 15) / 16 * 16)
+    , phases(blockSize / HEAD_LENGTH)
+    , newestSpectrum(0)
+    , inputFill(0)
+    , outputPosition(0)
+    , phase(phases)
+{
+    filters.assign(static_cast<size_t>(partitions) * stride, 0.0f);
+    spectra.assign(static_cast<size_t>(partitions) * stride, 0.0f);
+    input.assign(2 * blockSize, 0.0f);
+    accumulator.assign(stride, 0.0f);
+    inverse.assign(2 * blockSize, 0.0f);
+    output.assign(blockSize, 0.0f);
+    nextOutput.assign(blockSize, 0.0f);
+
+    // Measuring overwrites the arrays, which are cleared again afterwards.
+    // Every spectrum starts on a cache line, so the forward plan can be
+    // executed on any slot of filters or spectra.
+    {
+        std::lock_guard<std::mutex> lock(FFTAnalyzer::plannerMutex());
+        forwardPlan = fftwf_plan_dft_r2c_1d(2 * blockSize, input.data(),
+                                            reinterpret_cast<fftwf_complex*>(spectra.data()), FFTW_MEASURE);
+        inversePlan = fftwf_plan_dft_c2r_1d(2 * blockSize, reinterpret_cast<fftwf_complex*>(accumulator.data()),
+                                            inverse.data(), FFTW_MEASURE);
+    }
+    std::fill(spectra.begin(), spectra.end(), 0.0f);
+    std::fill(input.begin(), input.end(), 0.0f);
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+}
+
+ConvolutionReverb::Segment::~Segment()
+{
+    std::lock_guard<std::mutex> lock(FFTAnalyzer::plannerMutex());
+    fftwf_destroy_plan(forwardPlan);
+    fftwf_destroy_plan(inversePlan);
+}
+
+ConvolutionReverb::ConvolutionReverb(int sampleRate)
+    : m_sampleRate(sampleRate)
+    , m_mix(0.3f)
+    , m_kernel(nullptr)
+    , m_pending(nullptr)
+    , m_retired(nullptr)
+    , m_blockFill(0)
+    , m_loading(false)
+    , m_loadSucceeded(false)
+{
+    switch (simd::detect()) {
+#ifdef VSYNTH_X86
+        case simd::InstructionSet::AVX2:
+            m_multiplyKernel = multiplyAccumulateAVX2;
+            m_headKernel = headAVX2;
+            break;
+#endif
+        default:
+            m_multiplyKernel = multiplyAccumulateScalar;
+            m_headKernel = headScalar;
+            break;
+    }
+
+    m_history.assign(2 * HEAD_LENGTH - 1, 0.0f);
+    m_wet.assign(HEAD_LENGTH, 0.0f);
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+    delete m_kernel;
+    delete m_pending.exchange(nullptr);
+    delete m_retired.exchange(nullptr);
+}
+
+void ConvolutionReverb::loadImpulseResponse(const std::string& filename)
+{
+    waitForLoad();
+    m_loading.store(true, std::memory_order_release);
+
+    m_loader = std::thread([this, filename]() {
+        WavReader reader;
+        if (!reader.load(filename)) {
+            m_loadSucceeded.store(false, std::memory_order_relaxed);
+            m_loading.store(false, std::memory_order_release);
+            return;
+        }
+
+        // Mix down to mono
+        const int channels = reader.channels();
+        const std::vector<float>& interleaved = reader.samples();
+        std::vector<float> mono(reader.frames(), 0.0f);
+        for (size_t i = 0; i < mono.size(); ++i) {
+            float sum = 0.0f;
+            for (int c = 0; c < channels; ++c) {
+                sum += interleaved[i * channels + c];
+            }
+            mono[i] = sum / channels;
+        }
+
+        prepare(std::move(mono), reader.sampleRate());
+    });
+}
+
+void ConvolutionReverb::loadImpulseResponse(std::vector<float> samples, int sampleRate)
+{
+    waitForLoad();
+    m_loading.store(true, std::memory_order_release);
+
+    m_loader = std::thread([this, samples = std::move(samples), sampleRate]() mutable {
+        prepare(std::move(samples), sampleRate);
+    });
+}
+
+bool ConvolutionReverb::waitForLoad()
+{
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+    reclaimRetired();
+    return m_loadSucceeded.load(std::memory_order_relaxed);
+}
+
+void ConvolutionReverb::prepare(std::vector<float> samples, int sampleRate)
+{
+    std::vector<float> ir = (sampleRate != m_sampleRate && sampleRate > 0)
+                          ? resample(samples, sampleRate, m_sampleRate)
+                          : std::move(samples);
+
+    const size_t maxLength = static_cast<size_t>(MAX_IR_SECONDS) * m_sampleRate;
+    if (ir.size() > maxLength) {
+        std::cerr << "Impulse response truncated to " << MAX_IR_SECONDS << " seconds" << std::endl;
+        ir.resize(maxLength);
+    }
+
+    // Trailing silence would only cost partitions
+    float peak = 0.0f;
+    for (float sample : ir) {
+        peak = std::max(peak, std::abs(sample));
+    }
+    size_t length = ir.size();
+    while (length > 0 && std::abs(ir[length - 1]) <= peak * SILENCE_THRESHOLD) {
+        --length;
+    }
+    ir.resize(length);
+
+    // Unit energy, so the wet level doesn't depend on the IR's length or gain
+    double energy = 0.0;
+    for (float sample : ir) {
+        energy += static_cast<double>(sample) * sample;
+    }
+    if (energy <= 0.0) {
+        std::cerr << "Impulse response is silent" << std::endl;
+        m_loadSucceeded.store(false, std::memory_order_relaxed);
+        m_loading.store(false, std::memory_order_release);
+        return;
+    }
+    const float gain = static_cast<float>(1.0 / std::sqrt(energy));
+    for (float& sample : ir) {
+        sample *= gain;
+    }
+
+    publish(buildKernel(ir));
+    m_loadSucceeded.store(true, std::memory_order_relaxed);
+    m_loading.store(false, std::memory_order_release);
+}
+
+ConvolutionReverb::Kernel* ConvolutionReverb::buildKernel(const std::vector<float>& ir)
+{
+    Kernel* kernel = new Kernel;
+    const int length = static_cast<int>(ir.size());
+
+    kernel->head.assign(HEAD_LENGTH, 0.0f);
+    for (int t = 0; t < std::min(length, HEAD_LENGTH); ++t) {
+        kernel->head[HEAD_LENGTH - 1 - t] = ir[t];
+    }
+
+    // A segment with blockSize partitions has a latency of one block
+    // (two once its work is spread), so the next, larger segment starts two
+    // of its own blocks in and the smaller ones cover everything before
+    int blockSize = HEAD_LENGTH;
+    int offset = HEAD_LENGTH;
+    while (offset < length) {
+        const int nextBlockSize = std::min(blockSize * PARTITION_GROWTH, MAX_PARTITION_SIZE);
+        const int end = (nextBlockSize > blockSize) ? std::min(length, 2 * nextBlockSize) : length;
+        const int partitions = (end - offset + blockSize - 1) / blockSize;
+
+        auto segment = std::make_unique<Segment>(blockSize, partitions);
+        const float scale = 1.0f / (2.0f * blockSize);
+        for (int p = 0; p < partitions; ++p) {
+            const int start = offset + p * blockSize;
+            const int taps = std::min(blockSize, end - start);
+            std::fill(segment->input.begin(), segment->input.end(), 0.0f);
+            std::copy(ir.begin() + start, ir.begin() + start + taps, segment->input.begin());
+
+            float* filter = segment->filters.data() + static_cast<size_t>(p) * segment->stride;
+            fftwf_execute_dft_r2c(segment->forwardPlan, segment->input.data(),
+                                  reinterpret_cast<fftwf_complex*>(filter));
+            for (int i = 0; i < 2 * (blockSize + 1); ++i) {
+                filter[i] *= scale;
+            }
+        }
+        std::fill(segment->input.begin(), segment->input.end(), 0.0f);
+
+        kernel->segments.push_back(std::move(segment));
+        offset = end;
+        blockSize = nextBlockSize;
+    }
+
+    return kernel;
+}
+
+void ConvolutionReverb::publish(Kernel* kernel)
+{
+    reclaimRetired();
+    // An IR the audio thread never picked up is simply replaced
+    delete m_pending.exchange(kernel, std::memory_order_acq_rel);
+}
+
+void ConvolutionReverb::reclaimRetired()
+{
+    delete m_retired.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+float ConvolutionReverb::process(float input)
+{
+    processBlock(&input, 1);
+    return input;
+}
+
+void ConvolutionReverb::processBlock(float* buffer, int frames)
+{
+    render(buffer, nullptr, frames);
+}
+
+void ConvolutionReverb::processStereo(float* left, float* right, int frames)
+{
+    render(left, right, frames);
+}
+
+void ConvolutionReverb::render(float* left, float* right, int frames)
+{
+    // Take a new IR only once the previous replaced one was reclaimed, so
+    // the audio thread never frees anything
+    if (m_pending.load(std::memory_order_acquire) && !m_retired.load(std::memory_order_acquire)) {
+        if (Kernel* next = m_pending.exchange(nullptr, std::memory_order_acq_rel)) {
+            m_retired.store(m_kernel, std::memory_order_release);
+            m_kernel = next;
+        }
+    }
+    if (!m_kernel) {
+        return;
+    }
+
+    const float dry = 1.0f - m_mix;
+    const float wet = m_mix;
+    float* block = m_history.data() + HEAD_LENGTH - 1;
+
+    int i = 0;
+    while (i < frames) {
+        const int count = std::min(frames - i, HEAD_LENGTH - m_blockFill);
+        if (right) {
+            for (int j = 0; j < count; ++j) {
+                block[m_blockFill + j] = 0.5f * (left[i + j] + right[i + j]);
+            }
+        } else {
+            std::memcpy(block + m_blockFill, left + i, count * sizeof(float));
+        }
+
+        // The head taps include the current sample; every segment's output
+        // for this block was computed from earlier blocks
+        m_headKernel(m_history.data() + m_blockFill, m_kernel->head.data(), m_wet.data(), count);
+        for (const auto& segment : m_kernel->segments) {
+            const float* tail = segment->output.data() + segment->outputPosition + m_blockFill;
+            for (int j = 0; j < count; ++j) {
+                m_wet[j] += tail[j];
+            }
+        }
+
+        for (int j = 0; j < count; ++j) {
+            left[i + j] = left[i + j] * dry + m_wet[j] * wet;
+        }
+        if (right) {
+            for (int j = 0; j < count; ++j) {
+                right[i + j] = right[i + j] * dry + m_wet[j] * wet;
+            }
+        }
+
+        m_blockFill += count;
+        i += count;
+
+        if (m_blockFill == HEAD_LENGTH) {
+            for (const auto& segment : m_kernel->segments) {
+                advanceSegment(*segment, block);
+            }
+            std::memmove(m_history.data(), m_history.data() + HEAD_LENGTH, (HEAD_LENGTH - 1) * sizeof(float));
+            m_blockFill = 0;
+        }
+    }
+}
+
+void ConvolutionReverb::advanceSegment(Segment& segment, const float* block)
+{
+    std::memcpy(segment.input.data() + segment.blockSize + segment.inputFill, block, HEAD_LENGTH * sizeof(float));
+    segment.inputFill += HEAD_LENGTH;
+
+    // A full input block: transform it into the delay line and start
+    // multiplying it (and the older spectra) with the partitions
+    if (segment.inputFill == segment.blockSize) {
+        segment.newestSpectrum = (segment.newestSpectrum + 1) % segment.partitions;
+        float* spectrum = segment.spectra.data() + static_cast<size_t>(segment.newestSpectrum) * segment.stride;
+        fftwf_execute_dft_r2c(segment.forwardPlan, segment.input.data(), reinterpret_cast<fftwf_complex*>(spectrum));
+        std::memcpy(segment.input.data(), segment.input.data() + segment.blockSize, segment.blockSize * sizeof(float));
+        segment.inputFill = 0;
+        segment.phase = 0;
+    }
+
+    // One slice of the partitions per block; the inverse transform follows the last
+    if (segment.phase < segment.phases) {
+        const int first = segment.phase * segment.partitions / segment.phases;
+        const int last = (segment.phase + 1) * segment.partitions / segment.phases;
+        for (int p = first; p < last; ++p) {
+            int slot = segment.newestSpectrum - p;
+            if (slot < 0) {
+                slot += segment.partitions;
+            }
+            m_multiplyKernel(segment.spectra.data() + static_cast<size_t>(slot) * segment.stride,
+                             segment.filters.data() + static_cast<size_t>(p) * segment.stride,
+                             segment.accumulator.data(), segment.stride / 2);
+        }
+
+        if (++segment.phase == segment.phases) {
+            fftwf_execute(segment.inversePlan);
+            // Overlap-save: only the second half is free of wrap-around
+            std::memcpy(segment.nextOutput.data(), segment.inverse.data() + segment.blockSize,
+                        segment.blockSize * sizeof(float));
+            std::fill(segment.accumulator.begin(), segment.accumulator.end(), 0.0f);
+        }
+    }
+
+    segment.outputPosition += HEAD_LENGTH;
+    if (segment.outputPosition == segment.blockSize) {
+        std::swap(segment.output, segment.nextOutput);
+        segment.outputPosition = 0;
+    }
+}
+
+void ConvolutionReverb::setMix(float mix)
+{
+    m_mix = std::max(0.0f, std::min(1.0f, mix));
+}
+
+void ConvolutionReverb::multiplyAccumulateScalar(const float* a, const float* b, float* acc, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const float ar = a[2 * i];
+        const float ai = a[2 * i + 1];
+        const float br = b[2 * i];
+        const float bi = b[2 * i + 1];
+        acc[2 * i] += ar * br - ai * bi;
+        acc[2 * i + 1] += ar * bi + ai * br;
+    }
+}
+
+void ConvolutionReverb::headScalar(const float* in, const float* taps, float* out, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        float sum = 0.0f;
+        for (int t = 0; t < HEAD_LENGTH; ++t) {
+            sum += taps[t] * in[i + t];
+        }
+        out[i] = sum;
+    }
+}
+
+#ifdef VSYNTH_X86
+VSYNTH_TARGET_AVX2 void ConvolutionReverb::multiplyAccumulateAVX2(const float* a, const float* b, float* acc, int count)
+{
+    // Four complex values per vector, real and imaginary parts interleaved
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256 va = _mm256_loadu_ps(a + 2 * i);
+        const __m256 vb = _mm256_loadu_ps(b + 2 * i);
+        const __m256 bReal = _mm256_moveldup_ps(vb);
+        const __m256 bImag = _mm256_movehdup_ps(vb);
+        const __m256 aSwapped = _mm256_permute_ps(va, 0xB1);
+        // Even lanes ar * br - ai * bi, odd lanes ai * br + ar * bi
+        const __m256 product = _mm256_fmaddsub_ps(va, bReal, _mm256_mul_ps(aSwapped, bImag));
+        _mm256_storeu_ps(acc + 2 * i, _mm256_add_ps(_mm256_loadu_ps(acc + 2 * i), product));
+    }
+    multiplyAccumulateScalar(a + 2 * i, b + 2 * i, acc + 2 * i, count - i);
+}
+
+VSYNTH_TARGET_AVX2 void ConvolutionReverb::headAVX2(const float* in, const float* taps, float* out, int count)
+{
+    // Eight outputs per iteration, four accumulators to hide the FMA latency
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        __m256 sum2 = _mm256_setzero_ps();
+        __m256 sum3 = _mm256_setzero_ps();
+        for (int t = 0; t < HEAD_LENGTH; t += 4) {
+            sum0 = _mm256_fmadd_ps(_mm256_set1_ps(taps[t]), _mm256_loadu_ps(in + i + t), sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_set1_ps(taps[t + 1]), _mm256_loadu_ps(in + i + t + 1), sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_set1_ps(taps[t + 2]), _mm256_loadu_ps(in + i + t + 2), sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_set1_ps(taps[t + 3]), _mm256_loadu_ps(in + i + t + 3), sum3);
+        }
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3)));
+    }
+    headScalar(in + i, taps, out + i, count - i);
+}
+#endif
@@ -0,0 +1,20 @@
+#include "vsynth/DelayLine.h"
+#include <algorithm>
+
+DelayLine::DelayLine(int maxDelay)
+    : m_writePosition(0)
+    , m_maxDelay(std::max(2, maxDelay))
+{
+    // Interpolated reads look up to two samples past the delay
+    uint32_t size = 1;
+    while (size < static_cast<uint32_t>(m_maxDelay) + 3) {
+        size *= 2;
+    }
+    m_buffer.assign(size, 0.0f);
+    m_mask = size - 1;
+}
+
+void DelayLine::clear()
+{
+    std::fill(m_buffer.begin(), m_buffer.end(), 0.0f);
+}
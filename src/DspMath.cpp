@@ -0,0 +1,17 @@
+#include "vsynth/DspMath.h"
+
+namespace dsp {
+
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double quarterSquare = 0.25 * x * x;
+    for (int k = 1; k < 64 && term > sum * 1e-12; ++k) {
+        term *= quarterSquare / (static_cast<double>(k) * k);
+        sum += term;
+    }
+    return sum;
+}
+
+} // namespace dsp
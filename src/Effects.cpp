@@ -2,44 +2,296 @@
 #include <algorithm>
 #include <cmath>
 
+#ifdef VSYNTH_X86
+#include <immintrin.h>
+#endif
+
 // DelayEffect Implementation
+namespace {
+
+// Centre delay and largest sweep of the modulated modes, in seconds
+constexpr float CHORUS_DELAY = 0.02f;
+constexpr float CHORUS_SWEEP = 0.008f;
+constexpr float FLANGER_DELAY = 0.003f;
+constexpr float FLANGER_SWEEP = 0.0025f;
+// Shortest delay the interpolated reads support
+constexpr double MIN_DELAY_SAMPLES = 2.0;
+constexpr float TWO_PI = 6.28318530718f;
+
+} // namespace
+
 DelayEffect::DelayEffect(int sampleRate, float maxDelayTime)
     : m_sampleRate(sampleRate)
+    , m_mode(DelayMode::ECHO)
+    , m_interpolation(DelayInterpolation::LAGRANGE)
     , m_delayTime(0.3f)
     , m_feedback(0.3f)
     , m_mix(0.3f)
-    , m_writeIndex(0)
-    , m_readIndex(0)
+    , m_modulationRate(0.5f)
+    , m_modulationDepth(0.5f)
+    , m_tempo(120.0f)
+    , m_syncBeats(0.0f)
+    , m_left(static_cast<int>(maxDelayTime * sampleRate))
+    , m_right(static_cast<int>(maxDelayTime * sampleRate))
+    , m_targetDelay(MIN_DELAY_SAMPLES)
+    , m_targetSweep(0.0f)
+    , m_delay(MIN_DELAY_SAMPLES)
+    , m_sweep(0.0f)
+    , m_echoWhole(0)
+    , m_echoCoefficients{}
+    , m_lfoSin(0.0f)
+    , m_lfoCos(1.0f)
+    , m_allpassTuning(0.0)
+    , m_allpassDelay(1)
+    , m_allpassCoefficient(0.0f)
+    , m_allpassLeft(0.0f)
+    , m_allpassRight(0.0f)
 {
-    m_bufferSize = static_cast<int>(maxDelayTime * sampleRate);
-    m_delayBuffer.resize(m_bufferSize, 0.0f);
+    m_smoothing = 1.0 - std::exp(-1.0 / (SMOOTHING_TIME * sampleRate));
+    m_scratch.resize(MAX_BLOCK_SIZE, 0.0f);
+    setModulationRate(m_modulationRate);
+    
+    // Start at the initial time rather than gliding up to it
+    updateTargets();
+    m_delay = m_targetDelay;
+    updateEchoWeights();
+    m_sweep = m_targetSweep;
 }
 
 float DelayEffect::process(float input)
 {
-    // Calculate read index based on delay time
-    int delaySamples = static_cast<int>(m_delayTime * m_sampleRate);
-    m_readIndex = m_writeIndex - delaySamples;
-    if (m_readIndex < 0) {
-        m_readIndex += m_bufferSize;
+    processBlock(&input, 1);
+    return input;
+}
+
+void DelayEffect::processBlock(float* buffer, int frames)
+{
+    // A mono echo only needs one line
+    if (m_mode == DelayMode::ECHO) {
+        if (m_interpolation == DelayInterpolation::ALLPASS) {
+            renderAllpass<false>(buffer, nullptr, frames);
+        } else {
+            renderEcho<false>(buffer, nullptr, frames);
+        }
+        return;
     }
     
-    // Read delayed sample
-    float delayedSample = m_delayBuffer[m_readIndex];
+    for (int offset = 0; offset < frames; offset += MAX_BLOCK_SIZE) {
+        const int count = std::min(MAX_BLOCK_SIZE, frames - offset);
+        float* block = buffer + offset;
+        
+        std::copy(block, block + count, m_scratch.begin());
+        processStereo(block, m_scratch.data(), count);
+        for (int i = 0; i < count; ++i) {
+            block[i] = 0.5f * (block[i] + m_scratch[i]);
+        }
+    }
+}
+
+void DelayEffect::processStereo(float* left, float* right, int frames)
+{
+    if (m_mode == DelayMode::CHORUS || m_mode == DelayMode::FLANGER) {
+        renderModulated(left, right, frames);
+    } else if (m_interpolation == DelayInterpolation::ALLPASS) {
+        renderAllpass<true>(left, right, frames);
+    } else {
+        renderEcho<true>(left, right, frames);
+    }
+}
+
+template <bool Stereo>
+void DelayEffect::renderEcho(float* left, float* right, int frames)
+{
+    const float dry = 1.0f - m_mix;
+    const float wet = m_mix;
+    const float feedback = m_feedback;
+    const bool pingPong = Stereo && m_mode == DelayMode::PING_PONG;
+    // Once the glide has settled the interpolation weights stay cached
+    const bool gliding = m_delay != m_targetDelay;
+    double delay = m_delay;
+    int whole = m_echoWhole;
+    float* coefficients = m_echoCoefficients;
     
-    // Write new sample with feedback
-    m_delayBuffer[m_writeIndex] = input + (delayedSample * m_feedback);
+    for (int i = 0; i < frames; ++i) {
+        // Both lines are read at the same delay, so they share the weights
+        if (gliding) {
+            delay += (m_targetDelay - delay) * m_smoothing;
+            whole = static_cast<int>(delay);
+            DelayLine::lagrangeCoefficients(static_cast<float>(delay - whole), coefficients);
+        }
+        const float delayedLeft = m_left.readInterpolated(whole, coefficients);
+        
+        if constexpr (Stereo) {
+            const float delayedRight = m_right.readInterpolated(whole, coefficients);
+            if (pingPong) {
+                // Mono input into the left line; each line feeds the other
+                m_left.write(0.5f * (left[i] + right[i]) + delayedRight * feedback);
+                m_right.write(delayedLeft * feedback);
+            } else {
+                m_left.write(left[i] + delayedLeft * feedback);
+                m_right.write(right[i] + delayedRight * feedback);
+            }
+            right[i] = right[i] * dry + delayedRight * wet;
+        } else {
+            m_left.write(left[i] + delayedLeft * feedback);
+        }
+        left[i] = left[i] * dry + delayedLeft * wet;
+    }
+    
+    m_echoWhole = whole;
+    settleDelay(delay);
+}
+
+template <bool Stereo>
+void DelayEffect::renderAllpass(float* left, float* right, int frames)
+{
+    const float dry = 1.0f - m_mix;
+    const float wet = m_mix;
+    const float feedback = m_feedback;
+    const bool pingPong = Stereo && m_mode == DelayMode::PING_PONG;
+    double delay = m_delay;
+    
+    for (int i = 0; i < frames; ++i) {
+        delay += (m_targetDelay - delay) * m_smoothing;
+        
+        // Retuning takes a division, so it only happens while the delay
+        // glides. Fractions in [0.1, 1.1) keep the coefficient away from
+        // -1, where the filter would barely decay.
+        if (delay != m_allpassTuning) {
+            m_allpassTuning = delay;
+            m_allpassDelay = static_cast<int>(delay - 0.1);
+            const float fraction = static_cast<float>(delay - m_allpassDelay);
+            m_allpassCoefficient = (1.0f - fraction) / (1.0f + fraction);
+        }
+        
+        // y[n] = c * x[n - d] + x[n - d - 1] - c * y[n - 1]
+        const float c = m_allpassCoefficient;
+        const float delayedLeft = c * (m_left.read(m_allpassDelay) - m_allpassLeft) + m_left.read(m_allpassDelay + 1);
+        m_allpassLeft = delayedLeft;
+        
+        if constexpr (Stereo) {
+            const float delayedRight = c * (m_right.read(m_allpassDelay) - m_allpassRight)
+                                     + m_right.read(m_allpassDelay + 1);
+            m_allpassRight = delayedRight;
+            if (pingPong) {
+                m_left.write(0.5f * (left[i] + right[i]) + delayedRight * feedback);
+                m_right.write(delayedLeft * feedback);
+            } else {
+                m_left.write(left[i] + delayedLeft * feedback);
+                m_right.write(right[i] + delayedRight * feedback);
+            }
+            right[i] = right[i] * dry + delayedRight * wet;
+        } else {
+            m_left.write(left[i] + delayedLeft * feedback);
+        }
+        left[i] = left[i] * dry + delayedLeft * wet;
+    }
+    
+    settleDelay(delay);
+}
+
+void DelayEffect::renderModulated(float* left, float* right, int frames)
+{
+    const float dry = 1.0f - m_mix;
+    const float wet = m_mix;
+    const float feedback = (m_mode == DelayMode::CHORUS) ? 0.0f : m_feedback;
+    double delay = m_delay;
+    float sweep = m_sweep;
+    float lfoSin = m_lfoSin;
+    float lfoCos = m_lfoCos;
+    
+    for (int i = 0; i < frames; ++i) {
+        delay += (m_targetDelay - delay) * m_smoothing;
+        sweep += (m_targetSweep - sweep) * m_smoothing;
+        
+        const float nextSin = lfoSin * m_lfoStepCos + lfoCos * m_lfoStepSin;
+        lfoCos = lfoCos * m_lfoStepCos - lfoSin * m_lfoStepSin;
+        lfoSin = nextSin;
+        
+        // The right channel sweeps a quarter cycle behind the left
+        const float centre = static_cast<float>(delay);
+        const float delayedLeft = m_left.readLagrange(centre + sweep * lfoSin);
+        const float delayedRight = m_right.readLagrange(centre + sweep * lfoCos);
+        
+        m_left.write(left[i] + delayedLeft * feedback);
+        m_right.write(right[i] + delayedRight * feedback);
+        left[i] = left[i] * dry + delayedLeft * wet;
+        right[i] = right[i] * dry + delayedRight * wet;
+    }
+    
+    // Rounding lets the phasor's length drift; pull it back to one
+    // (first-order inverse square root, no division)
+    const float gain = 1.5f - 0.5f * (lfoSin * lfoSin + lfoCos * lfoCos);
+    m_lfoSin = lfoSin * gain;
+    m_lfoCos = lfoCos * gain;
+    settleDelay(delay);
+    m_sweep = sweep;
+}
+
+void DelayEffect::settleDelay(double delay)
+{
+    // Snap the last millionth of a sample so the glide actually ends
+    if (std::abs(m_targetDelay - delay) < 1e-6 && delay != m_targetDelay) {
+        m_delay = m_targetDelay;
+        updateEchoWeights();
+    } else {
+        m_delay = delay;
+    }
+}
+
+void DelayEffect::updateEchoWeights()
+{
+    m_echoWhole = static_cast<int>(m_delay);
+    DelayLine::lagrangeCoefficients(static_cast<float>(m_delay - m_echoWhole), m_echoCoefficients);
+}
+
+void DelayEffect::updateTargets()
+{
+    const float sampleRate = static_cast<float>(m_sampleRate);
+    const double longest = m_left.maxDelay();
     
-    // Advance write index
-    m_writeIndex = (m_writeIndex + 1) % m_bufferSize;
+    switch (m_mode) {
+        case DelayMode::CHORUS:
+            m_targetDelay = CHORUS_DELAY * sampleRate;
+            m_targetSweep = m_modulationDepth * CHORUS_SWEEP * sampleRate;
+            break;
+        case DelayMode::FLANGER:
+            m_targetDelay = FLANGER_DELAY * sampleRate;
+            m_targetSweep = m_modulationDepth * FLANGER_SWEEP * sampleRate;
+            break;
+        default: {
+            const float seconds = (m_syncBeats > 0.0f) ? m_syncBeats * 60.0f / m_tempo : m_delayTime;
+            m_targetDelay = static_cast<double>(seconds) * m_sampleRate;
+            m_targetSweep = 0.0f;
+            break;
+        }
+    }
     
-    // Mix dry and wet signals
-    return input * (1.0f - m_mix) + delayedSample * m_mix;
+    // The whole sweep has to fit in the line
+    m_targetSweep = std::min(m_targetSweep, static_cast<float>(0.5 * (longest - MIN_DELAY_SAMPLES)));
+    m_targetDelay = std::max(MIN_DELAY_SAMPLES + m_targetSweep,
+                             std::min(longest - m_targetSweep, m_targetDelay));
+}
+
+void DelayEffect::setMode(DelayMode mode)
+{
+    m_mode = mode;
+    if (mode == DelayMode::ECHO || mode == DelayMode::PING_PONG) {
+        m_sweep = 0.0f;
+    }
+    updateTargets();
+}
+
+void DelayEffect::setInterpolation(DelayInterpolation interpolation)
+{
+    m_interpolation = interpolation;
+    m_allpassTuning = 0.0;
 }
 
 void DelayEffect::setDelayTime(float delayTime)
 {
-    m_delayTime = std::max(0.001f, std::min(1.0f, delayTime));
+    m_delayTime = std::max(0.001f, std::min(2.0f, delayTime));
+    updateTargets();
 }
 
 void DelayEffect::setFeedback(float feedback)
@@ -52,84 +304,382 @@ void DelayEffect::setMix(float mix)
     m_mix = std::max(0.0f, std::min(1.0f, mix));
 }
 
+void DelayEffect::setModulationRate(float rate)
+{
+    m_modulationRate = std::max(0.01f, std::min(10.0f, rate));
+    const float step = TWO_PI * m_modulationRate / static_cast<float>(m_sampleRate);
+    m_lfoStepSin = std::sin(step);
+    m_lfoStepCos = std::cos(step);
+}
+
+void DelayEffect::setModulationDepth(float depth)
+{
+    m_modulationDepth = std::max(0.0f, std::min(1.0f, depth));
+    updateTargets();
+}
+
+void DelayEffect::setTempo(float bpm)
+{
+    m_tempo = std::max(20.0f, std::min(300.0f, bpm));
+    updateTargets();
+}
+
+void DelayEffect::setSyncBeats(float beats)
+{
+    m_syncBeats = std::max(0.0f, beats);
+    updateTargets();
+}
+
+void DelayEffect::clear()
+{
+    m_left.clear();
+    m_right.clear();
+    m_allpassLeft = 0.0f;
+    m_allpassRight = 0.0f;
+}
+
 // ReverbEffect Implementation
+namespace {
+
+// Freeverb's tunings at 44.1 kHz, in samples
+constexpr int COMB_TUNINGS[ReverbEffect::NUM_COMBS] = {1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617};
+constexpr int ALLPASS_TUNINGS[ReverbEffect::NUM_ALLPASS] = {556, 441, 341, 225};
+// Extra length of the right channel's lines
+constexpr int STEREO_SPREAD = 23;
+constexpr float ALLPASS_FEEDBACK = 0.5f;
+// Input attenuation into the combs and the matching wet makeup gain
+constexpr float INPUT_GAIN = 0.015f;
+constexpr float WET_SCALE = 3.0f;
+// Keeps the decaying comb feedback out of denormal range
+constexpr float ANTI_DENORMAL = 1e-18f;
+
+int nextPowerOfTwo(int value)
+{
+    int size = 1;
+    while (size < value) {
+        size *= 2;
+    }
+    return size;
+}
+
+} // namespace
+
 ReverbEffect::ReverbEffect(int sampleRate)
     : m_sampleRate(sampleRate)
     , m_roomSize(0.5f)
     , m_damping(0.5f)
+    , m_width(1.0f)
     , m_mix(0.3f)
+    , m_position(0)
 {
-    // Comb filter delays (in samples)
-    std::vector<int> combDelays = {1116, 1188, 1277, 1356};
-    std::vector<int> allpassDelays = {556, 441};
+    const float scale = static_cast<float>(sampleRate) / 44100.0f;
+    auto scaled = [scale](int samples) {
+        return std::max(1, static_cast<int>(static_cast<float>(samples) * scale));
+    };
+    
+    int longestComb = 0;
+    for (int c = 0; c < NUM_COMBS; ++c) {
+        m_combDelays[c] = scaled(COMB_TUNINGS[c]);
+        m_combDelays[NUM_COMBS + c] = scaled(COMB_TUNINGS[c] + STEREO_SPREAD);
+        longestComb = std::max(longestComb, m_combDelays[NUM_COMBS + c]);
+    }
+    int longestAllpass = 0;
+    for (int a = 0; a < NUM_ALLPASS; ++a) {
+        m_allpassDelays[a] = scaled(ALLPASS_TUNINGS[a]);
+        m_allpassDelays[NUM_ALLPASS + a] = scaled(ALLPASS_TUNINGS[a] + STEREO_SPREAD);
+        longestAllpass = std::max(longestAllpass, m_allpassDelays[NUM_ALLPASS + a]);
+    }
     
-    // Scale delays based on sample rate
-    float scale = static_cast<float>(sampleRate) / 44100.0f;
+    const int combRows = nextPowerOfTwo(longestComb + 1);
+    m_combMask = combRows - 1;
+    m_allpassLength = nextPowerOfTwo(longestAllpass + 1);
+    m_allpassMask = m_allpassLength - 1;
+    m_allpassOffset = combRows * COMB_LANES;
+    m_arena.assign(m_allpassOffset + 2 * NUM_ALLPASS * m_allpassLength, 0.0f);
     
-    m_combBuffers.resize(NUM_COMBS);
-    m_combIndices.resize(NUM_COMBS, 0);
-    m_combFeedback.resize(NUM_COMBS);
+    std::fill(m_combFilters, m_combFilters + COMB_LANES, 0.0f);
+    m_left.resize(MAX_BLOCK_SIZE, 0.0f);
+    m_right.resize(MAX_BLOCK_SIZE, 0.0f);
+    m_input.resize(MAX_BLOCK_SIZE, 0.0f);
     
-    for (int i = 0; i < NUM_COMBS; ++i) {
-        int delaySize = static_cast<int>(combDelays[i] * scale);
-        m_combBuffers[i].resize(delaySize, 0.0f);
-        m_combFeedback[i] = 0.84f;
+    switch (simd::detect()) {
+#ifdef VSYNTH_X86
+        case simd::InstructionSet::AVX2:
+            m_combKernel = combsAVX2;
+            break;
+        case simd::InstructionSet::SSE2:
+            m_combKernel = combsSSE2;
+            break;
+#endif
+        default:
+            m_combKernel = combsScalar;
+            break;
     }
     
-    m_allpassBuffers.resize(NUM_ALLPASS);
-    m_allpassIndices.resize(NUM_ALLPASS, 0);
-    m_allpassFeedback.resize(NUM_ALLPASS);
+    setRoomSize(m_roomSize);
+    setDamping(m_damping);
+}
+
+float ReverbEffect::process(float input)
+{
+    // Single sample path: the block allpass loop's setup would dominate here
+    float left = 0.0f;
+    float right = 0.0f;
+    m_combKernel(*this, &input, &left, &right, 1);
     
-    for (int i = 0; i < NUM_ALLPASS; ++i) {
-        int delaySize = static_cast<int>(allpassDelays[i] * scale);
-        m_allpassBuffers[i].resize(delaySize, 0.0f);
-        m_allpassFeedback[i] = 0.5f;
+    float* lines = m_arena.data() + m_allpassOffset;
+    for (int a = 0; a < 2 * NUM_ALLPASS; ++a) {
+        float* line = lines + a * m_allpassLength;
+        float& sample = (a < NUM_ALLPASS) ? left : right;
+        const float delayed = line[(m_position - m_allpassDelays[a]) & m_allpassMask];
+        line[m_position & m_allpassMask] = sample + delayed * ALLPASS_FEEDBACK;
+        sample = delayed - sample;
     }
+    ++m_position;
+    
+    return input * (1.0f - m_mix) + (left + right) * m_mix * WET_SCALE * 0.5f;
 }
 
-float ReverbEffect::process(float input)
+void ReverbEffect::processBlock(float* buffer, int frames)
+{
+    // The reverb channels are summed, so width does not matter here
+    const float dry = 1.0f - m_mix;
+    const float wet = m_mix * WET_SCALE * 0.5f;
+    
+    for (int offset = 0; offset < frames; offset += MAX_BLOCK_SIZE) {
+        const int count = std::min(MAX_BLOCK_SIZE, frames - offset);
+        float* block = buffer + offset;
+        
+        renderWet(block, count);
+        
+        for (int i = 0; i < count; ++i) {
+            block[i] = block[i] * dry + (m_left[i] + m_right[i]) * wet;
+        }
+    }
+}
+
+void ReverbEffect::processStereo(const float* input, float* left, float* right, int frames)
 {
-    float output = 0.0f;
+    const float dry = 1.0f - m_mix;
+    const float wet = m_mix * WET_SCALE;
+    const float wetDirect = wet * (0.5f + 0.5f * m_width);
+    const float wetCross = wet * (0.5f - 0.5f * m_width);
     
-    // Process through comb filters
-    for (int i = 0; i < NUM_COMBS; ++i) {
-        float& delayLine = m_combBuffers[i][m_combIndices[i]];
-        float combOutput = delayLine;
-        delayLine = input + (delayLine * m_combFeedback[i] * m_roomSize);
+    for (int offset = 0; offset < frames; offset += MAX_BLOCK_SIZE) {
+        const int count = std::min(MAX_BLOCK_SIZE, frames - offset);
+        
+        renderWet(input + offset, count);
         
-        m_combIndices[i] = (m_combIndices[i] + 1) % m_combBuffers[i].size();
-        output += combOutput;
+        for (int i = 0; i < count; ++i) {
+            const float dryInput = input[offset + i] * dry;
+            left[offset + i] = dryInput + m_left[i] * wetDirect + m_right[i] * wetCross;
+            right[offset + i] = dryInput + m_right[i] * wetDirect + m_left[i] * wetCross;
+        }
     }
+}
+
+void ReverbEffect::processStereo(float* left, float* right, int frames)
+{
+    const float dry = 1.0f - m_mix;
+    const float wet = m_mix * WET_SCALE;
+    const float wetDirect = wet * (0.5f + 0.5f * m_width);
+    const float wetCross = wet * (0.5f - 0.5f * m_width);
     
-    output *= 0.25f; // Scale down after combining
+    for (int offset = 0; offset < frames; offset += MAX_BLOCK_SIZE) {
+        const int count = std::min(MAX_BLOCK_SIZE, frames - offset);
+        float* blockLeft = left + offset;
+        float* blockRight = right + offset;
+        
+        for (int i = 0; i < count; ++i) {
+            m_input[i] = 0.5f * (blockLeft[i] + blockRight[i]);
+        }
+        renderWet(m_input.data(), count);
+        
+        for (int i = 0; i < count; ++i) {
+            blockLeft[i] = blockLeft[i] * dry + m_left[i] * wetDirect + m_right[i] * wetCross;
+            blockRight[i] = blockRight[i] * dry + m_right[i] * wetDirect + m_left[i] * wetCross;
+        }
+    }
+}
+
+void ReverbEffect::renderWet(const float* input, int frames)
+{
+    m_combKernel(*this, input, m_left.data(), m_right.data(), frames);
+    allpasses(m_left.data(), 0, frames);
+    allpasses(m_right.data(), 1, frames);
+    m_position += static_cast<uint32_t>(frames);
+}
+
+void ReverbEffect::combsScalar(ReverbEffect& reverb, const float* input,
+                               float* left, float* right, int frames)
+{
+    float* combs = reverb.m_arena.data();
+    const int mask = reverb.m_combMask;
+    const float feedback = reverb.m_feedback;
+    const float damp1 = reverb.m_damp1;
+    const float damp2 = reverb.m_damp2;
+    uint32_t position = reverb.m_position;
     
-    // Process through allpass filters
-    for (int i = 0; i < NUM_ALLPASS; ++i) {
-        float& delayLine = m_allpassBuffers[i][m_allpassIndices[i]];
-        float allpassOutput = -output + delayLine;
-        delayLine = output + (delayLine * m_allpassFeedback[i]);
-        output = allpassOutput;
+    for (int i = 0; i < frames; ++i, ++position) {
+        const float in = input[i] * INPUT_GAIN + ANTI_DENORMAL;
+        float* row = combs + (position & mask) * COMB_LANES;
+        float sums[2] = {0.0f, 0.0f};
+        
+        for (int lane = 0; lane < COMB_LANES; ++lane) {
+            const int readRow = static_cast<int>(position - reverb.m_combDelays[lane]) & mask;
+            const float out = combs[readRow * COMB_LANES + lane];
+            reverb.m_combFilters[lane] = out * damp2 + reverb.m_combFilters[lane] * damp1;
+            row[lane] = in + reverb.m_combFilters[lane] * feedback;
+            sums[lane / NUM_COMBS] += out;
+        }
         
-        m_allpassIndices[i] = (m_allpassIndices[i] + 1) % m_allpassBuffers[i].size();
+        left[i] = sums[0];
+        right[i] = sums[1];
     }
+}
+
+#ifdef VSYNTH_X86
+void ReverbEffect::combsSSE2(ReverbEffect& reverb, const float* input,
+                             float* left, float* right, int frames)
+{
+    constexpr int VECTORS = COMB_LANES / 4;
+    float* combs = reverb.m_arena.data();
+    const int mask = reverb.m_combMask;
+    const __m128 feedback = _mm_set1_ps(reverb.m_feedback);
+    const __m128 damp1 = _mm_set1_ps(reverb.m_damp1);
+    const __m128 damp2 = _mm_set1_ps(reverb.m_damp2);
+    __m128 filters[VECTORS];
+    for (int v = 0; v < VECTORS; ++v) {
+        filters[v] = _mm_load_ps(reverb.m_combFilters + 4 * v);
+    }
+    uint32_t position = reverb.m_position;
     
-    // Apply damping (simple low-pass filter)
-    static float lastOutput = 0.0f;
-    output = output * (1.0f - m_damping) + lastOutput * m_damping;
-    lastOutput = output;
+    for (int i = 0; i < frames; ++i, ++position) {
+        const __m128 in = _mm_set1_ps(input[i] * INPUT_GAIN + ANTI_DENORMAL);
+        float* row = combs + (position & mask) * COMB_LANES;
+        
+        // No gather: each lane's delayed sample is loaded on its own
+        __m128 out[VECTORS];
+        for (int v = 0; v < VECTORS; ++v) {
+            float taps[4];
+            for (int k = 0; k < 4; ++k) {
+                const int lane = 4 * v + k;
+                const int readRow = static_cast<int>(position - reverb.m_combDelays[lane]) & mask;
+                taps[k] = combs[readRow * COMB_LANES + lane];
+            }
+            out[v] = _mm_loadu_ps(taps);
+            filters[v] = _mm_add_ps(_mm_mul_ps(out[v], damp2), _mm_mul_ps(filters[v], damp1));
+            _mm_store_ps(row + 4 * v, _mm_add_ps(in, _mm_mul_ps(filters[v], feedback)));
+        }
+        
+        // Lanes end up as L R L R, then the two halves are added
+        const __m128 leftOut = _mm_add_ps(out[0], out[1]);
+        const __m128 rightOut = _mm_add_ps(out[2], out[3]);
+        __m128 sums = _mm_add_ps(_mm_unpacklo_ps(leftOut, rightOut), _mm_unpackhi_ps(leftOut, rightOut));
+        sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+        left[i] = _mm_cvtss_f32(sums);
+        right[i] = _mm_cvtss_f32(_mm_shuffle_ps(sums, sums, 1));
+    }
+    
+    for (int v = 0; v < VECTORS; ++v) {
+        _mm_store_ps(reverb.m_combFilters + 4 * v, filters[v]);
+    }
+}
+
+VSYNTH_TARGET_AVX2 void ReverbEffect::combsAVX2(ReverbEffect& reverb, const float* input,
+                                                float* left, float* right, int frames)
+{
+    float* combs = reverb.m_arena.data();
+    const __m256i mask = _mm256_set1_epi32(reverb.m_combMask);
+    const __m256i leftLanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i rightLanes = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i leftDelays = _mm256_load_si256(reinterpret_cast<const __m256i*>(reverb.m_combDelays));
+    const __m256i rightDelays = _mm256_load_si256(reinterpret_cast<const __m256i*>(reverb.m_combDelays + NUM_COMBS));
+    const __m256 feedback = _mm256_set1_ps(reverb.m_feedback);
+    const __m256 damp1 = _mm256_set1_ps(reverb.m_damp1);
+    const __m256 damp2 = _mm256_set1_ps(reverb.m_damp2);
+    __m256 leftFilters = _mm256_load_ps(reverb.m_combFilters);
+    __m256 rightFilters = _mm256_load_ps(reverb.m_combFilters + NUM_COMBS);
+    uint32_t position = reverb.m_position;
+    
+    for (int i = 0; i < frames; ++i, ++position) {
+        const __m256 in = _mm256_set1_ps(input[i] * INPUT_GAIN + ANTI_DENORMAL);
+        const __m256i now = _mm256_set1_epi32(static_cast<int>(position));
+        float* row = combs + (position & reverb.m_combMask) * COMB_LANES;
+        
+        // Row index * 16 + lane: each lane reads its own comb's delayed sample
+        const __m256i leftIndex = _mm256_add_epi32(
+            _mm256_slli_epi32(_mm256_and_si256(_mm256_sub_epi32(now, leftDelays), mask), 4), leftLanes);
+        const __m256i rightIndex = _mm256_add_epi32(
+            _mm256_slli_epi32(_mm256_and_si256(_mm256_sub_epi32(now, rightDelays), mask), 4), rightLanes);
+        const __m256 leftOut = _mm256_i32gather_ps(combs, leftIndex, 4);
+        const __m256 rightOut = _mm256_i32gather_ps(combs, rightIndex, 4);
+        
+        leftFilters = _mm256_fmadd_ps(leftOut, damp2, _mm256_mul_ps(leftFilters, damp1));
+        rightFilters = _mm256_fmadd_ps(rightOut, damp2, _mm256_mul_ps(rightFilters, damp1));
+        _mm256_store_ps(row, _mm256_fmadd_ps(leftFilters, feedback, in));
+        _mm256_store_ps(row + NUM_COMBS, _mm256_fmadd_ps(rightFilters, feedback, in));
+        
+        // Both channel sums at once: lanes end up as L R L R
+        __m256 sums = _mm256_hadd_ps(leftOut, rightOut);
+        sums = _mm256_hadd_ps(sums, sums);
+        const __m128 total = _mm_add_ps(_mm256_castps256_ps128(sums), _mm256_extractf128_ps(sums, 1));
+        left[i] = _mm_cvtss_f32(total);
+        right[i] = _mm_cvtss_f32(_mm_shuffle_ps(total, total, 1));
+    }
     
-    // Mix dry and wet signals
-    return input * (1.0f - m_mix) + output * m_mix;
+    _mm256_store_ps(reverb.m_combFilters, leftFilters);
+    _mm256_store_ps(reverb.m_combFilters + NUM_COMBS, rightFilters);
+}
+#endif
+
+void ReverbEffect::allpasses(float* samples, int channel, int frames)
+{
+    for (int a = 0; a < NUM_ALLPASS; ++a) {
+        float* line = m_arena.data() + m_allpassOffset + (channel * NUM_ALLPASS + a) * m_allpassLength;
+        const int delay = m_allpassDelays[channel * NUM_ALLPASS + a];
+        uint32_t position = m_position;
+        
+        int i = 0;
+        while (i < frames) {
+            // A stretch where neither index wraps, no longer than the delay so
+            // it never reads what it writes: the loop below then vectorizes
+            const int readIndex = static_cast<int>(position - delay) & m_allpassMask;
+            const int writeIndex = static_cast<int>(position) & m_allpassMask;
+            const int run = std::min({frames - i, delay, m_allpassLength - readIndex,
+                                      m_allpassLength - writeIndex});
+            const float* __restrict delayed = line + readIndex;
+            float* __restrict written = line + writeIndex;
+            float* __restrict x = samples + i;
+            
+            for (int k = 0; k < run; ++k) {
+                const float d = delayed[k];
+                written[k] = x[k] + d * ALLPASS_FEEDBACK;
+                x[k] = d - x[k];
+            }
+            
+            i += run;
+            position += static_cast<uint32_t>(run);
+        }
+    }
 }
 
 void ReverbEffect::setRoomSize(float roomSize)
 {
     m_roomSize = std::max(0.0f, std::min(1.0f, roomSize));
+    m_feedback = 0.7f + 0.28f * m_roomSize;
 }
 
 void ReverbEffect::setDamping(float damping)
 {
     m_damping = std::max(0.0f, std::min(1.0f, damping));
+    m_damp1 = 0.4f * m_damping;
+    m_damp2 = 1.0f - m_damp1;
+}
+
+void ReverbEffect::setWidth(float width)
+{
+    m_width = std::max(0.0f, std::min(1.0f, width));
 }
 
 void ReverbEffect::setMix(float mix)
@@ -137,23 +687,41 @@ void ReverbEffect::setMix(float mix)
     m_mix = std::max(0.0f, std::min(1.0f, mix));
 }
 
+void ReverbEffect::clear()
+{
+    std::fill(m_arena.begin(), m_arena.end(), 0.0f);
+    std::fill(m_combFilters, m_combFilters + COMB_LANES, 0.0f);
+}
+
 // Effects Implementation
 Effects::Effects(int sampleRate)
     : m_sampleRate(sampleRate)
 {
     m_delay = std::make_unique<DelayEffect>(sampleRate);
     m_reverb = std::make_unique<ReverbEffect>(sampleRate);
+    m_convolution = std::make_unique<ConvolutionReverb>(sampleRate);
 }
 
 float Effects::process(float input)
 {
-    float output = input;
-    
-    // Process through delay first, then reverb
-    output = m_delay->process(output);
-    output = m_reverb->process(output);
-    
-    return output;
+    processBlock(&input, 1);
+    return input;
+}
+
+void Effects::processBlock(float* buffer, int frames)
+{
+    // Process through delay first, then reverb, then the convolution
+    // reverb (a pass-through until an impulse response is loaded)
+    m_delay->processBlock(buffer, frames);
+    m_reverb->processBlock(buffer, frames);
+    m_convolution->processBlock(buffer, frames);
+}
+
+void Effects::processStereo(float* left, float* right, int frames)
+{
+    m_delay->processStereo(left, right, frames);
+    m_reverb->processStereo(left, right, frames);
+    m_convolution->processStereo(left, right, frames);
 }
 
 void Effects::setReverbAmount(float amount)
@@ -175,3 +743,63 @@ void Effects::setDelayFeedback(float feedback)
 {
     m_delay->setFeedback(feedback);
 }
+
+void Effects::setDelayMode(DelayMode mode)
+{
+    m_delay->setMode(mode);
+}
+
+void Effects::setDelayInterpolation(DelayInterpolation interpolation)
+{
+    m_delay->setInterpolation(interpolation);
+}
+
+void Effects::setDelayModulationRate(float rate)
+{
+    m_delay->setModulationRate(rate);
+}
+
+void Effects::setDelayModulationDepth(float depth)
+{
+    m_delay->setModulationDepth(depth);
+}
+
+void Effects::setTempo(float bpm)
+{
+    m_delay->setTempo(bpm);
+}
+
+void Effects::setDelaySync(float beats)
+{
+    m_delay->setSyncBeats(beats);
+}
+
+void Effects::setReverbRoomSize(float roomSize)
+{
+    m_reverb->setRoomSize(roomSize);
+}
+
+void Effects::setReverbDamping(float damping)
+{
+    m_reverb->setDamping(damping);
+}
+
+void Effects::setReverbWidth(float width)
+{
+    m_reverb->setWidth(width);
+}
+
+void Effects::loadImpulseResponse(const std::string& filename)
+{
+    m_convolution->loadImpulseResponse(filename);
+}
+
+bool Effects::waitForImpulseResponse()
+{
+    return m_convolution->waitForLoad();
+}
+
+void Effects::setConvolutionMix(float mix)
+{
+    m_convolution->setMix(mix);
+}
@@ -1,31 +1,208 @@
 #include "vsynth/FFTAnalyzer.h"
+#include "vsynth/DspMath.h"
 #include <cmath>
 #include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#ifdef VSYNTH_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// log2(1 + x) for x in [0, 1), least squares fit (max error 1.2e-4, about 0.0004 dB)
+constexpr float LOG2_C1 = 1.43863803f;
+constexpr float LOG2_C2 = -0.67774327f;
+constexpr float LOG2_C3 = 0.32187971f;
+constexpr float LOG2_C4 = -0.08286070f;
+// 10 * log10(2): power decibels per octave of log2
+constexpr float DB_PER_LOG2 = 3.01029996f;
+// Keeps silence finite (-200 dB)
+constexpr float POWER_FLOOR = 1e-20f;
+
+// Approximate 10 * log10(power) from the float's exponent and a mantissa polynomial
+inline float decibels(float power)
+{
+    power = std::max(power, POWER_FLOOR);
+    uint32_t bits;
+    std::memcpy(&bits, &power, sizeof(bits));
+    const float exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float mantissa;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+    const float x = mantissa - 1.0f;
+    return DB_PER_LOG2 * (exponent + x * (LOG2_C1 + x * (LOG2_C2 + x * (LOG2_C3 + x * LOG2_C4))));
+}
+
+// Scalar kernels, also used for the tails of the SIMD ones
+
+void accumulatePowerScalar(const fftwf_complex* bins, float* average, int count, float scale,
+                           float newWeight, float keepWeight, float holdWeight)
+{
+    for (int i = 0; i < count; ++i) {
+        const float power = (bins[i][0] * bins[i][0] + bins[i][1] * bins[i][1]) * scale;
+        average[i] = std::max(newWeight * power + keepWeight * average[i], holdWeight * average[i]);
+    }
+}
+
+float decibelsScalar(const float* power, float* out, int count)
+{
+    float maxDecibels = decibels(0.0f);
+    for (int i = 0; i < count; ++i) {
+        out[i] = decibels(power[i]);
+        maxDecibels = std::max(maxDecibels, out[i]);
+    }
+    return maxDecibels;
+}
+
+void normalizeScalar(float* values, int count, float floor, float inverseRange)
+{
+    for (int i = 0; i < count; ++i) {
+        values[i] = std::max(0.0f, std::min(1.0f, (values[i] - floor) * inverseRange));
+    }
+}
+
+#ifdef VSYNTH_X86
+
+// AVX2/FMA kernels, eight bins per iteration, same approximations as the scalar ones
+
+VSYNTH_TARGET_AVX2 void accumulatePowerAVX2(const fftwf_complex* bins, float* average, int count, float scale,
+                                            float newWeight, float keepWeight, float holdWeight)
+{
+    const float* interleaved = reinterpret_cast<const float*>(bins);
+    const __m256 scaleV = _mm256_set1_ps(scale);
+    const __m256 newV = _mm256_set1_ps(newWeight);
+    const __m256 keepV = _mm256_set1_ps(keepWeight);
+    const __m256 holdV = _mm256_set1_ps(holdWeight);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 low = _mm256_loadu_ps(interleaved + 2 * i);
+        __m256 high = _mm256_loadu_ps(interleaved + 2 * i + 8);
+        // hadd leaves bins in the order 0 1 4 5 | 2 3 6 7; the permute restores it
+        __m256 power = _mm256_hadd_ps(_mm256_mul_ps(low, low), _mm256_mul_ps(high, high));
+        power = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(power), _MM_SHUFFLE(3, 1, 2, 0)));
+        power = _mm256_mul_ps(power, scaleV);
+
+        const __m256 previous = _mm256_loadu_ps(average + i);
+        const __m256 blended = _mm256_fmadd_ps(newV, power, _mm256_mul_ps(keepV, previous));
+        _mm256_storeu_ps(average + i, _mm256_max_ps(blended, _mm256_mul_ps(holdV, previous)));
+    }
+
+    accumulatePowerScalar(bins + i, average + i, count - i, scale, newWeight, keepWeight, holdWeight);
+}
+
+VSYNTH_TARGET_AVX2 float decibelsAVX2(const float* power, float* out, int count)
+{
+    const __m256 floorV = _mm256_set1_ps(POWER_FLOOR);
+    const __m256i mantissaMask = _mm256_set1_epi32(0x007FFFFF);
+    const __m256i one = _mm256_set1_epi32(0x3F800000);
+    const __m256i bias = _mm256_set1_epi32(127);
+    __m256 maxV = _mm256_set1_ps(decibels(0.0f));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i bits = _mm256_castps_si256(_mm256_max_ps(_mm256_loadu_ps(power + i), floorV));
+        const __m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), bias));
+        const __m256 x = _mm256_sub_ps(
+            _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, mantissaMask), one)),
+            _mm256_set1_ps(1.0f));
+
+        __m256 poly = _mm256_fmadd_ps(x, _mm256_set1_ps(LOG2_C4), _mm256_set1_ps(LOG2_C3));
+        poly = _mm256_fmadd_ps(x, poly, _mm256_set1_ps(LOG2_C2));
+        poly = _mm256_fmadd_ps(x, poly, _mm256_set1_ps(LOG2_C1));
+        const __m256 log2 = _mm256_fmadd_ps(x, poly, exponent);
+
+        const __m256 result = _mm256_mul_ps(log2, _mm256_set1_ps(DB_PER_LOG2));
+        _mm256_storeu_ps(out + i, result);
+        maxV = _mm256_max_ps(maxV, result);
+    }
+
+    __m128 max4 = _mm_max_ps(_mm256_castps256_ps128(maxV), _mm256_extractf128_ps(maxV, 1));
+    max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+    max4 = _mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1));
+    return std::max(_mm_cvtss_f32(max4), decibelsScalar(power + i, out + i, count - i));
+}
+
+VSYNTH_TARGET_AVX2 void normalizeAVX2(float* values, int count, float floor, float inverseRange)
+{
+    const __m256 floorV = _mm256_set1_ps(floor);
+    const __m256 inverseV = _mm256_set1_ps(inverseRange);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(values + i), floorV), inverseV);
+        _mm256_storeu_ps(values + i, _mm256_min_ps(one, _mm256_max_ps(zero, v)));
+    }
+
+    normalizeScalar(values + i, count - i, floor, inverseRange);
+}
+
+#endif // VSYNTH_X86
+
+} // namespace
 
 FFTAnalyzer::FFTAnalyzer(int fftSize)
-    : m_fftSize(fftSize)
+    : m_fftSize(MIN_FFT_SIZE)
     , m_useWindow(true)
+    , m_windowType(WindowType::HANN)
+    , m_kaiserBeta(9.0f)
+    , m_averaging(SpectrumAveraging::NONE)
+    , m_averagingAmount(0.5f)
+    , m_windowScale(1.0f)
+    , m_historyIndex(0)
+    , m_hasAverage(false)
+    , m_bandSampleRate(44100)
+    , m_bandMinFrequency(20.0f)
+    , m_bandMaxFrequency(20000.0f)
 {
+    while (m_fftSize < fftSize && m_fftSize < MAX_FFT_SIZE) {
+        m_fftSize *= 2;
+    }
+    m_hopSize = m_fftSize / 4;
+    m_samplesUntilFrame = m_fftSize;
+    
     // Allocate FFTW buffers
     m_inputBuffer = fftwf_alloc_real(m_fftSize);
     m_outputBuffer = fftwf_alloc_complex(m_fftSize / 2 + 1);
     
-    // Create FFTW plan
-    m_plan = fftwf_plan_dft_r2c_1d(m_fftSize, m_inputBuffer, m_outputBuffer, FFTW_ESTIMATE);
+    // Create FFTW plan (measuring overwrites the buffers, so this comes first)
+    {
+        std::lock_guard<std::mutex> lock(plannerMutex());
+        m_plan = fftwf_plan_dft_r2c_1d(m_fftSize, m_inputBuffer, m_outputBuffer, FFTW_MEASURE);
+    }
     
-    // Initialize window function (Hann window)
-    m_window.resize(m_fftSize);
-    for (int i = 0; i < m_fftSize; ++i) {
-        m_window[i] = 0.5f * (1.0f - std::cos(2.0f * PI * i / (m_fftSize - 1)));
+    buildWindow();
+    
+    switch (simd::detect()) {
+#ifdef VSYNTH_X86
+        case simd::InstructionSet::AVX2:
+            m_powerKernel = accumulatePowerAVX2;
+            m_decibelKernel = decibelsAVX2;
+            m_normalizeKernel = normalizeAVX2;
+            break;
+#endif
+        default:
+            m_powerKernel = accumulatePowerScalar;
+            m_decibelKernel = decibelsScalar;
+            m_normalizeKernel = normalizeScalar;
+            break;
     }
     
-    // Initialize magnitude spectrum
+    m_history.resize(m_fftSize, 0.0f);
+    m_averagePower.resize(m_fftSize / 2 + 1, 0.0f);
     m_magnitudeSpectrum.resize(m_fftSize / 2 + 1);
 }
 
 FFTAnalyzer::~FFTAnalyzer()
 {
-    fftwf_destroy_plan(m_plan);
+    {
+        std::lock_guard<std::mutex> lock(plannerMutex());
+        fftwf_destroy_plan(m_plan);
+    }
     fftwf_free(m_inputBuffer);
     fftwf_free(m_outputBuffer);
 }
@@ -41,18 +218,82 @@ void FFTAnalyzer::processBuffer(const std::vector<float>& audioBuffer)
         std::copy(audioBuffer.end() - m_fftSize, audioBuffer.end(), m_inputBuffer);
     }
     
-    // Apply window function
-    if (m_useWindow) {
-        applyWindow();
+    analyzeFrame();
+}
+
+int FFTAnalyzer::pushSamples(const float* samples, size_t count)
+{
+    int frames = 0;
+    
+    while (count > 0) {
+        // Copy up to the next frame boundary, in at most two pieces around the ring end
+        const size_t chunk = std::min(count, m_samplesUntilFrame);
+        const size_t first = std::min(chunk, m_history.size() - m_historyIndex);
+        std::memcpy(m_history.data() + m_historyIndex, samples, first * sizeof(float));
+        std::memcpy(m_history.data(), samples + first, (chunk - first) * sizeof(float));
+        
+        m_historyIndex = (m_historyIndex + chunk) % m_history.size();
+        m_samplesUntilFrame -= chunk;
+        samples += chunk;
+        count -= chunk;
+        
+        if (m_samplesUntilFrame == 0) {
+            // Unwrap the ring, oldest sample first
+            const size_t tail = m_history.size() - m_historyIndex;
+            std::memcpy(m_inputBuffer, m_history.data() + m_historyIndex, tail * sizeof(float));
+            std::memcpy(m_inputBuffer + tail, m_history.data(), m_historyIndex * sizeof(float));
+            
+            analyzeFrame();
+            m_samplesUntilFrame = m_hopSize;
+            ++frames;
+        }
+    }
+    
+    return frames;
+}
+
+void FFTAnalyzer::setHopSize(int hopSize)
+{
+    // Takes effect after the next frame
+    m_hopSize = std::max(1, std::min(m_fftSize, hopSize));
+}
+
+void FFTAnalyzer::resetStream()
+{
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+    m_historyIndex = 0;
+    m_samplesUntilFrame = m_fftSize;
+    m_hasAverage = false;
+}
+
+const std::vector<float>& FFTAnalyzer::getBandSpectrum(int numBands)
+{
+    numBands = std::max(1, numBands);
+    if (static_cast<int>(m_bandFirstBin.size()) != numBands) {
+        buildBandMap(numBands);
+    }
+    
+    // Band energy: the summed power of every bin in the band
+    for (int band = 0; band < numBands; ++band) {
+        float power = 0.0f;
+        for (int bin = m_bandFirstBin[band]; bin < m_bandEndBin[band]; ++bin) {
+            power += m_averagePower[bin];
+        }
+        m_bandPower[band] = power;
     }
     
-    // Compute FFT
-    computeFFT();
+    const float maxBand = m_decibelKernel(m_bandPower.data(), m_bandSpectrum.data(), numBands);
+    m_normalizeKernel(m_bandSpectrum.data(), numBands, maxBand - DISPLAY_RANGE_DB, 1.0f / DISPLAY_RANGE_DB);
+    return m_bandSpectrum;
 }
 
-std::vector<float> FFTAnalyzer::getMagnitudeSpectrum()
+void FFTAnalyzer::setBandRange(int sampleRate, float minFrequency, float maxFrequency)
 {
-    return m_magnitudeSpectrum;
+    m_bandSampleRate = std::max(1, sampleRate);
+    m_bandMinFrequency = std::max(1.0f, minFrequency);
+    m_bandMaxFrequency = std::max(m_bandMinFrequency * 1.01f, maxFrequency);
+    m_bandFirstBin.clear();
+    m_bandEndBin.clear();
 }
 
 std::vector<float> FFTAnalyzer::getBinFrequencies(int sampleRate)
@@ -72,38 +313,142 @@ std::vector<float> FFTAnalyzer::getBinFrequencies(int sampleRate)
 void FFTAnalyzer::setWindowFunction(bool useWindow)
 {
     m_useWindow = useWindow;
+    buildWindow();
+}
+
+void FFTAnalyzer::setWindowType(WindowType type, float kaiserBeta)
+{
+    m_windowType = type;
+    m_kaiserBeta = std::max(0.0f, kaiserBeta);
+    buildWindow();
+}
+
+void FFTAnalyzer::setAveraging(SpectrumAveraging mode, float amount)
+{
+    m_averaging = mode;
+    m_averagingAmount = std::max(0.0f, std::min(0.999f, amount));
+    m_hasAverage = false;
+}
+
+bool FFTAnalyzer::importWisdom(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    return fftwf_import_wisdom_from_filename(filename.c_str()) != 0;
+}
+
+bool FFTAnalyzer::exportWisdom(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    return fftwf_export_wisdom_to_filename(filename.c_str()) != 0;
 }
 
-void FFTAnalyzer::applyWindow()
+void FFTAnalyzer::buildBandMap(int numBands)
 {
+    const int lastBin = m_fftSize / 2;
+    const double binWidth = static_cast<double>(m_bandSampleRate) / m_fftSize;
+    const double low = m_bandMinFrequency;
+    const double high = std::min<double>(m_bandMaxFrequency, lastBin * binWidth);
+    const double ratio = high > low ? high / low : 1.0;
+    
+    m_bandFirstBin.resize(numBands);
+    m_bandEndBin.resize(numBands);
+    m_bandPower.assign(numBands, 0.0f);
+    m_bandSpectrum.assign(numBands, 0.0f);
+    
+    // Band b spans [low * ratio^(b/n), low * ratio^((b+1)/n)) and takes every bin
+    // centred inside it; a band narrower than a bin uses the nearest bin instead
+    for (int band = 0; band < numBands; ++band) {
+        const double bandLow = low * std::pow(ratio, static_cast<double>(band) / numBands);
+        const double bandHigh = low * std::pow(ratio, static_cast<double>(band + 1) / numBands);
+        int first = std::max(1, static_cast<int>(std::ceil(bandLow / binWidth)));
+        int end = std::min(lastBin + 1, static_cast<int>(std::ceil(bandHigh / binWidth)));
+        if (end <= first) {
+            first = std::max(1, std::min(lastBin, static_cast<int>(std::lround(std::sqrt(bandLow * bandHigh) / binWidth))));
+            end = first + 1;
+        }
+        m_bandFirstBin[band] = first;
+        m_bandEndBin[band] = end;
+    }
+}
+
+std::mutex& FFTAnalyzer::plannerMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+void FFTAnalyzer::buildWindow()
+{
+    // Periodic windows, so overlapping frames add up evenly
+    m_window.resize(m_fftSize);
+    const double n = static_cast<double>(m_fftSize);
+    const double kaiserNorm = dsp::besselI0(m_kaiserBeta);
+    
     for (int i = 0; i < m_fftSize; ++i) {
-        m_inputBuffer[i] *= m_window[i];
+        const double phase = 2.0 * PI * i / n;
+        double value = 1.0;
+        
+        if (m_useWindow) {
+            switch (m_windowType) {
+                case WindowType::HANN:
+                    value = 0.5 - 0.5 * std::cos(phase);
+                    break;
+                case WindowType::BLACKMAN_HARRIS:
+                    value = 0.35875 - 0.48829 * std::cos(phase) + 0.14128 * std::cos(2.0 * phase)
+                          - 0.01168 * std::cos(3.0 * phase);
+                    break;
+                case WindowType::FLAT_TOP:
+                    value = 0.21557895 - 0.41663158 * std::cos(phase) + 0.277263158 * std::cos(2.0 * phase)
+                          - 0.083578947 * std::cos(3.0 * phase) + 0.006947368 * std::cos(4.0 * phase);
+                    break;
+                case WindowType::KAISER: {
+                    const double x = 2.0 * i / n - 1.0;
+                    value = dsp::besselI0(m_kaiserBeta * std::sqrt(std::max(0.0, 1.0 - x * x))) / kaiserNorm;
+                    break;
+                }
+            }
+        }
+        
+        m_window[i] = static_cast<float>(value);
+    }
+    
+    // Coherent gain: a sine of amplitude A peaks at A * sum(w) / 2
+    double sum = 0.0;
+    for (float w : m_window) {
+        sum += w;
     }
+    m_windowScale = sum > 0.0 ? static_cast<float>(2.0 / sum) : 1.0f;
+    m_hasAverage = false;
 }
 
-void FFTAnalyzer::computeFFT()
+void FFTAnalyzer::analyzeFrame()
 {
+    for (int i = 0; i < m_fftSize; ++i) {
+        m_inputBuffer[i] *= m_window[i];
+    }
+    
     // Execute FFT
     fftwf_execute(m_plan);
     
-    // Calculate magnitude spectrum
-    for (int i = 0; i < m_fftSize / 2 + 1; ++i) {
-        float real = m_outputBuffer[i][0];
-        float imag = m_outputBuffer[i][1];
-        float magnitude = std::sqrt(real * real + imag * imag);
-        
-        // Convert to dB scale (with floor to avoid log(0))
-        magnitude = std::max(magnitude, 1e-10f);
-        m_magnitudeSpectrum[i] = 20.0f * std::log10(magnitude);
+    // Power spectrum, folded into the average as
+    // max(newWeight * power + keepWeight * average, holdWeight * average)
+    const int bins = m_fftSize / 2 + 1;
+    const float amount = m_hasAverage ? m_averagingAmount : 0.0f;
+    float newWeight = 1.0f;
+    float keepWeight = 0.0f;
+    float holdWeight = 0.0f;
+    if (m_averaging == SpectrumAveraging::EXPONENTIAL) {
+        newWeight = 1.0f - amount;
+        keepWeight = amount;
+    } else if (m_averaging == SpectrumAveraging::PEAK_HOLD) {
+        holdWeight = amount;
     }
     
-    // Normalize to 0-1 range for display
-    if (!m_magnitudeSpectrum.empty()) {
-        float maxMag = *std::max_element(m_magnitudeSpectrum.begin(), m_magnitudeSpectrum.end());
-        float minMag = maxMag - 60.0f; // 60dB dynamic range
-        
-        for (float& mag : m_magnitudeSpectrum) {
-            mag = std::max(0.0f, std::min(1.0f, (mag - minMag) / (maxMag - minMag)));
-        }
-    }
+    m_powerKernel(m_outputBuffer, m_averagePower.data(), bins, m_windowScale * m_windowScale,
+                  newWeight, keepWeight, holdWeight);
+    m_hasAverage = true;
+    
+    // Normalize to 0-1 over a 60dB range below the peak for display
+    const float maxMag = m_decibelKernel(m_averagePower.data(), m_magnitudeSpectrum.data(), bins);
+    m_normalizeKernel(m_magnitudeSpectrum.data(), bins, maxMag - DISPLAY_RANGE_DB, 1.0f / DISPLAY_RANGE_DB);
 }
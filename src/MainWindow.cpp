@@ -1,6 +1,7 @@
 #include "vsynth/MainWindow.h"
 #include <QApplication>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -13,6 +14,9 @@
 #include <QGroupBox>
 #include <QProgressBar>
 #include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -21,8 +25,8 @@ MainWindow::MainWindow(QWidget *parent)
     , m_topLayout(nullptr)
     , m_bottomLayout(nullptr)
     , m_audioEngine(nullptr)
-    , m_fftAnalyzer(nullptr)
     , m_fftTimer(nullptr)
+    , m_meterTimer(nullptr)
 {
     setupUI();
     
@@ -33,13 +37,18 @@ MainWindow::MainWindow(QWidget *parent)
         return;
     }
     
-    // Initialize FFT analyzer
-    m_fftAnalyzer = new FFTAnalyzer();
+    // Analyze in display bands
+    onSpectrumSettingsChanged();
     
-    // Setup FFT update timer
+    // Setup FFT update timer (the analysis itself runs in the audio engine)
     m_fftTimer = new QTimer(this);
     connect(m_fftTimer, &QTimer::timeout, this, &MainWindow::updateFFTDisplay);
-    m_fftTimer->start(50); // Update at 20 FPS
+    m_fftTimer->start(16); // Update at 60 FPS
+    
+    // Setup performance meter update timer
+    m_meterTimer = new QTimer(this);
+    connect(m_meterTimer, &QTimer::timeout, this, &MainWindow::updatePerformanceMeter);
+    m_meterTimer->start(250);
     
     // Start audio engine
     m_audioEngine->start();
@@ -51,10 +60,6 @@ MainWindow::~MainWindow()
         m_audioEngine->stop();
         delete m_audioEngine;
     }
-    
-    if (m_fftAnalyzer) {
-        delete m_fftAnalyzer;
-    }
 }
 
 void MainWindow::setupUI()
@@ -69,29 +74,53 @@ void MainWindow::setupUI()
     // Create control groups
     m_adsrGroup = new QGroupBox("ADSR Envelope");
     m_oscillatorGroup = new QGroupBox("Oscillators");
+    m_filterGroup = new QGroupBox("Filter");
     m_effectsGroup = new QGroupBox("Effects");
     m_recordingGroup = new QGroupBox("Recording");
     m_fftGroup = new QGroupBox("Frequency Analysis");
+    m_performanceGroup = new QGroupBox("Performance");
     
     setupADSRControls(m_adsrGroup);
     setupOscillatorControls(m_oscillatorGroup);
+    setupFilterControls(m_filterGroup);
     setupEffectsControls(m_effectsGroup);
     setupRecordingControls(m_recordingGroup);
+    setupPerformanceMeter(m_performanceGroup);
     
     // Setup FFT display
     QVBoxLayout* fftLayout = new QVBoxLayout(m_fftGroup);
-    QHBoxLayout* barsLayout = new QHBoxLayout();
+    QHBoxLayout* settingsLayout = new QHBoxLayout();
     
-    for (int i = 0; i < 32; ++i) {
-        m_fftDisplay[i] = new QProgressBar();
-        m_fftDisplay[i]->setOrientation(Qt::Vertical);
-        m_fftDisplay[i]->setRange(0, 100);
-        m_fftDisplay[i]->setValue(0);
-        m_fftDisplay[i]->setMaximumWidth(15);
-        barsLayout->addWidget(m_fftDisplay[i]);
+    m_fftSizeCombo = new QComboBox();
+    for (int size = FFTAnalyzer::MIN_FFT_SIZE; size <= FFTAnalyzer::MAX_FFT_SIZE; size *= 2) {
+        m_fftSizeCombo->addItem(QString::number(size), size);
+    }
+    m_fftSizeCombo->setCurrentText(QString::number(SpectrumSettings().fftSize));
+    m_fftWindowCombo = new QComboBox();
+    m_fftWindowCombo->addItems({"Hann", "Blackman-Harris", "Flat-top", "Kaiser"});
+    m_fftAveragingCombo = new QComboBox();
+    m_fftAveragingCombo->addItems({"No averaging", "Smooth", "Peak hold"});
+    m_fftAveragingCombo->setCurrentIndex(static_cast<int>(SpectrumSettings().averaging));
+    m_spectrumViewCombo = new QComboBox();
+    m_spectrumViewCombo->addItems({"Spectrum", "Waterfall", "Both"});
+    m_spectrumViewCombo->setCurrentIndex(static_cast<int>(SpectrumWidget::ViewMode::BOTH));
+    
+    settingsLayout->addWidget(m_fftSizeCombo);
+    settingsLayout->addWidget(m_fftWindowCombo);
+    settingsLayout->addWidget(m_fftAveragingCombo);
+    settingsLayout->addWidget(m_spectrumViewCombo);
+    fftLayout->addLayout(settingsLayout);
+    
+    for (QComboBox* combo : {m_fftSizeCombo, m_fftWindowCombo, m_fftAveragingCombo}) {
+        connect(combo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+                this, &MainWindow::onSpectrumSettingsChanged);
     }
     
-    fftLayout->addLayout(barsLayout);
+    m_spectrumWidget = new SpectrumWidget();
+    fftLayout->addWidget(m_spectrumWidget);
+    connect(m_spectrumViewCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        m_spectrumWidget->setViewMode(static_cast<SpectrumWidget::ViewMode>(index));
+    });
     
     // Create keyboard
     m_keyboard = new KeyboardWidget();
@@ -109,17 +138,19 @@ void MainWindow::setupUI()
     // Layout arrangement
     m_topLayout->addWidget(m_adsrGroup);
     m_topLayout->addWidget(m_oscillatorGroup);
+    m_topLayout->addWidget(m_filterGroup);
     m_topLayout->addWidget(m_effectsGroup);
     
     m_bottomLayout->addWidget(m_recordingGroup);
     m_bottomLayout->addWidget(m_fftGroup);
+    m_bottomLayout->addWidget(m_performanceGroup);
     
     m_mainLayout->addLayout(m_topLayout);
     m_mainLayout->addLayout(m_bottomLayout);
     m_mainLayout->addWidget(m_keyboard);
     
     setWindowTitle("VSynth - Simple Synthesizer");
-    resize(1000, 600);
+    resize(1200, 600);
 }
 
 void MainWindow::setupADSRControls(QGroupBox* parent)
@@ -165,6 +196,14 @@ void MainWindow::setupADSRControls(QGroupBox* parent)
     layout->addWidget(m_releaseSlider, 3, 1);
     layout->addWidget(m_releaseLabel, 3, 2);
     connect(m_releaseSlider, &QSlider::valueChanged, this, &MainWindow::onReleaseChanged);
+    
+    // Curve of the attack, decay and release, in EnvelopeCurve order
+    layout->addWidget(new QLabel("Curve:"), 4, 0);
+    m_envelopeCurveCombo = new QComboBox();
+    m_envelopeCurveCombo->addItems({"Linear", "Exponential", "Analog"});
+    layout->addWidget(m_envelopeCurveCombo, 4, 1, 1, 2);
+    connect(m_envelopeCurveCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onEnvelopeCurveChanged);
 }
 
 void MainWindow::setupOscillatorControls(QGroupBox* parent)
@@ -174,7 +213,9 @@ void MainWindow::setupOscillatorControls(QGroupBox* parent)
     // Waveform selection
     layout->addWidget(new QLabel("Waveform:"), 0, 0);
     m_waveformCombo = new QComboBox();
-    m_waveformCombo->addItems({"Sine", "Square", "Sawtooth", "Triangle", "Noise"});
+    m_waveformCombo->addItems({"Sine", "Square", "Sawtooth", "Triangle", "Noise",
+                               "Square (Band-limited)", "Sawtooth (Band-limited)",
+                               "Triangle (Band-limited)"});
     layout->addWidget(m_waveformCombo, 0, 1);
     connect(m_waveformCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
             this, &MainWindow::onWaveformChanged);
@@ -207,6 +248,135 @@ void MainWindow::setupOscillatorControls(QGroupBox* parent)
     layout->addWidget(m_vibratoDepthSlider, 3, 1);
     layout->addWidget(m_vibratoDepthLabel, 3, 2);
     connect(m_vibratoDepthSlider, &QSlider::valueChanged, this, &MainWindow::onVibratoDepthChanged);
+    
+    // Oversampling factor and filter quality
+    layout->addWidget(new QLabel("Oversampling:"), 4, 0);
+    m_oversamplingCombo = new QComboBox();
+    for (int factor = 1; factor <= Oversampler::MAX_FACTOR; factor *= 2) {
+        m_oversamplingCombo->addItem(factor == 1 ? QString("Off") : QString("%1x").arg(factor), factor);
+    }
+    m_oversamplingQualityCombo = new QComboBox();
+    m_oversamplingQualityCombo->addItems({"Fast", "Balanced", "High"});
+    m_oversamplingQualityCombo->setCurrentIndex(static_cast<int>(OversamplingQuality::BALANCED));
+    layout->addWidget(m_oversamplingCombo, 4, 1);
+    layout->addWidget(m_oversamplingQualityCombo, 4, 2);
+    for (QComboBox* combo : {m_oversamplingCombo, m_oversamplingQualityCombo}) {
+        connect(combo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+                this, &MainWindow::onOversamplingChanged);
+    }
+    
+    // Pan
+    layout->addWidget(new QLabel("Pan:"), 5, 0);
+    m_panSlider = new QSlider(Qt::Horizontal);
+    m_panSlider->setRange(-100, 100); // Left to right
+    m_panSlider->setValue(0);
+    m_panLabel = new QLabel("C");
+    layout->addWidget(m_panSlider, 5, 1);
+    layout->addWidget(m_panLabel, 5, 2);
+    connect(m_panSlider, &QSlider::valueChanged, this, &MainWindow::onPanChanged);
+    
+    // Stereo spread of the detuned oscillators
+    layout->addWidget(new QLabel("Spread:"), 6, 0);
+    m_spreadSlider = new QSlider(Qt::Horizontal);
+    m_spreadSlider->setRange(0, 100);
+    m_spreadSlider->setValue(0);
+    m_spreadLabel = new QLabel("0%");
+    layout->addWidget(m_spreadSlider, 6, 1);
+    layout->addWidget(m_spreadLabel, 6, 2);
+    connect(m_spreadSlider, &QSlider::valueChanged, this, &MainWindow::onStereoSpreadChanged);
+}
+
+void MainWindow::setupFilterControls(QGroupBox* parent)
+{
+    QGridLayout* layout = new QGridLayout(parent);
+    
+    // Filter type, in FilterType order
+    layout->addWidget(new QLabel("Type:"), 0, 0);
+    m_filterTypeCombo = new QComboBox();
+    m_filterTypeCombo->addItems({"Off", "Low-pass", "Band-pass", "High-pass", "Ladder"});
+    layout->addWidget(m_filterTypeCombo, 0, 1, 1, 2);
+    connect(m_filterTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onFilterTypeChanged);
+    
+    // Cutoff
+    layout->addWidget(new QLabel("Cutoff:"), 1, 0);
+    m_filterCutoffSlider = new QSlider(Qt::Horizontal);
+    m_filterCutoffSlider->setRange(0, 1000); // 20 Hz to 20 kHz, logarithmic
+    m_filterCutoffSlider->setValue(667); // 2 kHz
+    m_filterCutoffLabel = new QLabel("2000 Hz");
+    layout->addWidget(m_filterCutoffSlider, 1, 1);
+    layout->addWidget(m_filterCutoffLabel, 1, 2);
+    connect(m_filterCutoffSlider, &QSlider::valueChanged, this, &MainWindow::onFilterCutoffChanged);
+    
+    // Resonance
+    layout->addWidget(new QLabel("Resonance:"), 2, 0);
+    m_filterResonanceSlider = new QSlider(Qt::Horizontal);
+    m_filterResonanceSlider->setRange(0, 100);
+    m_filterResonanceSlider->setValue(20); // 0.2
+    m_filterResonanceLabel = new QLabel("0.20");
+    layout->addWidget(m_filterResonanceSlider, 2, 1);
+    layout->addWidget(m_filterResonanceLabel, 2, 2);
+    connect(m_filterResonanceSlider, &QSlider::valueChanged, this, &MainWindow::onFilterResonanceChanged);
+    
+    // Envelope amount
+    layout->addWidget(new QLabel("Env Amount:"), 3, 0);
+    m_filterEnvelopeSlider = new QSlider(Qt::Horizontal);
+    m_filterEnvelopeSlider->setRange(-60, 60); // -6 to 6 octaves
+    m_filterEnvelopeSlider->setValue(0);
+    m_filterEnvelopeLabel = new QLabel("0.0 oct");
+    layout->addWidget(m_filterEnvelopeSlider, 3, 1);
+    layout->addWidget(m_filterEnvelopeLabel, 3, 2);
+    connect(m_filterEnvelopeSlider, &QSlider::valueChanged, this, &MainWindow::onFilterEnvelopeAmountChanged);
+    
+    // Key tracking
+    layout->addWidget(new QLabel("Key Tracking:"), 4, 0);
+    m_filterKeyTrackingSlider = new QSlider(Qt::Horizontal);
+    m_filterKeyTrackingSlider->setRange(0, 100);
+    m_filterKeyTrackingSlider->setValue(0);
+    m_filterKeyTrackingLabel = new QLabel("0%");
+    layout->addWidget(m_filterKeyTrackingSlider, 4, 1);
+    layout->addWidget(m_filterKeyTrackingLabel, 4, 2);
+    connect(m_filterKeyTrackingSlider, &QSlider::valueChanged, this, &MainWindow::onFilterKeyTrackingChanged);
+    
+    // Filter envelope attack
+    layout->addWidget(new QLabel("Env Attack:"), 5, 0);
+    m_filterAttackSlider = new QSlider(Qt::Horizontal);
+    m_filterAttackSlider->setRange(1, 5000); // 0.001 to 5.0 seconds
+    m_filterAttackSlider->setValue(10); // 0.01 seconds
+    m_filterAttackLabel = new QLabel("0.010s");
+    layout->addWidget(m_filterAttackSlider, 5, 1);
+    layout->addWidget(m_filterAttackLabel, 5, 2);
+    connect(m_filterAttackSlider, &QSlider::valueChanged, this, &MainWindow::onFilterAttackChanged);
+    
+    // Filter envelope decay
+    layout->addWidget(new QLabel("Env Decay:"), 6, 0);
+    m_filterDecaySlider = new QSlider(Qt::Horizontal);
+    m_filterDecaySlider->setRange(1, 5000);
+    m_filterDecaySlider->setValue(300); // 0.3 seconds
+    m_filterDecayLabel = new QLabel("0.300s");
+    layout->addWidget(m_filterDecaySlider, 6, 1);
+    layout->addWidget(m_filterDecayLabel, 6, 2);
+    connect(m_filterDecaySlider, &QSlider::valueChanged, this, &MainWindow::onFilterDecayChanged);
+    
+    // Filter envelope sustain
+    layout->addWidget(new QLabel("Env Sustain:"), 7, 0);
+    m_filterSustainSlider = new QSlider(Qt::Horizontal);
+    m_filterSustainSlider->setRange(0, 100);
+    m_filterSustainSlider->setValue(50); // 0.5 level
+    m_filterSustainLabel = new QLabel("0.50");
+    layout->addWidget(m_filterSustainSlider, 7, 1);
+    layout->addWidget(m_filterSustainLabel, 7, 2);
+    connect(m_filterSustainSlider, &QSlider::valueChanged, this, &MainWindow::onFilterSustainChanged);
+    
+    // Filter envelope release
+    layout->addWidget(new QLabel("Env Release:"), 8, 0);
+    m_filterReleaseSlider = new QSlider(Qt::Horizontal);
+    m_filterReleaseSlider->setRange(1, 5000);
+    m_filterReleaseSlider->setValue(500); // 0.5 seconds
+    m_filterReleaseLabel = new QLabel("0.500s");
+    layout->addWidget(m_filterReleaseSlider, 8, 1);
+    layout->addWidget(m_filterReleaseLabel, 8, 2);
+    connect(m_filterReleaseSlider, &QSlider::valueChanged, this, &MainWindow::onFilterReleaseChanged);
 }
 
 void MainWindow::setupEffectsControls(QGroupBox* parent)
@@ -232,6 +402,108 @@ void MainWindow::setupEffectsControls(QGroupBox* parent)
     layout->addWidget(m_delaySlider, 1, 1);
     layout->addWidget(m_delayLabel, 1, 2);
     connect(m_delaySlider, &QSlider::valueChanged, this, &MainWindow::onDelayChanged);
+    
+    // Reverb room size
+    layout->addWidget(new QLabel("Room Size:"), 2, 0);
+    m_roomSizeSlider = new QSlider(Qt::Horizontal);
+    m_roomSizeSlider->setRange(0, 100);
+    m_roomSizeSlider->setValue(50);
+    m_roomSizeLabel = new QLabel("50%");
+    layout->addWidget(m_roomSizeSlider, 2, 1);
+    layout->addWidget(m_roomSizeLabel, 2, 2);
+    connect(m_roomSizeSlider, &QSlider::valueChanged, this, &MainWindow::onRoomSizeChanged);
+    
+    // Reverb damping
+    layout->addWidget(new QLabel("Damping:"), 3, 0);
+    m_dampingSlider = new QSlider(Qt::Horizontal);
+    m_dampingSlider->setRange(0, 100);
+    m_dampingSlider->setValue(50);
+    m_dampingLabel = new QLabel("50%");
+    layout->addWidget(m_dampingSlider, 3, 1);
+    layout->addWidget(m_dampingLabel, 3, 2);
+    connect(m_dampingSlider, &QSlider::valueChanged, this, &MainWindow::onDampingChanged);
+    
+    // Convolution reverb
+    layout->addWidget(new QLabel("Convolution:"), 4, 0);
+    m_convolutionSlider = new QSlider(Qt::Horizontal);
+    m_convolutionSlider->setRange(0, 100);
+    m_convolutionSlider->setValue(30);
+    m_convolutionLabel = new QLabel("30%");
+    layout->addWidget(m_convolutionSlider, 4, 1);
+    layout->addWidget(m_convolutionLabel, 4, 2);
+    connect(m_convolutionSlider, &QSlider::valueChanged, this, &MainWindow::onConvolutionChanged);
+    
+    m_impulseResponseButton = new QPushButton("Load IR...");
+    m_impulseResponseLabel = new QLabel("No impulse response");
+    layout->addWidget(m_impulseResponseButton, 5, 0);
+    layout->addWidget(m_impulseResponseLabel, 5, 1, 1, 2);
+    connect(m_impulseResponseButton, &QPushButton::clicked, this, &MainWindow::onLoadImpulseResponseClicked);
+    
+    // Delay mode, in DelayMode order
+    layout->addWidget(new QLabel("Delay Mode:"), 6, 0);
+    m_delayModeCombo = new QComboBox();
+    m_delayModeCombo->addItems({"Echo", "Ping-Pong", "Chorus", "Flanger"});
+    layout->addWidget(m_delayModeCombo, 6, 1, 1, 2);
+    connect(m_delayModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onDelayModeChanged);
+    
+    // Delay time (ms) and feedback
+    layout->addWidget(new QLabel("Delay Time:"), 7, 0);
+    m_delayTimeSlider = new QSlider(Qt::Horizontal);
+    m_delayTimeSlider->setRange(1, 2000);
+    m_delayTimeSlider->setValue(300);
+    m_delayTimeLabel = new QLabel("300 ms");
+    layout->addWidget(m_delayTimeSlider, 7, 1);
+    layout->addWidget(m_delayTimeLabel, 7, 2);
+    connect(m_delayTimeSlider, &QSlider::valueChanged, this, &MainWindow::onDelayTimeChanged);
+    
+    layout->addWidget(new QLabel("Feedback:"), 8, 0);
+    m_delayFeedbackSlider = new QSlider(Qt::Horizontal);
+    m_delayFeedbackSlider->setRange(0, 95);
+    m_delayFeedbackSlider->setValue(30);
+    m_delayFeedbackLabel = new QLabel("30%");
+    layout->addWidget(m_delayFeedbackSlider, 8, 1);
+    layout->addWidget(m_delayFeedbackLabel, 8, 2);
+    connect(m_delayFeedbackSlider, &QSlider::valueChanged, this, &MainWindow::onDelayFeedbackChanged);
+    
+    // Tempo sync: echo length in beats (quarter notes) at the BPM
+    layout->addWidget(new QLabel("Sync:"), 9, 0);
+    m_delaySyncCombo = new QComboBox();
+    m_delaySyncCombo->addItem("Off", 0.0);
+    m_delaySyncCombo->addItem("1/4", 1.0);
+    m_delaySyncCombo->addItem("1/8", 0.5);
+    m_delaySyncCombo->addItem("1/8 dotted", 0.75);
+    m_delaySyncCombo->addItem("1/8 triplet", 1.0 / 3.0);
+    m_delaySyncCombo->addItem("1/16", 0.25);
+    m_tempoSpin = new QSpinBox();
+    m_tempoSpin->setRange(20, 300);
+    m_tempoSpin->setValue(120);
+    m_tempoSpin->setSuffix(" BPM");
+    layout->addWidget(m_delaySyncCombo, 9, 1);
+    layout->addWidget(m_tempoSpin, 9, 2);
+    connect(m_delaySyncCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onDelaySyncChanged);
+    connect(m_tempoSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onDelaySyncChanged);
+    
+    // Chorus and flanger modulation
+    layout->addWidget(new QLabel("Mod Rate:"), 10, 0);
+    m_delayModRateSlider = new QSlider(Qt::Horizontal);
+    m_delayModRateSlider->setRange(1, 100);
+    m_delayModRateSlider->setValue(5);
+    m_delayModRateLabel = new QLabel("0.5 Hz");
+    layout->addWidget(m_delayModRateSlider, 10, 1);
+    layout->addWidget(m_delayModRateLabel, 10, 2);
+    connect(m_delayModRateSlider, &QSlider::valueChanged, this, &MainWindow::onDelayModulationRateChanged);
+    
+    layout->addWidget(new QLabel("Mod Depth:"), 11, 0);
+    m_delayModDepthSlider = new QSlider(Qt::Horizontal);
+    m_delayModDepthSlider->setRange(0, 100);
+    m_delayModDepthSlider->setValue(50);
+    m_delayModDepthLabel = new QLabel("50%");
+    layout->addWidget(m_delayModDepthSlider, 11, 1);
+    layout->addWidget(m_delayModDepthLabel, 11, 2);
+    connect(m_delayModDepthSlider, &QSlider::valueChanged, this, &MainWindow::onDelayModulationDepthChanged);
 }
 
 void MainWindow::setupRecordingControls(QGroupBox* parent)
@@ -249,12 +521,42 @@ void MainWindow::setupRecordingControls(QGroupBox* parent)
     m_exportButton = new QPushButton("Export...");
     connect(m_exportButton, &QPushButton::clicked, this, &MainWindow::onExportClicked);
     
+    m_diskRecordButton = new QPushButton("Record to Disk...");
+    m_diskRecordButton->setCheckable(true);
+    connect(m_diskRecordButton, &QPushButton::toggled, this, &MainWindow::onDiskRecordToggled);
+    
     layout->addWidget(m_recordButton);
     layout->addWidget(m_playButton);
     layout->addWidget(m_exportButton);
+    layout->addWidget(m_diskRecordButton);
 }
 
 // Slot implementations
+void MainWindow::setupPerformanceMeter(QGroupBox* parent)
+{
+    QVBoxLayout* layout = new QVBoxLayout(parent);
+    
+    layout->addWidget(new QLabel("DSP Load:"));
+    m_loadMeter = new QProgressBar();
+    m_loadMeter->setRange(0, 100);
+    m_loadMeter->setValue(0);
+    m_loadMeter->setFormat("%p%");
+    layout->addWidget(m_loadMeter);
+    
+    m_performanceLabel = new QLabel("Peak: 0%\nXruns: 0\nVoices: 0");
+    layout->addWidget(m_performanceLabel);
+    
+    m_resetMeterButton = new QPushButton("Reset");
+    layout->addWidget(m_resetMeterButton);
+    connect(m_resetMeterButton, &QPushButton::clicked, this, [this]() {
+        if (m_audioEngine) {
+            m_audioEngine->resetProfiler();
+        }
+    });
+    
+    layout->addStretch();
+}
+
 void MainWindow::onAttackChanged(int value)
 {
     float attack = value / 1000.0f; // Convert to seconds
@@ -291,6 +593,13 @@ void MainWindow::onReleaseChanged(int value)
     }
 }
 
+void MainWindow::onEnvelopeCurveChanged(int index)
+{
+    if (m_audioEngine) {
+        m_audioEngine->setEnvelopeCurve(static_cast<EnvelopeCurve>(index));
+    }
+}
+
 void MainWindow::onWaveformChanged(int index)
 {
     if (m_audioEngine) {
@@ -305,6 +614,14 @@ void MainWindow::onOscillatorCountChanged(int count)
     }
 }
 
+void MainWindow::onOversamplingChanged()
+{
+    if (m_audioEngine) {
+        m_audioEngine->setOversampling(m_oversamplingCombo->currentData().toInt(),
+                                       static_cast<OversamplingQuality>(m_oversamplingQualityCombo->currentIndex()));
+    }
+}
+
 void MainWindow::onVibratoRateChanged(int value)
 {
     float rate = value / 10.0f; // 0 to 20 Hz
@@ -323,6 +640,106 @@ void MainWindow::onVibratoDepthChanged(int value)
     }
 }
 
+void MainWindow::onFilterTypeChanged(int index)
+{
+    if (m_audioEngine) {
+        m_audioEngine->setFilterType(static_cast<FilterType>(index));
+    }
+}
+
+void MainWindow::onFilterCutoffChanged(int value)
+{
+    float cutoff = 20.0f * std::pow(1000.0f, value / 1000.0f); // 20 Hz to 20 kHz
+    m_filterCutoffLabel->setText(QString("%1 Hz").arg(cutoff, 0, 'f', 0));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterCutoff(cutoff);
+    }
+}
+
+void MainWindow::onFilterResonanceChanged(int value)
+{
+    float resonance = value / 100.0f;
+    m_filterResonanceLabel->setText(QString("%1").arg(resonance, 0, 'f', 2));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterResonance(resonance);
+    }
+}
+
+void MainWindow::onFilterEnvelopeAmountChanged(int value)
+{
+    float octaves = value / 10.0f; // -6 to 6 octaves
+    m_filterEnvelopeLabel->setText(QString("%1 oct").arg(octaves, 0, 'f', 1));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterEnvelopeAmount(octaves);
+    }
+}
+
+void MainWindow::onFilterKeyTrackingChanged(int value)
+{
+    m_filterKeyTrackingLabel->setText(QString("%1%").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterKeyTracking(value / 100.0f);
+    }
+}
+
+void MainWindow::onFilterAttackChanged(int value)
+{
+    float attack = value / 1000.0f;
+    m_filterAttackLabel->setText(QString("%1s").arg(attack, 0, 'f', 3));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterAttack(attack);
+    }
+}
+
+void MainWindow::onFilterDecayChanged(int value)
+{
+    float decay = value / 1000.0f;
+    m_filterDecayLabel->setText(QString("%1s").arg(decay, 0, 'f', 3));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterDecay(decay);
+    }
+}
+
+void MainWindow::onFilterSustainChanged(int value)
+{
+    float sustain = value / 100.0f;
+    m_filterSustainLabel->setText(QString("%1").arg(sustain, 0, 'f', 2));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterSustain(sustain);
+    }
+}
+
+void MainWindow::onFilterReleaseChanged(int value)
+{
+    float release = value / 1000.0f;
+    m_filterReleaseLabel->setText(QString("%1s").arg(release, 0, 'f', 3));
+    if (m_audioEngine) {
+        m_audioEngine->setFilterRelease(release);
+    }
+}
+
+void MainWindow::onPanChanged(int value)
+{
+    float pan = value / 100.0f; // -1 to 1
+    if (value == 0) {
+        m_panLabel->setText("C");
+    } else {
+        m_panLabel->setText(QString("%1%2").arg(value < 0 ? "L" : "R").arg(std::abs(value)));
+    }
+    if (m_audioEngine) {
+        m_audioEngine->setPan(pan);
+    }
+}
+
+void MainWindow::onStereoSpreadChanged(int value)
+{
+    float spread = value / 100.0f; // 0 to 1
+    m_spreadLabel->setText(QString("%1%").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setStereoSpread(spread);
+    }
+}
+
 void MainWindow::onReverbChanged(int value)
 {
     float reverb = value / 100.0f;
@@ -341,6 +758,95 @@ void MainWindow::onDelayChanged(int value)
     }
 }
 
+void MainWindow::onDelayModeChanged(int index)
+{
+    if (m_audioEngine) {
+        m_audioEngine->setDelayMode(static_cast<DelayMode>(index));
+    }
+}
+
+void MainWindow::onDelayTimeChanged(int value)
+{
+    m_delayTimeLabel->setText(QString("%1 ms").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setDelayTime(value / 1000.0f);
+    }
+}
+
+void MainWindow::onDelayFeedbackChanged(int value)
+{
+    m_delayFeedbackLabel->setText(QString("%1%").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setDelayFeedback(value / 100.0f);
+    }
+}
+
+void MainWindow::onDelaySyncChanged()
+{
+    // The time slider only applies while sync is off
+    const float beats = m_delaySyncCombo->currentData().toFloat();
+    m_delayTimeSlider->setEnabled(beats <= 0.0f);
+    if (m_audioEngine) {
+        m_audioEngine->setTempo(static_cast<float>(m_tempoSpin->value()));
+        m_audioEngine->setDelaySync(beats);
+    }
+}
+
+void MainWindow::onDelayModulationRateChanged(int value)
+{
+    float rate = value / 10.0f;
+    m_delayModRateLabel->setText(QString("%1 Hz").arg(rate, 0, 'f', 1));
+    if (m_audioEngine) {
+        m_audioEngine->setDelayModulationRate(rate);
+    }
+}
+
+void MainWindow::onDelayModulationDepthChanged(int value)
+{
+    m_delayModDepthLabel->setText(QString("%1%").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setDelayModulationDepth(value / 100.0f);
+    }
+}
+
+void MainWindow::onRoomSizeChanged(int value)
+{
+    m_roomSizeLabel->setText(QString("%1%").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setReverbRoomSize(value / 100.0f);
+    }
+}
+
+void MainWindow::onDampingChanged(int value)
+{
+    m_dampingLabel->setText(QString("%1%").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setReverbDamping(value / 100.0f);
+    }
+}
+
+void MainWindow::onConvolutionChanged(int value)
+{
+    m_convolutionLabel->setText(QString("%1%").arg(value));
+    if (m_audioEngine) {
+        m_audioEngine->setConvolutionMix(value / 100.0f);
+    }
+}
+
+void MainWindow::onLoadImpulseResponseClicked()
+{
+    QString filename = QFileDialog::getOpenFileName(this,
+        "Load Impulse Response",
+        QString(),
+        "WAV Files (*.wav)");
+    
+    if (!filename.isEmpty() && m_audioEngine) {
+        // Prepared in the background; the reverb switches over when it is ready
+        m_audioEngine->loadImpulseResponse(filename.toStdString());
+        m_impulseResponseLabel->setText(QFileInfo(filename).fileName());
+    }
+}
+
 void MainWindow::onRecordToggled()
 {
     if (m_recordButton->isChecked()) {
@@ -371,6 +877,28 @@ void MainWindow::onPlayToggled()
     }
 }
 
+void MainWindow::onDiskRecordToggled()
+{
+    if (!m_audioEngine) return;
+    
+    if (m_diskRecordButton->isChecked()) {
+        QString filename = QFileDialog::getSaveFileName(this,
+            "Record to Disk",
+            "session.wav",
+            "WAV Files (*.wav)");
+        
+        if (filename.isEmpty() || !m_audioEngine->startStreamingRecording(filename.toStdString())) {
+            // Unchecking re-enters this slot, which then just stops the (idle) recorder
+            m_diskRecordButton->setChecked(false);
+            return;
+        }
+        m_diskRecordButton->setText("Stop Disk Recording");
+    } else {
+        m_audioEngine->stopStreamingRecording();
+        m_diskRecordButton->setText("Record to Disk...");
+    }
+}
+
 void MainWindow::onExportClicked()
 {
     QString filename = QFileDialog::getSaveFileName(this, 
@@ -379,27 +907,61 @@ void MainWindow::onExportClicked()
         "WAV Files (*.wav);;MIDI Files (*.mid);;Note Events (*.txt)");
     
     if (!filename.isEmpty() && m_audioEngine) {
-        m_audioEngine->exportToFile(filename.toStdString());
-        QMessageBox::information(this, "Export", "File exported successfully!");
+        if (m_audioEngine->exportToFile(filename.toStdString())) {
+            QMessageBox::information(this, "Export", "File exported successfully!");
+        } else {
+            QMessageBox::warning(this, "Export", "Export failed. Stop recording and make sure there is something to export.");
+        }
     }
 }
 
 void MainWindow::updateFFTDisplay()
 {
-    if (!m_audioEngine || !m_fftAnalyzer) return;
+    if (!m_audioEngine || !m_audioEngine->getSpectrum(m_spectrum)) return;
     
-    auto fftData = m_audioEngine->getFFTData();
-    if (fftData.size() >= 1024) {
-        m_fftAnalyzer->processBuffer(fftData);
-        auto spectrum = m_fftAnalyzer->getMagnitudeSpectrum();
-        
-        // Update progress bars (logarithmic frequency spacing)
-        for (int i = 0; i < 32; ++i) {
-            int binIndex = static_cast<int>(std::pow(2.0, i * 9.0 / 32.0)); // Logarithmic mapping
-            if (binIndex < static_cast<int>(spectrum.size())) {
-                int value = static_cast<int>(spectrum[binIndex] * 100);
-                m_fftDisplay[i]->setValue(value);
-            }
-        }
+    // Log-frequency bands, computed by the analysis thread
+    m_spectrumWidget->addSpectrum(m_spectrum);
+}
+
+void MainWindow::onSpectrumSettingsChanged()
+{
+    if (!m_audioEngine) return;
+    
+    SpectrumSettings settings;
+    settings.fftSize = m_fftSizeCombo->currentData().toInt();
+    settings.hopSize = settings.fftSize / 4;
+    settings.window = static_cast<WindowType>(m_fftWindowCombo->currentIndex());
+    settings.averaging = static_cast<SpectrumAveraging>(m_fftAveragingCombo->currentIndex());
+    settings.bands = SPECTRUM_BANDS;
+    m_audioEngine->setSpectrumSettings(settings);
+}
+
+void MainWindow::updatePerformanceMeter()
+{
+    if (!m_audioEngine) return;
+    
+    ProfilerSnapshot stats = m_audioEngine->getProfilerSnapshot();
+    m_loadMeter->setValue(std::min(100, static_cast<int>(stats.averageLoad * 100.0f)));
+    
+    // Xruns: driver-reported underflows plus callbacks that overran their deadline
+    m_performanceLabel->setText(QString("Peak: %1%\nXruns: %2 (late: %3)\nVoices: %4/%5")
+        .arg(static_cast<int>(stats.peakLoad * 100.0f))
+        .arg(stats.underflows)
+        .arg(stats.deadlineMisses)
+        .arg(m_audioEngine->getActiveVoiceCount())
+        .arg(m_audioEngine->getMaxVoices()));
+    
+    static const char* stageNames[ProfilerSnapshot::STAGE_COUNT] = {
+        "Events", "Voices", "Effects", "Recorder", "FFT tap"
+    };
+    QString details = QString("Worst callback: %1 us\nWorst interval: %2 us")
+        .arg(stats.worstCallbackMicros, 0, 'f', 1)
+        .arg(stats.worstIntervalMicros, 0, 'f', 1);
+    for (int i = 0; i < ProfilerSnapshot::STAGE_COUNT; ++i) {
+        details += QString("\n%1: %2 us avg, %3 us worst")
+            .arg(stageNames[i])
+            .arg(stats.stageAverageMicros[i], 0, 'f', 1)
+            .arg(stats.stageWorstMicros[i], 0, 'f', 1);
     }
+    m_performanceGroup->setToolTip(details);
 }
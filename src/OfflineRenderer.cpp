@@ -0,0 +1,101 @@
+#include "vsynth/OfflineRenderer.h"
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+OfflineRenderer::OfflineRenderer(int sampleRate, int maxVoices, int renderThreads)
+    : m_sampleRate(sampleRate)
+    , m_blockSize(DEFAULT_BLOCK_SIZE)
+    , m_channels(Synthesizer::CHANNELS)
+    , m_tailSeconds(2.0f)
+    , m_lastRenderSeconds(0.0)
+    , m_bus(Synthesizer::CHANNELS, DEFAULT_BLOCK_SIZE)
+{
+    m_synthesizer = std::make_unique<Synthesizer>(sampleRate, maxVoices, renderThreads);
+    m_buffer.resize(static_cast<size_t>(m_blockSize) * m_channels, 0.0f);
+}
+
+void OfflineRenderer::setBlockSize(int frames)
+{
+    m_blockSize = std::max(1, frames);
+    m_bus = AudioBus(Synthesizer::CHANNELS, m_blockSize);
+    m_buffer.resize(static_cast<size_t>(m_blockSize) * m_channels, 0.0f);
+}
+
+void OfflineRenderer::setChannels(int channels)
+{
+    m_channels = std::max(1, channels);
+    m_buffer.resize(static_cast<size_t>(m_blockSize) * m_channels, 0.0f);
+}
+
+void OfflineRenderer::setTailSeconds(float seconds)
+{
+    m_tailSeconds = std::max(0.0f, seconds);
+}
+
+uint64_t OfflineRenderer::render(const std::vector<NoteEvent>& events, WavWriter* writer)
+{
+    auto start = std::chrono::steady_clock::now();
+    m_synthesizer->settleParameters();
+
+    auto eventFrame = [](const NoteEvent& event) {
+        return static_cast<int64_t>(event.samplePosition);
+    };
+
+    const int64_t lastEventFrame = events.empty() ? 0 : eventFrame(events.back());
+    const int64_t totalFrames = lastEventFrame + static_cast<int64_t>(m_tailSeconds * m_sampleRate);
+
+    size_t nextEvent = 0;
+    int64_t frame = 0;
+
+    while (frame < totalFrames) {
+        const int count = static_cast<int>(std::min<int64_t>(m_blockSize, totalFrames - frame));
+        int offset = 0;
+
+        // Render up to each event inside the block, then apply it
+        while (offset < count) {
+            while (nextEvent < events.size() && eventFrame(events[nextEvent]) <= frame + offset) {
+                applyEvent(events[nextEvent++]);
+            }
+
+            int segment = count - offset;
+            if (nextEvent < events.size()) {
+                segment = static_cast<int>(std::min<int64_t>(segment, eventFrame(events[nextEvent]) - (frame + offset)));
+            }
+
+            m_synthesizer->renderBlock(m_bus.channel(0) + offset, m_bus.channel(1) + offset, segment);
+            offset += segment;
+        }
+
+        m_bus.writeInterleaved(m_buffer.data(), m_channels, count);
+        if (writer && !writer->write(m_buffer.data(), count)) {
+            std::cerr << "Offline render: failed to write audio" << std::endl;
+            break;
+        }
+        frame += count;
+    }
+
+    m_lastRenderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<uint64_t>(frame);
+}
+
+bool OfflineRenderer::renderToWAV(const std::vector<NoteEvent>& events, const std::string& filename)
+{
+    WavWriter writer;
+    if (!writer.open(filename, m_sampleRate, m_channels)) {
+        return false;
+    }
+
+    const uint64_t frames = render(events, &writer);
+    writer.close();
+    return frames == writer.framesWritten();
+}
+
+void OfflineRenderer::applyEvent(const NoteEvent& event)
+{
+    if (event.isNoteOn) {
+        m_synthesizer->noteOn(event.note, event.velocity);
+    } else {
+        m_synthesizer->noteOff(event.note);
+    }
+}
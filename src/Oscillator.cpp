@@ -1,5 +1,7 @@
 #include "vsynth/Oscillator.h"
+#include "vsynth/Wavetable.h"
 #include <random>
+#include <algorithm>
 
 Oscillator::Oscillator(float frequency, int sampleRate)
     : m_frequency(frequency)
@@ -14,33 +16,86 @@ Oscillator::Oscillator(float frequency, int sampleRate)
 
 float Oscillator::process()
 {
-    float output = 0.0f;
+    float output;
+    renderBlock(&output, 1);
+    return output;
+}
+
+void Oscillator::renderBlock(float* out, int frames, const float* frequencyScale)
+{
+    renderWaveform(m_waveform, out, frames, m_phase, m_phaseIncrement, frequencyScale, m_lastNoise);
     
-    switch (m_waveform) {
+    if (m_amplitude != 1.0f) {
+        for (int i = 0; i < frames; ++i) {
+            out[i] *= m_amplitude;
+        }
+    }
+}
+
+void Oscillator::renderWaveform(WaveformType waveform, float* out, int frames,
+                                float& phase, float increment,
+                                const float* frequencyScale, float& noiseState)
+{
+    // Waveform dispatch happens once per block instead of once per sample
+    switch (waveform) {
         case WaveformType::SINE:
-            output = generateSine();
+            renderWith(generateSine, out, frames, phase, increment, frequencyScale);
             break;
         case WaveformType::SQUARE:
-            output = generateSquare();
+            renderWith(generateSquare, out, frames, phase, increment, frequencyScale);
             break;
         case WaveformType::SAWTOOTH:
-            output = generateSawtooth();
+            renderWith(generateSawtooth, out, frames, phase, increment, frequencyScale);
             break;
         case WaveformType::TRIANGLE:
-            output = generateTriangle();
+            renderWith(generateTriangle, out, frames, phase, increment, frequencyScale);
             break;
         case WaveformType::NOISE:
-            output = generateNoise();
+            renderWith([&noiseState](float) { return generateNoise(noiseState); },
+                       out, frames, phase, increment, frequencyScale);
+            break;
+        case WaveformType::BANDLIMITED_SQUARE:
+        case WaveformType::BANDLIMITED_SAWTOOTH:
+        case WaveformType::BANDLIMITED_TRIANGLE: {
+            // Pick the mip level for the highest frequency reached in this block
+            float maxScale = 1.0f;
+            if (frequencyScale) {
+                maxScale = *std::max_element(frequencyScale, frequencyScale + frames);
+            }
+            const Wavetable* wavetable = Wavetable::forWaveform(waveform);
+            const float* table = wavetable->level(wavetable->levelFor(increment * maxScale));
+            renderWith([table](float p) { return Wavetable::lookup(table, p); },
+                       out, frames, phase, increment, frequencyScale);
             break;
+        }
     }
+}
+
+template <typename Generator>
+void Oscillator::renderWith(Generator generate, float* out, int frames, float& phase,
+                            float increment, const float* frequencyScale)
+{
+    float p = phase;
     
-    // Advance phase
-    m_phase += m_phaseIncrement;
-    if (m_phase >= TWO_PI) {
-        m_phase -= TWO_PI;
+    if (frequencyScale) {
+        for (int i = 0; i < frames; ++i) {
+            out[i] = generate(p);
+            p += increment * frequencyScale[i];
+            if (p >= TWO_PI) {
+                p -= TWO_PI;
+            }
+        }
+    } else {
+        for (int i = 0; i < frames; ++i) {
+            out[i] = generate(p);
+            p += increment;
+            if (p >= TWO_PI) {
+                p -= TWO_PI;
+            }
+        }
     }
     
-    return output * m_amplitude;
+    phase = p;
 }
 
 void Oscillator::setFrequency(float frequency)
@@ -64,31 +119,31 @@ void Oscillator::setPhase(float phase)
     m_phase = phase;
 }
 
-float Oscillator::generateSine()
+float Oscillator::generateSine(float phase)
 {
-    return std::sin(m_phase);
+    return std::sin(phase);
 }
 
-float Oscillator::generateSquare()
+float Oscillator::generateSquare(float phase)
 {
-    return (m_phase < M_PI) ? 1.0f : -1.0f;
+    return (phase < M_PI) ? 1.0f : -1.0f;
 }
 
-float Oscillator::generateSawtooth()
+float Oscillator::generateSawtooth(float phase)
 {
-    return (2.0f * m_phase / TWO_PI) - 1.0f;
+    return (2.0f * phase / TWO_PI) - 1.0f;
 }
 
-float Oscillator::generateTriangle()
+float Oscillator::generateTriangle(float phase)
 {
-    if (m_phase < M_PI) {
-        return (2.0f * m_phase / M_PI) - 1.0f;
+    if (phase < M_PI) {
+        return (2.0f * phase / M_PI) - 1.0f;
     } else {
-        return 3.0f - (2.0f * m_phase / M_PI);
+        return 3.0f - (2.0f * phase / M_PI);
     }
 }
 
-float Oscillator::generateNoise()
+float Oscillator::generateNoise(float& noiseState)
 {
     static std::random_device rd;
     static std::mt19937 gen(rd());
@@ -96,6 +151,6 @@ float Oscillator::generateNoise()
     
     // Simple low-pass filtered noise
     float noise = dis(gen);
-    m_lastNoise = m_lastNoise * 0.99f + noise * 0.01f;
-    return m_lastNoise;
+    noiseState = noiseState * 0.99f + noise * 0.01f;
+    return noiseState;
 }
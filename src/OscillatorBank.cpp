@@ -0,0 +1,607 @@
+#include "vsynth/OscillatorBank.h"
+#include "vsynth/Wavetable.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef VSYNTH_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr float PI_F = 3.14159265358979f;
+constexpr float TWO_PI_F = 2.0f * PI_F;
+constexpr float INV_PI_F = 1.0f / PI_F;
+
+// Taylor coefficients of sin(x) on [-pi/2, pi/2] (max error ~4e-6)
+constexpr float SIN_C3 = -1.0f / 6.0f;
+constexpr float SIN_C5 = 1.0f / 120.0f;
+constexpr float SIN_C7 = -1.0f / 5040.0f;
+constexpr float SIN_C9 = 1.0f / 362880.0f;
+
+#ifdef VSYNTH_X86
+
+// SSE2 waveform kernels, phase in [0, 2*pi)
+
+inline __m128 sineSSE2(__m128 phase)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 pi = _mm_set1_ps(PI_F);
+
+    // sin(phase) = -sin(x) with x = phase - pi in [-pi, pi),
+    // folded to y = min(|x|, pi - |x|) in [0, pi/2]
+    __m128 x = _mm_sub_ps(phase, pi);
+    __m128 ax = _mm_andnot_ps(signMask, x);
+    __m128 y = _mm_min_ps(ax, _mm_sub_ps(pi, ax));
+    __m128 y2 = _mm_mul_ps(y, y);
+
+    __m128 poly = _mm_add_ps(_mm_set1_ps(SIN_C7), _mm_mul_ps(y2, _mm_set1_ps(SIN_C9)));
+    poly = _mm_add_ps(_mm_set1_ps(SIN_C5), _mm_mul_ps(y2, poly));
+    poly = _mm_add_ps(_mm_set1_ps(SIN_C3), _mm_mul_ps(y2, poly));
+    poly = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(y2, poly));
+    __m128 s = _mm_mul_ps(y, poly);
+
+    // Negative where x >= 0
+    return _mm_xor_ps(s, _mm_andnot_ps(x, signMask));
+}
+
+inline __m128 squareSSE2(__m128 phase)
+{
+    __m128 upperHalf = _mm_cmpge_ps(phase, _mm_set1_ps(PI_F));
+    return _mm_xor_ps(_mm_set1_ps(1.0f), _mm_and_ps(upperHalf, _mm_set1_ps(-0.0f)));
+}
+
+inline __m128 sawtoothSSE2(__m128 phase)
+{
+    return _mm_sub_ps(_mm_mul_ps(phase, _mm_set1_ps(INV_PI_F)), _mm_set1_ps(1.0f));
+}
+
+inline __m128 triangleSSE2(__m128 phase)
+{
+    __m128 saw = sawtoothSSE2(phase);
+    __m128 absSaw = _mm_andnot_ps(_mm_set1_ps(-0.0f), saw);
+    return _mm_sub_ps(_mm_set1_ps(1.0f), _mm_add_ps(absSaw, absSaw));
+}
+
+template <WaveformType W>
+inline __m128 waveSSE2(__m128 phase)
+{
+    if constexpr (W == WaveformType::SINE) {
+        return sineSSE2(phase);
+    } else if constexpr (W == WaveformType::SQUARE) {
+        return squareSSE2(phase);
+    } else if constexpr (W == WaveformType::SAWTOOTH) {
+        return sawtoothSSE2(phase);
+    } else {
+        return triangleSSE2(phase);
+    }
+}
+
+inline float horizontalSum(__m128 v)
+{
+    __m128 high = _mm_movehl_ps(v, v);
+    __m128 sum = _mm_add_ps(v, high);
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+// PerVoice kernels leave every voice in its own lane of left and right
+// (frame-major, stride lanes per frame) instead of mixing them, and skip gains
+template <WaveformType W, bool PerVoice>
+void renderLanesSSE2(float* phases, const float* increments, const float* leftLevels,
+                     const float* rightLevels, int stride, int begin, int end, int oscillatorCount,
+                     const float* frequencyScale, const float* gains, float* left, float* right,
+                     int frames)
+{
+    alignas(16) float leftAccumulators[OscillatorBank::MAX_FRAMES * 4];
+    alignas(16) float rightAccumulators[OscillatorBank::MAX_FRAMES * 4];
+    if constexpr (!PerVoice) {
+        std::fill(leftAccumulators, leftAccumulators + frames * 4, 0.0f);
+        std::fill(rightAccumulators, rightAccumulators + frames * 4, 0.0f);
+    }
+
+    const __m128 twoPi = _mm_set1_ps(TWO_PI_F);
+
+    for (int voice = begin; voice < end; voice += 4) {
+        if constexpr (PerVoice) {
+            for (int t = 0; t < frames; ++t) {
+                _mm_store_ps(left + t * stride + voice, _mm_setzero_ps());
+                _mm_store_ps(right + t * stride + voice, _mm_setzero_ps());
+            }
+        }
+        for (int osc = 0; osc < oscillatorCount; ++osc) {
+            float* phasePtr = phases + osc * stride + voice;
+            __m128 phase = _mm_load_ps(phasePtr);
+            const __m128 increment = _mm_load_ps(increments + osc * stride + voice);
+            const __m128 leftLevel = _mm_load_ps(leftLevels + osc * stride + voice);
+            const __m128 rightLevel = _mm_load_ps(rightLevels + osc * stride + voice);
+
+            for (int t = 0; t < frames; ++t) {
+                if constexpr (PerVoice) {
+                    __m128 wave = waveSSE2<W>(phase);
+                    float* leftLane = left + t * stride + voice;
+                    float* rightLane = right + t * stride + voice;
+                    _mm_store_ps(leftLane, _mm_add_ps(_mm_load_ps(leftLane), _mm_mul_ps(wave, leftLevel)));
+                    _mm_store_ps(rightLane, _mm_add_ps(_mm_load_ps(rightLane), _mm_mul_ps(wave, rightLevel)));
+                } else {
+                    __m128 wave = _mm_mul_ps(waveSSE2<W>(phase), _mm_load_ps(gains + t * stride + voice));
+                    __m128 leftAcc = _mm_load_ps(leftAccumulators + t * 4);
+                    __m128 rightAcc = _mm_load_ps(rightAccumulators + t * 4);
+                    _mm_store_ps(leftAccumulators + t * 4, _mm_add_ps(leftAcc, _mm_mul_ps(wave, leftLevel)));
+                    _mm_store_ps(rightAccumulators + t * 4, _mm_add_ps(rightAcc, _mm_mul_ps(wave, rightLevel)));
+                }
+
+                phase = _mm_add_ps(phase, _mm_mul_ps(increment, _mm_set1_ps(frequencyScale[t])));
+                phase = _mm_sub_ps(phase, _mm_and_ps(_mm_cmpge_ps(phase, twoPi), twoPi));
+            }
+
+            _mm_store_ps(phasePtr, phase);
+        }
+    }
+
+    if constexpr (!PerVoice) {
+        for (int t = 0; t < frames; ++t) {
+            left[t] += horizontalSum(_mm_load_ps(leftAccumulators + t * 4));
+            right[t] += horizontalSum(_mm_load_ps(rightAccumulators + t * 4));
+        }
+    }
+}
+
+// AVX2/FMA waveform kernels, same algorithms as the SSE2 versions
+
+VSYNTH_TARGET_AVX2 inline __m256 sineAVX2(__m256 phase)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 pi = _mm256_set1_ps(PI_F);
+
+    __m256 x = _mm256_sub_ps(phase, pi);
+    __m256 ax = _mm256_andnot_ps(signMask, x);
+    __m256 y = _mm256_min_ps(ax, _mm256_sub_ps(pi, ax));
+    __m256 y2 = _mm256_mul_ps(y, y);
+
+    __m256 poly = _mm256_fmadd_ps(y2, _mm256_set1_ps(SIN_C9), _mm256_set1_ps(SIN_C7));
+    poly = _mm256_fmadd_ps(y2, poly, _mm256_set1_ps(SIN_C5));
+    poly = _mm256_fmadd_ps(y2, poly, _mm256_set1_ps(SIN_C3));
+    poly = _mm256_fmadd_ps(y2, poly, _mm256_set1_ps(1.0f));
+    __m256 s = _mm256_mul_ps(y, poly);
+
+    return _mm256_xor_ps(s, _mm256_andnot_ps(x, signMask));
+}
+
+VSYNTH_TARGET_AVX2 inline __m256 squareAVX2(__m256 phase)
+{
+    __m256 upperHalf = _mm256_cmp_ps(phase, _mm256_set1_ps(PI_F), _CMP_GE_OQ);
+    return _mm256_xor_ps(_mm256_set1_ps(1.0f), _mm256_and_ps(upperHalf, _mm256_set1_ps(-0.0f)));
+}
+
+VSYNTH_TARGET_AVX2 inline __m256 sawtoothAVX2(__m256 phase)
+{
+    return _mm256_fmsub_ps(phase, _mm256_set1_ps(INV_PI_F), _mm256_set1_ps(1.0f));
+}
+
+VSYNTH_TARGET_AVX2 inline __m256 triangleAVX2(__m256 phase)
+{
+    __m256 saw = sawtoothAVX2(phase);
+    __m256 absSaw = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), saw);
+    return _mm256_fnmadd_ps(_mm256_set1_ps(2.0f), absSaw, _mm256_set1_ps(1.0f));
+}
+
+template <WaveformType W>
+VSYNTH_TARGET_AVX2 inline __m256 waveAVX2(__m256 phase)
+{
+    if constexpr (W == WaveformType::SINE) {
+        return sineAVX2(phase);
+    } else if constexpr (W == WaveformType::SQUARE) {
+        return squareAVX2(phase);
+    } else if constexpr (W == WaveformType::SAWTOOTH) {
+        return sawtoothAVX2(phase);
+    } else {
+        return triangleAVX2(phase);
+    }
+}
+
+VSYNTH_TARGET_AVX2 inline float horizontalSumAVX2(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+// Adds one frame of 8 voices' wave to their lanes (PerVoice), or scaled by
+// the gains to the frame's accumulators
+template <bool PerVoice>
+VSYNTH_TARGET_AVX2 inline void accumulateAVX2(__m256 wave, __m256 leftLevel, __m256 rightLevel,
+                                              const float* gains, float* leftAccumulators,
+                                              float* rightAccumulators, float* left, float* right,
+                                              int stride, int voice, int t)
+{
+    if constexpr (PerVoice) {
+        float* leftLane = left + t * stride + voice;
+        float* rightLane = right + t * stride + voice;
+        _mm256_store_ps(leftLane, _mm256_fmadd_ps(wave, leftLevel, _mm256_load_ps(leftLane)));
+        _mm256_store_ps(rightLane, _mm256_fmadd_ps(wave, rightLevel, _mm256_load_ps(rightLane)));
+    } else {
+        wave = _mm256_mul_ps(wave, _mm256_load_ps(gains + t * stride + voice));
+        __m256 leftAcc = _mm256_load_ps(leftAccumulators + t * 8);
+        __m256 rightAcc = _mm256_load_ps(rightAccumulators + t * 8);
+        _mm256_store_ps(leftAccumulators + t * 8, _mm256_fmadd_ps(wave, leftLevel, leftAcc));
+        _mm256_store_ps(rightAccumulators + t * 8, _mm256_fmadd_ps(wave, rightLevel, rightAcc));
+    }
+}
+
+template <WaveformType W, bool PerVoice>
+VSYNTH_TARGET_AVX2 void renderLanesAVX2(float* phases, const float* increments, const float* leftLevels,
+                                        const float* rightLevels, int stride, int begin, int end,
+                                        int oscillatorCount, const float* frequencyScale,
+                                        const float* gains, float* left, float* right, int frames)
+{
+    alignas(32) float leftAccumulators[OscillatorBank::MAX_FRAMES * 8];
+    alignas(32) float rightAccumulators[OscillatorBank::MAX_FRAMES * 8];
+    if constexpr (!PerVoice) {
+        std::fill(leftAccumulators, leftAccumulators + frames * 8, 0.0f);
+        std::fill(rightAccumulators, rightAccumulators + frames * 8, 0.0f);
+    }
+
+    const __m256 twoPi = _mm256_set1_ps(TWO_PI_F);
+
+    for (int voice = begin; voice < end; voice += 8) {
+        if constexpr (PerVoice) {
+            for (int t = 0; t < frames; ++t) {
+                _mm256_store_ps(left + t * stride + voice, _mm256_setzero_ps());
+                _mm256_store_ps(right + t * stride + voice, _mm256_setzero_ps());
+            }
+        }
+        for (int osc = 0; osc < oscillatorCount; ++osc) {
+            float* phasePtr = phases + osc * stride + voice;
+            __m256 phase = _mm256_load_ps(phasePtr);
+            const __m256 increment = _mm256_load_ps(increments + osc * stride + voice);
+            const __m256 leftLevel = _mm256_load_ps(leftLevels + osc * stride + voice);
+            const __m256 rightLevel = _mm256_load_ps(rightLevels + osc * stride + voice);
+
+            for (int t = 0; t < frames; ++t) {
+                __m256 wave = waveAVX2<W>(phase);
+                accumulateAVX2<PerVoice>(wave, leftLevel, rightLevel, gains, leftAccumulators,
+                                         rightAccumulators, left, right, stride, voice, t);
+
+                phase = _mm256_fmadd_ps(increment, _mm256_set1_ps(frequencyScale[t]), phase);
+                phase = _mm256_sub_ps(phase, _mm256_and_ps(_mm256_cmp_ps(phase, twoPi, _CMP_GE_OQ), twoPi));
+            }
+
+            _mm256_store_ps(phasePtr, phase);
+        }
+    }
+
+    if constexpr (!PerVoice) {
+        for (int t = 0; t < frames; ++t) {
+            left[t] += horizontalSumAVX2(_mm256_load_ps(leftAccumulators + t * 8));
+            right[t] += horizontalSumAVX2(_mm256_load_ps(rightAccumulators + t * 8));
+        }
+    }
+}
+
+// Band-limited wavetable voices: every lane reads its own mip level, so the
+// table samples are fetched with gathers from the shared level array
+template <bool PerVoice>
+VSYNTH_TARGET_AVX2 void renderWavetableAVX2(const Wavetable& wavetable, float* phases,
+                                            const float* increments, const float* leftLevels,
+                                            const float* rightLevels, int stride, int begin, int end,
+                                            int oscillatorCount, const float* frequencyScale,
+                                            const float* gains, float* left, float* right, int frames)
+{
+    alignas(32) float leftAccumulators[OscillatorBank::MAX_FRAMES * 8];
+    alignas(32) float rightAccumulators[OscillatorBank::MAX_FRAMES * 8];
+    if constexpr (!PerVoice) {
+        std::fill(leftAccumulators, leftAccumulators + frames * 8, 0.0f);
+        std::fill(rightAccumulators, rightAccumulators + frames * 8, 0.0f);
+    }
+
+    const float maxScale = *std::max_element(frequencyScale, frequencyScale + frames);
+    const float* table = wavetable.data();
+    const __m256 twoPi = _mm256_set1_ps(TWO_PI_F);
+    const __m256 phaseToIndex = _mm256_set1_ps(Wavetable::PHASE_TO_INDEX);
+    const __m256i one = _mm256_set1_epi32(1);
+
+    for (int voice = begin; voice < end; voice += 8) {
+        if constexpr (PerVoice) {
+            for (int t = 0; t < frames; ++t) {
+                _mm256_store_ps(left + t * stride + voice, _mm256_setzero_ps());
+                _mm256_store_ps(right + t * stride + voice, _mm256_setzero_ps());
+            }
+        }
+        for (int osc = 0; osc < oscillatorCount; ++osc) {
+            float* phasePtr = phases + osc * stride + voice;
+            const float* incrementPtr = increments + osc * stride + voice;
+
+            alignas(32) int levelOffsets[8];
+            for (int lane = 0; lane < 8; ++lane) {
+                levelOffsets[lane] = wavetable.levelFor(incrementPtr[lane] * maxScale)
+                                     * Wavetable::LEVEL_STRIDE;
+            }
+            const __m256i base = _mm256_load_si256(reinterpret_cast<const __m256i*>(levelOffsets));
+
+            __m256 phase = _mm256_load_ps(phasePtr);
+            const __m256 increment = _mm256_load_ps(incrementPtr);
+            const __m256 leftLevel = _mm256_load_ps(leftLevels + osc * stride + voice);
+            const __m256 rightLevel = _mm256_load_ps(rightLevels + osc * stride + voice);
+
+            for (int t = 0; t < frames; ++t) {
+                __m256 position = _mm256_mul_ps(phase, phaseToIndex);
+                __m256i index = _mm256_cvttps_epi32(position);
+                __m256 frac = _mm256_sub_ps(position, _mm256_cvtepi32_ps(index));
+                index = _mm256_add_epi32(index, base);
+
+                __m256 a = _mm256_i32gather_ps(table, index, 4);
+                __m256 b = _mm256_i32gather_ps(table, _mm256_add_epi32(index, one), 4);
+                __m256 wave = _mm256_fmadd_ps(frac, _mm256_sub_ps(b, a), a);
+                accumulateAVX2<PerVoice>(wave, leftLevel, rightLevel, gains, leftAccumulators,
+                                         rightAccumulators, left, right, stride, voice, t);
+
+                phase = _mm256_fmadd_ps(increment, _mm256_set1_ps(frequencyScale[t]), phase);
+                phase = _mm256_sub_ps(phase, _mm256_and_ps(_mm256_cmp_ps(phase, twoPi, _CMP_GE_OQ), twoPi));
+            }
+
+            _mm256_store_ps(phasePtr, phase);
+        }
+    }
+
+    if constexpr (!PerVoice) {
+        for (int t = 0; t < frames; ++t) {
+            left[t] += horizontalSumAVX2(_mm256_load_ps(leftAccumulators + t * 8));
+            right[t] += horizontalSumAVX2(_mm256_load_ps(rightAccumulators + t * 8));
+        }
+    }
+}
+
+#endif // VSYNTH_X86
+
+} // namespace
+
+OscillatorBank::OscillatorBank(int voiceCapacity, int oscillatorsPerVoice)
+    : m_capacity(std::max(1, voiceCapacity))
+    , m_oscillatorsPerVoice(std::max(1, oscillatorsPerVoice))
+    , m_instructionSet(simd::detect())
+{
+    m_stride = (m_capacity + LANE_PADDING - 1) / LANE_PADDING * LANE_PADDING;
+
+    m_phases.resize(m_oscillatorsPerVoice * m_stride, 0.0f);
+    m_increments.resize(m_oscillatorsPerVoice * m_stride, 0.0f);
+    m_leftLevels.resize(m_oscillatorsPerVoice * m_stride, 0.0f);
+    m_rightLevels.resize(m_oscillatorsPerVoice * m_stride, 0.0f);
+    m_noiseStates.resize(m_oscillatorsPerVoice * m_stride, 0.0f);
+
+    switch (m_instructionSet) {
+#ifdef VSYNTH_X86
+        case simd::InstructionSet::AVX2:
+            m_kernel = renderAVX2<false>;
+            m_perVoiceKernel = renderAVX2<true>;
+            break;
+        case simd::InstructionSet::SSE2:
+            m_kernel = renderSSE2<false>;
+            m_perVoiceKernel = renderSSE2<true>;
+            break;
+#endif
+        default:
+            m_kernel = renderScalar<false>;
+            m_perVoiceKernel = renderScalar<true>;
+            break;
+    }
+}
+
+void OscillatorBank::setVoice(int voice, int oscillatorCount, const float* increments, const float* pans)
+{
+    oscillatorCount = std::max(1, std::min(m_oscillatorsPerVoice, oscillatorCount));
+    const float level = 1.0f / static_cast<float>(oscillatorCount);
+
+    for (int osc = 0; osc < m_oscillatorsPerVoice; ++osc) {
+        const int i = index(osc, voice);
+        const bool used = osc < oscillatorCount;
+        float left = 1.0f;
+        float right = 1.0f;
+        if (pans) {
+            panLevels(pans[osc], left, right);
+        }
+        m_phases[i] = 0.0f;
+        m_increments[i] = used ? increments[osc] : 0.0f;
+        m_leftLevels[i] = used ? level * left : 0.0f;
+        m_rightLevels[i] = used ? level * right : 0.0f;
+        m_noiseStates[i] = 0.0f;
+    }
+}
+
+void OscillatorBank::panLevels(float pan, float& left, float& right)
+{
+    // sqrt(2) * (cos, sin) of a quarter turn across the field
+    const float angle = (std::max(-1.0f, std::min(1.0f, pan)) + 1.0f) * 0.25f * PI_F;
+    left = std::sqrt(2.0f) * std::cos(angle);
+    right = std::sqrt(2.0f) * std::sin(angle);
+}
+
+void OscillatorBank::copyVoice(int from, int to)
+{
+    for (int osc = 0; osc < m_oscillatorsPerVoice; ++osc) {
+        m_phases[index(osc, to)] = m_phases[index(osc, from)];
+        m_increments[index(osc, to)] = m_increments[index(osc, from)];
+        m_leftLevels[index(osc, to)] = m_leftLevels[index(osc, from)];
+        m_rightLevels[index(osc, to)] = m_rightLevels[index(osc, from)];
+        m_noiseStates[index(osc, to)] = m_noiseStates[index(osc, from)];
+    }
+}
+
+void OscillatorBank::scaleIncrements(float ratio)
+{
+    for (float& increment : m_increments) {
+        increment *= ratio;
+    }
+}
+
+void OscillatorBank::render(WaveformType waveform, int begin, int end, int oscillatorCount,
+                            const float* frequencyScale, const float* gains, float* left, float* right,
+                            int frames)
+{
+    if (begin >= end || frames <= 0) {
+        return;
+    }
+    oscillatorCount = std::max(1, std::min(m_oscillatorsPerVoice, oscillatorCount));
+
+    // Noise has per-oscillator filter state driven by a shared generator
+    Kernel kernel = (waveform == WaveformType::NOISE) ? renderScalar<false> : m_kernel;
+
+    for (int offset = 0; offset < frames; offset += MAX_FRAMES) {
+        const int count = std::min(MAX_FRAMES, frames - offset);
+        kernel(*this, waveform, begin, end, oscillatorCount, frequencyScale + offset,
+               gains + offset * m_stride, left + offset, right + offset, count);
+    }
+}
+
+void OscillatorBank::renderPerVoice(WaveformType waveform, int begin, int end, int oscillatorCount,
+                                    const float* frequencyScale, float* leftLanes, float* rightLanes,
+                                    int frames)
+{
+    if (begin >= end || frames <= 0) {
+        return;
+    }
+    oscillatorCount = std::max(1, std::min(m_oscillatorsPerVoice, oscillatorCount));
+
+    Kernel kernel = (waveform == WaveformType::NOISE) ? renderScalar<true> : m_perVoiceKernel;
+    kernel(*this, waveform, begin, end, oscillatorCount, frequencyScale, nullptr,
+           leftLanes, rightLanes, std::min(MAX_FRAMES, frames));
+}
+
+template <bool PerVoice>
+void OscillatorBank::renderScalar(OscillatorBank& bank, WaveformType waveform, int begin, int end,
+                                  int oscillatorCount, const float* frequencyScale,
+                                  const float* gains, float* left, float* right, int frames)
+{
+    float wave[MAX_FRAMES];
+    const int stride = bank.m_stride;
+
+    for (int voice = begin; voice < end; ++voice) {
+        if constexpr (PerVoice) {
+            // Padding lanes after the last voice read as silence too
+            if (voice == end - 1) {
+                const int groupEnd = (end + LANE_PADDING - 1) / LANE_PADDING * LANE_PADDING;
+                for (int t = 0; t < frames; ++t) {
+                    std::fill(left + t * stride + voice, left + t * stride + groupEnd, 0.0f);
+                    std::fill(right + t * stride + voice, right + t * stride + groupEnd, 0.0f);
+                }
+            } else {
+                for (int t = 0; t < frames; ++t) {
+                    left[t * stride + voice] = 0.0f;
+                    right[t * stride + voice] = 0.0f;
+                }
+            }
+        }
+        for (int osc = 0; osc < oscillatorCount; ++osc) {
+            const int i = bank.index(osc, voice);
+            const float leftLevel = bank.m_leftLevels[i];
+            const float rightLevel = bank.m_rightLevels[i];
+            if (leftLevel == 0.0f && rightLevel == 0.0f) {
+                continue;
+            }
+
+            Oscillator::renderWaveform(waveform, wave, frames, bank.m_phases[i],
+                                       bank.m_increments[i], frequencyScale,
+                                       bank.m_noiseStates[i]);
+            for (int t = 0; t < frames; ++t) {
+                if constexpr (PerVoice) {
+                    left[t * stride + voice] += wave[t] * leftLevel;
+                    right[t * stride + voice] += wave[t] * rightLevel;
+                } else {
+                    const float sample = wave[t] * gains[t * stride + voice];
+                    left[t] += sample * leftLevel;
+                    right[t] += sample * rightLevel;
+                }
+            }
+        }
+    }
+}
+
+#ifdef VSYNTH_X86
+
+template <bool PerVoice>
+void OscillatorBank::renderSSE2(OscillatorBank& bank, WaveformType waveform, int begin, int end,
+                                int oscillatorCount, const float* frequencyScale,
+                                const float* gains, float* left, float* right, int frames)
+{
+    float* phases = bank.m_phases.data();
+    const float* increments = bank.m_increments.data();
+    const float* leftLevels = bank.m_leftLevels.data();
+    const float* rightLevels = bank.m_rightLevels.data();
+    const int stride = bank.m_stride;
+
+    switch (waveform) {
+        case WaveformType::SINE:
+            renderLanesSSE2<WaveformType::SINE, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                          stride, begin, end, oscillatorCount, frequencyScale,
+                                                          gains, left, right, frames);
+            break;
+        case WaveformType::SQUARE:
+            renderLanesSSE2<WaveformType::SQUARE, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                            stride, begin, end, oscillatorCount, frequencyScale,
+                                                            gains, left, right, frames);
+            break;
+        case WaveformType::SAWTOOTH:
+            renderLanesSSE2<WaveformType::SAWTOOTH, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                              stride, begin, end, oscillatorCount, frequencyScale,
+                                                              gains, left, right, frames);
+            break;
+        case WaveformType::TRIANGLE:
+            renderLanesSSE2<WaveformType::TRIANGLE, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                              stride, begin, end, oscillatorCount, frequencyScale,
+                                                              gains, left, right, frames);
+            break;
+        default:
+            renderScalar<PerVoice>(bank, waveform, begin, end, oscillatorCount, frequencyScale,
+                                   gains, left, right, frames);
+            break;
+    }
+}
+
+template <bool PerVoice>
+void OscillatorBank::renderAVX2(OscillatorBank& bank, WaveformType waveform, int begin, int end,
+                                int oscillatorCount, const float* frequencyScale,
+                                const float* gains, float* left, float* right, int frames)
+{
+    float* phases = bank.m_phases.data();
+    const float* increments = bank.m_increments.data();
+    const float* leftLevels = bank.m_leftLevels.data();
+    const float* rightLevels = bank.m_rightLevels.data();
+    const int stride = bank.m_stride;
+
+    switch (waveform) {
+        case WaveformType::SINE:
+            renderLanesAVX2<WaveformType::SINE, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                          stride, begin, end, oscillatorCount, frequencyScale,
+                                                          gains, left, right, frames);
+            break;
+        case WaveformType::SQUARE:
+            renderLanesAVX2<WaveformType::SQUARE, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                            stride, begin, end, oscillatorCount, frequencyScale,
+                                                            gains, left, right, frames);
+            break;
+        case WaveformType::SAWTOOTH:
+            renderLanesAVX2<WaveformType::SAWTOOTH, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                              stride, begin, end, oscillatorCount, frequencyScale,
+                                                              gains, left, right, frames);
+            break;
+        case WaveformType::TRIANGLE:
+            renderLanesAVX2<WaveformType::TRIANGLE, PerVoice>(phases, increments, leftLevels, rightLevels,
+                                                              stride, begin, end, oscillatorCount, frequencyScale,
+                                                              gains, left, right, frames);
+            break;
+        case WaveformType::BANDLIMITED_SQUARE:
+        case WaveformType::BANDLIMITED_SAWTOOTH:
+        case WaveformType::BANDLIMITED_TRIANGLE:
+            renderWavetableAVX2<PerVoice>(*Wavetable::forWaveform(waveform), phases, increments,
+                                          leftLevels, rightLevels, stride, begin, end, oscillatorCount,
+                                          frequencyScale, gains, left, right, frames);
+            break;
+        default:
+            renderScalar<PerVoice>(bank, waveform, begin, end, oscillatorCount, frequencyScale,
+                                   gains, left, right, frames);
+            break;
+    }
+}
+
+#endif // VSYNTH_X86
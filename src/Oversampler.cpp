@@ -0,0 +1,239 @@
+#include "vsynth/Oversampler.h"
+#include "vsynth/DspMath.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#ifdef VSYNTH_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Half-band coefficient pairs per stage for each quality. The first stage
+// (next to the base rate) needs the sharpest transition; later stages only
+// have to reject images far above the audio band, so they are much shorter.
+constexpr int STAGE_HALF_LENGTHS[3][Oversampler::MAX_STAGES] = {
+    {8, 4, 3},      // FAST
+    {16, 6, 4},     // BALANCED
+    {32, 8, 5}      // HIGH
+};
+// Kaiser window beta for each quality (stopband about 60/80/100 dB)
+constexpr double KAISER_BETAS[3] = {6.0, 8.0, 10.0};
+
+} // namespace
+
+Oversampler::Oversampler(int maxFrames)
+    : m_maxFrames(std::max(1, maxFrames))
+    , m_factor(1)
+    , m_stageCount(0)
+    , m_quality(OversamplingQuality::BALANCED)
+    , m_instructionSet(simd::detect())
+{
+    switch (m_instructionSet) {
+#ifdef VSYNTH_X86
+        case simd::InstructionSet::AVX2:
+            m_kernel = firAVX2;
+            break;
+#endif
+        default:
+            m_kernel = firScalar;
+            break;
+    }
+
+    // The last stage of a cascade sees at most MAX_FACTOR / 2 * maxFrames
+    // low-rate samples per block
+    const int stageFrames = MAX_FACTOR / 2 * m_maxFrames;
+    for (int k = 0; k < MAX_STAGES; ++k) {
+        for (Stage* stage : {&m_upStages[k], &m_downStages[k]}) {
+            stage->halfLength = 1;
+            stage->coefficients.assign(MAX_HALF_LENGTH, 0.0f);
+            stage->history.assign(2 * MAX_HALF_LENGTH - 1 + stageFrames, 0.0f);
+            stage->delay.assign(MAX_HALF_LENGTH + stageFrames, 0.0f);
+        }
+    }
+
+    m_upsampled.assign(MAX_FACTOR * m_maxFrames, 0.0f);
+    m_decimated.assign(MAX_FACTOR * m_maxFrames, 0.0f);
+    m_firOutput.assign(stageFrames, 0.0f);
+}
+
+void Oversampler::configure(int factor, OversamplingQuality quality)
+{
+    m_stageCount = 0;
+    while (m_stageCount < MAX_STAGES && (2 << m_stageCount) <= factor) {
+        ++m_stageCount;
+    }
+    m_factor = 1 << m_stageCount;
+    m_quality = quality;
+
+    const int preset = static_cast<int>(quality);
+    for (int k = 0; k < m_stageCount; ++k) {
+        // Interpolation makes up for the zeros stuffed between input samples
+        designStage(m_upStages[k], STAGE_HALF_LENGTHS[preset][k], KAISER_BETAS[preset], 2.0f);
+        designStage(m_downStages[k], STAGE_HALF_LENGTHS[preset][k], KAISER_BETAS[preset], 1.0f);
+    }
+
+    reset();
+}
+
+void Oversampler::reset()
+{
+    for (int k = 0; k < MAX_STAGES; ++k) {
+        for (Stage* stage : {&m_upStages[k], &m_downStages[k]}) {
+            std::fill(stage->history.begin(), stage->history.end(), 0.0f);
+            std::fill(stage->delay.begin(), stage->delay.end(), 0.0f);
+        }
+    }
+}
+
+float Oversampler::latency() const
+{
+    // Each half-band delays by 2 * halfLength - 1 samples at its high rate,
+    // once on the way up and once on the way down
+    float frames = 0.0f;
+    for (int k = 0; k < m_stageCount; ++k) {
+        const float delay = static_cast<float>(2 * m_upStages[k].halfLength - 1)
+                          + static_cast<float>(2 * m_downStages[k].halfLength - 1);
+        frames += delay / static_cast<float>(2 << k);
+    }
+    return frames;
+}
+
+void Oversampler::designStage(Stage& stage, int halfLength, float beta, float gain)
+{
+    // Windowed sinc with cutoff at a quarter of the high rate: the centre tap
+    // is 1/2 and the even offsets are zero, so only the odd offsets
+    // +-1, +-3 ... +-(2 * halfLength - 1) are stored
+    stage.halfLength = std::max(1, std::min(MAX_HALF_LENGTH, halfLength));
+    const int P = stage.halfLength;
+    const double span = static_cast<double>(2 * P);
+    const double windowNorm = dsp::besselI0(beta);
+
+    double sum = 0.0;
+    double odd[MAX_HALF_LENGTH];
+    for (int j = 0; j < P; ++j) {
+        const double offset = static_cast<double>(2 * j + 1);
+        const double x = offset / span;
+        const double window = dsp::besselI0(beta * std::sqrt(std::max(0.0, 1.0 - x * x))) / windowNorm;
+        const double sign = (j % 2 == 0) ? 1.0 : -1.0;
+        odd[j] = sign / (M_PI * offset) * window;
+        sum += odd[j];
+    }
+
+    // Unity gain at DC: the centre tap plus both wings sum to one
+    const double normalize = 0.25 / sum;
+    // The FIR branch reads its oldest sample first, so offset 2j + 1 sits at
+    // positions P - 1 - j and P + j of the folded kernel
+    for (int j = 0; j < P; ++j) {
+        stage.coefficients[P - 1 - j] = static_cast<float>(odd[j] * normalize * gain);
+    }
+}
+
+float* Oversampler::upsample(const float* in, int frames)
+{
+    if (m_factor == 1) {
+        std::memcpy(m_upsampled.data(), in, frames * sizeof(float));
+        return m_upsampled.data();
+    }
+
+    const float* source = in;
+    for (int k = 0; k < m_stageCount; ++k) {
+        upsampleStage(m_upStages[k], source, m_upsampled.data(), frames << k);
+        source = m_upsampled.data();
+    }
+    return m_upsampled.data();
+}
+
+void Oversampler::downsample(const float* in, float* out, int frames)
+{
+    if (m_factor == 1) {
+        if (in != out) {
+            std::memmove(out, in, frames * sizeof(float));
+        }
+        return;
+    }
+
+    const float* source = in;
+    for (int k = m_stageCount - 1; k >= 0; --k) {
+        float* destination = (k == 0) ? out : m_decimated.data();
+        downsampleStage(m_downStages[k], source, destination, frames << k);
+        source = destination;
+    }
+}
+
+void Oversampler::upsampleStage(Stage& stage, const float* in, float* out, int frames)
+{
+    const int P = stage.halfLength;
+    const int historyLength = 2 * P - 1;
+    float* history = stage.history.data();
+
+    std::memcpy(history + historyLength, in, frames * sizeof(float));
+    m_kernel(history, stage.coefficients.data(), P, m_firOutput.data(), frames);
+
+    // Even outputs come from the FIR branch, odd ones are the input delayed
+    // to the FIR's centre
+    const float* fir = m_firOutput.data();
+    for (int m = 0; m < frames; ++m) {
+        out[2 * m] = fir[m];
+        out[2 * m + 1] = history[P + m];
+    }
+
+    std::memmove(history, history + frames, historyLength * sizeof(float));
+}
+
+void Oversampler::downsampleStage(Stage& stage, const float* in, float* out, int frames)
+{
+    const int P = stage.halfLength;
+    const int historyLength = 2 * P - 1;
+    float* history = stage.history.data();
+    float* delay = stage.delay.data();
+
+    // Split into the even phase (FIR branch) and odd phase (centre tap)
+    for (int m = 0; m < frames; ++m) {
+        history[historyLength + m] = in[2 * m];
+        delay[P + m] = in[2 * m + 1];
+    }
+
+    m_kernel(history, stage.coefficients.data(), P, out, frames);
+    for (int m = 0; m < frames; ++m) {
+        out[m] += 0.5f * delay[m];
+    }
+
+    std::memmove(history, history + frames, historyLength * sizeof(float));
+    std::memmove(delay, delay + frames, P * sizeof(float));
+}
+
+void Oversampler::firScalar(const float* in, const float* coefficients, int halfLength,
+                            float* out, int count)
+{
+    const int last = 2 * halfLength - 1;
+    for (int i = 0; i < count; ++i) {
+        float sum = 0.0f;
+        for (int t = 0; t < halfLength; ++t) {
+            sum += coefficients[t] * (in[i + t] + in[i + last - t]);
+        }
+        out[i] = sum;
+    }
+}
+
+#ifdef VSYNTH_X86
+VSYNTH_TARGET_AVX2 void Oversampler::firAVX2(const float* in, const float* coefficients, int halfLength,
+                                             float* out, int count)
+{
+    // Eight outputs per iteration; the symmetric taps are folded so each
+    // coefficient costs one add and one FMA
+    const int last = 2 * halfLength - 1;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int t = 0; t < halfLength; ++t) {
+            const __m256 pair = _mm256_add_ps(_mm256_loadu_ps(in + i + t),
+                                              _mm256_loadu_ps(in + i + last - t));
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(coefficients[t]), pair, sum);
+        }
+        _mm256_storeu_ps(out + i, sum);
+    }
+    firScalar(in + i, coefficients, halfLength, out + i, count - i);
+}
+#endif
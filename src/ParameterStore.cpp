@@ -0,0 +1,134 @@
+#include "vsynth/ParameterStore.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+// A one-pole ramp snaps to its target once this close (relative to it)
+constexpr float SETTLE_THRESHOLD = 1.0e-5f;
+}
+
+SmoothedParameter::SmoothedParameter()
+    : m_type(RampType::NONE)
+    , m_value(0.0f)
+    , m_target(0.0f)
+    , m_rampFrames(1)
+    , m_step(0.0f)
+    , m_remaining(0)
+    , m_pole(0.0f)
+    , m_blockPole(0.0f)
+    , m_blockFrames(1)
+{
+}
+
+void SmoothedParameter::configure(RampType type, float time, int sampleRate, int blockFrames)
+{
+    m_type = type;
+    m_blockFrames = std::max(1, blockFrames);
+    
+    const double frames = std::max(1.0, static_cast<double>(time) * sampleRate);
+    m_rampFrames = static_cast<int>(frames);
+    m_pole = static_cast<float>(std::exp(-1.0 / frames));
+    m_blockPole = static_cast<float>(std::exp(-m_blockFrames / frames));
+    
+    setImmediate(m_target);
+}
+
+void SmoothedParameter::setTarget(float target)
+{
+    m_target = target;
+    if (m_type == RampType::NONE) {
+        m_value = target;
+    } else if (m_type == RampType::LINEAR) {
+        // A new target restarts the full ramp from wherever the value is
+        m_remaining = m_rampFrames;
+        m_step = (m_target - m_value) / static_cast<float>(m_rampFrames);
+    }
+}
+
+void SmoothedParameter::setImmediate(float value)
+{
+    m_value = value;
+    m_target = value;
+    m_remaining = 0;
+}
+
+bool SmoothedParameter::advance(int frames)
+{
+    if (m_value == m_target) {
+        return false;
+    }
+    
+    if (m_type == RampType::LINEAR) {
+        m_remaining -= frames;
+        m_value = (m_remaining > 0) ? m_target - m_step * static_cast<float>(m_remaining) : m_target;
+    } else {
+        const float pole = (frames == m_blockFrames) ? m_blockPole
+                                                     : std::pow(m_pole, static_cast<float>(frames));
+        m_value = m_target + (m_value - m_target) * pole;
+        if (std::fabs(m_value - m_target) <= SETTLE_THRESHOLD * std::max(1.0f, std::fabs(m_target))) {
+            m_value = m_target;
+        }
+    }
+    return true;
+}
+
+ParameterStore::ParameterStore(int sampleRate)
+    : m_sampleRate(sampleRate)
+    , m_smoothing(0)
+    , m_changed(0)
+{
+}
+
+void ParameterStore::configure(ParameterId id, RampType type, float time, float value)
+{
+    SmoothedParameter& parameter = m_parameters[index(id)];
+    parameter.configure(type, time, m_sampleRate, SUB_BLOCK_SIZE);
+    parameter.setImmediate(value);
+    m_smoothing &= ~bit(id);
+    m_changed |= bit(id);
+}
+
+void ParameterStore::set(ParameterId id, float value)
+{
+    SmoothedParameter& parameter = m_parameters[index(id)];
+    if (value == parameter.target()) {
+        return;
+    }
+    parameter.setTarget(value);
+    m_changed |= bit(id);
+    if (parameter.isSmoothing()) {
+        m_smoothing |= bit(id);
+    }
+}
+
+void ParameterStore::settle()
+{
+    for (int i = 0; i < COUNT; ++i) {
+        if (m_smoothing & (1u << i)) {
+            m_parameters[i].setImmediate(m_parameters[i].target());
+        }
+    }
+    m_changed |= m_smoothing;
+    m_smoothing = 0;
+}
+
+uint32_t ParameterStore::advance(int frames)
+{
+    uint32_t moving = m_smoothing;
+    while (moving != 0) {
+        const int i = std::countr_zero(moving);
+        moving &= moving - 1;
+        
+        if (m_parameters[i].advance(frames)) {
+            m_changed |= 1u << i;
+        }
+        if (!m_parameters[i].isSmoothing()) {
+            m_smoothing &= ~(1u << i);
+        }
+    }
+    
+    const uint32_t changed = m_changed;
+    m_changed = 0;
+    return changed;
+}
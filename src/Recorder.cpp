@@ -1,13 +1,17 @@
 #include "vsynth/Recorder.h"
 #include <iostream>
 #include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
 
-Recorder::Recorder(int sampleRate)
+Recorder::Recorder(int sampleRate, int channels)
     : m_sampleRate(sampleRate)
+    , m_channels(std::max(1, channels))
     , m_isRecording(false)
     , m_isPlaying(false)
-    , m_recordingTime(0.0f)
-    , m_playbackTime(0.0f)
+    , m_recordedFrames(0)
+    , m_playbackPosition(0)
     , m_playbackIndex(0)
 {
 }
@@ -15,7 +19,7 @@ Recorder::Recorder(int sampleRate)
 void Recorder::startRecording()
 {
     m_isRecording = true;
-    m_recordingTime = 0.0f;
+    m_recordedFrames = 0;
     m_noteEvents.clear();
     m_audioBuffer.clear();
 }
@@ -29,88 +33,101 @@ void Recorder::startPlayback()
 {
     if (!m_noteEvents.empty()) {
         m_isPlaying = true;
-        m_playbackTime = 0.0f;
+        m_playbackPosition = 0;
         m_playbackIndex = 0;
-        m_eventsToPlay.clear();
     }
 }
 
 void Recorder::stopPlayback()
 {
     m_isPlaying = false;
-    m_eventsToPlay.clear();
 }
 
 void Recorder::recordNoteEvent(int note, float velocity, bool isNoteOn)
 {
     if (m_isRecording) {
-        m_noteEvents.emplace_back(m_recordingTime, note, velocity, isNoteOn);
+        m_noteEvents.emplace_back(m_recordedFrames, note, velocity, isNoteOn);
     }
 }
 
-void Recorder::recordAudioSample(float sample)
+void Recorder::recordAudio(const float* const* planes, int frames)
 {
-    if (m_isRecording) {
-        m_audioBuffer.push_back(sample);
-        m_recordingTime += 1.0f / static_cast<float>(m_sampleRate);
+    if (!m_isRecording) {
+        return;
+    }
+    
+    const size_t start = m_audioBuffer.size();
+    m_audioBuffer.resize(start + static_cast<size_t>(frames) * m_channels);
+    float* out = m_audioBuffer.data() + start;
+    for (int c = 0; c < m_channels; ++c) {
+        const float* in = planes[c];
+        for (int i = 0; i < frames; ++i) {
+            out[i * m_channels + c] = in[i];
+        }
     }
+    m_recordedFrames += frames;
 }
 
-void Recorder::processPlayback(float deltaTime)
+const NoteEvent* Recorder::nextDueEvent()
 {
-    if (!m_isPlaying) return;
-    
-    m_playbackTime += deltaTime;
+    if (!m_isPlaying || m_playbackIndex >= m_noteEvents.size()) {
+        return nullptr;
+    }
     
-    // Find events that should be played at this time
-    m_eventsToPlay.clear();
+    const NoteEvent& event = m_noteEvents[m_playbackIndex];
+    if (event.samplePosition > m_playbackPosition) {
+        return nullptr;
+    }
     
-    while (m_playbackIndex < m_noteEvents.size()) {
-        const auto& event = m_noteEvents[m_playbackIndex];
-        
-        if (event.timestamp <= m_playbackTime) {
-            m_eventsToPlay.push_back(event);
-            m_playbackIndex++;
-        } else {
-            break;
-        }
+    ++m_playbackIndex;
+    return &event;
+}
+
+int64_t Recorder::framesUntilNextEvent() const
+{
+    if (!m_isPlaying || m_playbackIndex >= m_noteEvents.size()) {
+        return -1;
     }
     
+    const uint64_t position = m_noteEvents[m_playbackIndex].samplePosition;
+    return position > m_playbackPosition ? static_cast<int64_t>(position - m_playbackPosition) : 0;
+}
+
+void Recorder::advancePlayback(unsigned long frames)
+{
+    if (!m_isPlaying) return;
+    
+    m_playbackPosition += frames;
+    
     // Check if playback is finished
     if (m_playbackIndex >= m_noteEvents.size()) {
         // Allow some time for release phases
-        if (m_playbackTime > m_recordingTime + 2.0f) {
+        if (m_playbackPosition > m_recordedFrames + 2 * static_cast<uint64_t>(m_sampleRate)) {
             stopPlayback();
         }
     }
 }
 
-std::vector<NoteEvent> Recorder::getEventsToPlay()
-{
-    return m_eventsToPlay;
-}
-
 void Recorder::clear()
 {
     m_noteEvents.clear();
     m_audioBuffer.clear();
-    m_recordingTime = 0.0f;
-    m_playbackTime = 0.0f;
+    m_recordedFrames = 0;
+    m_playbackPosition = 0;
     m_playbackIndex = 0;
-    m_eventsToPlay.clear();
 }
 
-void Recorder::exportToWAV(const std::string& filename)
+bool Recorder::exportToWAV(const std::string& filename)
 {
     if (m_audioBuffer.empty()) {
         std::cerr << "No audio data to export" << std::endl;
-        return;
+        return false;
     }
     
     std::ofstream file(filename, std::ios::binary);
     if (!file) {
         std::cerr << "Could not open file for writing: " << filename << std::endl;
-        return;
+        return false;
     }
     
     // Convert float samples to 16-bit PCM
@@ -132,26 +149,30 @@ void Recorder::exportToWAV(const std::string& filename)
     
     file.close();
     std::cout << "Exported audio to: " << filename << std::endl;
+    return true;
 }
 
-void Recorder::exportToMIDI(const std::string& filename)
+bool Recorder::exportToMIDI(const std::string& filename)
 {
-    writeMIDIFile(filename);
+    return writeMIDIFile(filename);
 }
 
-void Recorder::exportNoteEvents(const std::string& filename)
+bool Recorder::exportNoteEvents(const std::string& filename)
 {
     std::ofstream file(filename);
     if (!file) {
         std::cerr << "Could not open file for writing: " << filename << std::endl;
-        return;
+        return false;
     }
     
     file << "# VSynth Note Events Export\n";
     file << "# Format: timestamp note velocity on/off\n";
     
+    // Microsecond timestamps are finer than a sample, so positions survive a round trip
+    file << std::fixed << std::setprecision(6);
     for (const auto& event : m_noteEvents) {
-        file << event.timestamp << " " 
+        const double timestamp = static_cast<double>(event.samplePosition) / m_sampleRate;
+        file << timestamp << " " 
              << event.note << " " 
              << event.velocity << " " 
              << (event.isNoteOn ? "on" : "off") << "\n";
@@ -159,6 +180,47 @@ void Recorder::exportNoteEvents(const std::string& filename)
     
     file.close();
     std::cout << "Exported note events to: " << filename << std::endl;
+    return true;
+}
+
+bool Recorder::importNoteEvents(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Could not open file for reading: " << filename << std::endl;
+        return false;
+    }
+    
+    std::vector<NoteEvent> events;
+    std::string line;
+    int lineNumber = 0;
+    
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') continue;
+        
+        std::istringstream fields(line);
+        double timestamp;
+        int note;
+        float velocity;
+        std::string state;
+        if (!(fields >> timestamp >> note >> velocity >> state) || (state != "on" && state != "off")) {
+            std::cerr << "Invalid note event at " << filename << ":" << lineNumber << std::endl;
+            return false;
+        }
+        const uint64_t position = static_cast<uint64_t>(std::llround(std::max(0.0, timestamp) * m_sampleRate));
+        events.emplace_back(position, note, velocity, state == "on");
+    }
+    
+    // Keep file order for events sharing a position
+    std::stable_sort(events.begin(), events.end(), [](const NoteEvent& a, const NoteEvent& b) {
+        return a.samplePosition < b.samplePosition;
+    });
+    
+    m_noteEvents = std::move(events);
+    m_recordedFrames = m_noteEvents.empty() ? 0 : m_noteEvents.back().samplePosition;
+    m_playbackIndex = 0;
+    return true;
 }
 
 void Recorder::writeWAVHeader(std::ofstream& file, int dataSize)
@@ -171,16 +233,18 @@ void Recorder::writeWAVHeader(std::ofstream& file, int dataSize)
         char fmt[4] = {'f', 'm', 't', ' '};
         uint32_t fmtSize = 16;
         uint16_t audioFormat = 1; // PCM
-        uint16_t numChannels = 1; // Mono
+        uint16_t numChannels;
         uint32_t sampleRate;
         uint32_t byteRate;
-        uint16_t blockAlign = 2; // 16-bit mono
+        uint16_t blockAlign;
         uint16_t bitsPerSample = 16;
         char data[4] = {'d', 'a', 't', 'a'};
         uint32_t dataSize;
     };
     
     WAVHeader header;
+    header.numChannels = static_cast<uint16_t>(m_channels);
+    header.blockAlign = static_cast<uint16_t>(m_channels * sizeof(int16_t));
     header.sampleRate = static_cast<uint32_t>(m_sampleRate);
     header.byteRate = header.sampleRate * header.blockAlign;
     header.dataSize = static_cast<uint32_t>(dataSize);
@@ -189,12 +253,12 @@ void Recorder::writeWAVHeader(std::ofstream& file, int dataSize)
     file.write(reinterpret_cast<const char*>(&header), sizeof(header));
 }
 
-void Recorder::writeMIDIFile(const std::string& filename)
+bool Recorder::writeMIDIFile(const std::string& filename)
 {
     std::ofstream file(filename, std::ios::binary);
     if (!file) {
         std::cerr << "Could not open MIDI file for writing: " << filename << std::endl;
-        return;
+        return false;
     }
     
     // Simple MIDI file format (Type 0, single track)
@@ -225,9 +289,10 @@ void Recorder::writeMIDIFile(const std::string& filename)
     std::vector<uint8_t> trackData;
     
     // Add note events (simplified conversion)
-    float lastTime = 0.0f;
+    uint64_t lastPosition = 0;
     for (const auto& event : m_noteEvents) {
-        uint32_t deltaTime = static_cast<uint32_t>((event.timestamp - lastTime) * 480.0f);
+        uint32_t deltaTime = static_cast<uint32_t>(
+            static_cast<double>(event.samplePosition - lastPosition) / m_sampleRate * 480.0);
         
         // Write variable length quantity for delta time
         if (deltaTime < 128) {
@@ -247,7 +312,7 @@ void Recorder::writeMIDIFile(const std::string& filename)
         trackData.push_back(static_cast<uint8_t>(event.note));
         trackData.push_back(static_cast<uint8_t>(event.velocity * 127.0f));
         
-        lastTime = event.timestamp;
+        lastPosition = event.samplePosition;
     }
     
     // End of track
@@ -263,4 +328,5 @@ void Recorder::writeMIDIFile(const std::string& filename)
     
     file.close();
     std::cout << "Exported MIDI to: " << filename << std::endl;
+    return true;
 }
@@ -0,0 +1,139 @@
+#include "vsynth/RenderThreadPool.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define VSYNTH_CPU_RELAX() _mm_pause()
+#else
+#define VSYNTH_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace {
+
+// Spin iterations before a worker blocks; covers the gap between two
+// consecutive audio callbacks' dispatches without a syscall
+const int SPIN_ITERATIONS = 20000;
+
+} // namespace
+
+RenderThreadPool::RenderThreadPool(int threadCount)
+    : m_function(nullptr)
+    , m_context(nullptr)
+    , m_currentGeneration(0)
+    , m_generation(0)
+    , m_claimCounter(0)
+    , m_finishedJobs(0)
+    , m_running(true)
+{
+    for (int i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&RenderThreadPool::workerLoop, this, i);
+        configureWorkerThread(m_threads.back(), i);
+    }
+}
+
+RenderThreadPool::~RenderThreadPool()
+{
+    m_running.store(false, std::memory_order_release);
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_generation.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void RenderThreadPool::run(int jobCount, JobFunction function, void* context)
+{
+    if (jobCount <= 0) {
+        return;
+    }
+
+    // Generation is kept to 24 bits to fit the packed counter
+    m_currentGeneration = (m_currentGeneration + 1) & 0xFFFFFF;
+    m_function = function;
+    m_context = context;
+    m_finishedJobs.store(0, std::memory_order_relaxed);
+    m_claimCounter.store(pack(m_currentGeneration, static_cast<uint32_t>(jobCount), 0),
+                         std::memory_order_release);
+
+    if (!m_threads.empty()) {
+        m_generation.store(m_currentGeneration, std::memory_order_release);
+        m_generation.notify_all();
+    }
+
+    // The caller takes jobs too, so nothing waits on a worker that hasn't woken up
+    executeJobs(m_currentGeneration);
+
+    while (m_finishedJobs.load(std::memory_order_acquire) < jobCount) {
+        VSYNTH_CPU_RELAX();
+    }
+}
+
+void RenderThreadPool::executeJobs(uint32_t generation)
+{
+    uint64_t counter = m_claimCounter.load(std::memory_order_acquire);
+    while (generationOf(counter) == generation && nextJobOf(counter) < jobCountOf(counter)) {
+        if (m_claimCounter.compare_exchange_weak(counter, counter + 1, std::memory_order_acq_rel)) {
+            // A successful claim guarantees the job parameters belong to this generation
+            m_function(m_context, static_cast<int>(nextJobOf(counter)));
+            m_finishedJobs.fetch_add(1, std::memory_order_release);
+            counter = m_claimCounter.load(std::memory_order_acquire);
+        }
+    }
+}
+
+void RenderThreadPool::workerLoop(int index)
+{
+    (void)index;
+    uint32_t seen = m_generation.load(std::memory_order_acquire);
+
+    while (true) {
+        // Spin briefly, then block until the next dispatch
+        int spins = 0;
+        uint32_t generation = m_generation.load(std::memory_order_acquire);
+        while (generation == seen && spins < SPIN_ITERATIONS) {
+            VSYNTH_CPU_RELAX();
+            generation = m_generation.load(std::memory_order_acquire);
+            ++spins;
+        }
+        if (generation == seen) {
+            m_generation.wait(seen, std::memory_order_acquire);
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+
+        if (!m_running.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        seen = generation;
+        executeJobs(generation);
+    }
+}
+
+void RenderThreadPool::configureWorkerThread(std::thread& thread, int index)
+{
+#if defined(__linux__)
+    // One core per worker so its caches stay warm between blocks. The audio
+    // callback thread is not pinned: the pool is capped below the core count,
+    // so the scheduler always has a core without a worker to run it on.
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores > 1) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % cores, &cpus);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+    }
+
+    // Real-time priority needs privileges (rtprio limit); stay at normal priority otherwise
+    sched_param param{};
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+    pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+#else
+    (void)thread;
+    (void)index;
+#endif
+}
@@ -0,0 +1,68 @@
+#include "vsynth/SIMD.h"
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(VSYNTH_X86)
+#include <intrin.h>
+#endif
+
+namespace simd {
+
+static InstructionSet detectHardware()
+{
+#if defined(VSYNTH_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return InstructionSet::AVX2;
+    }
+    return InstructionSet::SSE2;
+#elif defined(VSYNTH_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        if (fma && osxsave && avx2 && (_xgetbv(0) & 0x6) == 0x6) {
+            return InstructionSet::AVX2;
+        }
+    }
+    return InstructionSet::SSE2;
+#else
+    return InstructionSet::SCALAR;
+#endif
+}
+
+InstructionSet detect()
+{
+    static const InstructionSet detected = [] {
+        InstructionSet set = detectHardware();
+
+        // Allow forcing a lower instruction set
+        if (const char* forced = std::getenv("VSYNTH_SIMD")) {
+            if (std::strcmp(forced, "scalar") == 0) {
+                set = InstructionSet::SCALAR;
+            } else if (std::strcmp(forced, "sse2") == 0 && set >= InstructionSet::SSE2) {
+                set = InstructionSet::SSE2;
+            }
+        }
+        return set;
+    }();
+    return detected;
+}
+
+const char* name(InstructionSet set)
+{
+    switch (set) {
+        case InstructionSet::SCALAR:
+            return "scalar";
+        case InstructionSet::SSE2:
+            return "sse2";
+        case InstructionSet::AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+} // namespace simd
@@ -0,0 +1,108 @@
+#include "vsynth/SpectrumAnalysisThread.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Polling period; every hop that arrived in between is analyzed
+const auto ANALYSIS_INTERVAL = std::chrono::milliseconds(16);
+// Samples read from the tap at once
+const size_t CHUNK_SIZE = 4096;
+
+} // namespace
+
+SpectrumAnalysisThread::SpectrumAnalysisThread(const SpectrumTap& tap, const SpectrumSettings& settings)
+    : m_tap(tap)
+    , m_settings(settings)
+    , m_analyzer(std::make_unique<FFTAnalyzer>(settings.fftSize))
+    , m_readPosition(0)
+    , m_spectra(std::vector<float>(settings.bands > 0 ? settings.bands : m_analyzer->getFFTSize() / 2 + 1, 0.0f))
+    , m_running(false)
+{
+    m_analyzer->setHopSize(settings.hopSize);
+    m_analyzer->setWindowType(settings.window);
+    m_analyzer->setAveraging(settings.averaging, settings.averagingAmount);
+    m_analyzer->setBandRange(settings.sampleRate);
+    m_settings.fftSize = m_analyzer->getFFTSize();
+    m_settings.hopSize = m_analyzer->getHopSize();
+    m_chunk.resize(CHUNK_SIZE, 0.0f);
+}
+
+SpectrumAnalysisThread::~SpectrumAnalysisThread()
+{
+    stop();
+}
+
+void SpectrumAnalysisThread::start()
+{
+    if (m_thread.joinable()) {
+        return;
+    }
+
+    // Start from the current output rather than replaying the history
+    m_readPosition = m_tap.position();
+    m_analyzer->resetStream();
+
+    m_running.store(true, std::memory_order_relaxed);
+    m_thread = std::thread(&SpectrumAnalysisThread::run, this);
+}
+
+void SpectrumAnalysisThread::stop()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    m_running.store(false, std::memory_order_relaxed);
+    m_thread.join();
+}
+
+bool SpectrumAnalysisThread::getLatestSpectrum(std::vector<float>& spectrum)
+{
+    if (!m_spectra.update()) {
+        return false;
+    }
+
+    spectrum = m_spectra.front();
+    return true;
+}
+
+void SpectrumAnalysisThread::run()
+{
+    while (m_running.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(ANALYSIS_INTERVAL);
+        analyzeNewSamples();
+    }
+}
+
+void SpectrumAnalysisThread::analyzeNewSamples()
+{
+    int frames = 0;
+
+    uint64_t end = m_tap.position();
+    while (m_readPosition < end) {
+        // Fell too far behind: skip ahead to the newest frame's worth of samples
+        if (end - m_readPosition > SpectrumTap::CAPACITY / 2) {
+            m_readPosition = end - static_cast<uint64_t>(m_analyzer->getFFTSize());
+            m_analyzer->resetStream();
+        }
+
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(end - m_readPosition, m_chunk.size()));
+        if (!m_tap.read(m_readPosition, m_chunk.data(), count)) {
+            // Overwritten while copying; retry from the newest samples
+            end = m_tap.position();
+            m_readPosition = end;
+            m_analyzer->resetStream();
+            break;
+        }
+
+        frames += m_analyzer->pushSamples(m_chunk.data(), count);
+        m_readPosition += count;
+    }
+
+    if (frames > 0) {
+        m_spectra.back() = m_settings.bands > 0 ? m_analyzer->getBandSpectrum(m_settings.bands)
+                                                : m_analyzer->getMagnitudeSpectrum();
+        m_spectra.publish();
+    }
+}
@@ -0,0 +1,65 @@
+#include "vsynth/SpectrumTap.h"
+
+namespace {
+
+// Attempts before snapshot() gives up on a window the audio thread keeps overwriting
+const int SNAPSHOT_ATTEMPTS = 4;
+
+} // namespace
+
+SpectrumTap::SpectrumTap()
+    : m_reserved(0)
+    , m_published(0)
+{
+    m_ring.resize(CAPACITY, 0.0f);
+}
+
+void SpectrumTap::write(const float* samples, size_t count)
+{
+    const uint64_t position = m_published.load(std::memory_order_relaxed);
+
+    // Announce the overwrite before touching the ring (pairs with read())
+    m_reserved.store(position + count, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < count; ++i) {
+        std::atomic_ref<float>(m_ring[(position + i) & MASK]).store(samples[i], std::memory_order_relaxed);
+    }
+
+    m_published.store(position + count, std::memory_order_release);
+}
+
+bool SpectrumTap::snapshot(float* destination, size_t count, uint64_t* endPosition) const
+{
+    for (int attempt = 0; attempt < SNAPSHOT_ATTEMPTS; ++attempt) {
+        const uint64_t end = position();
+        if (end < count) {
+            return false;
+        }
+
+        if (read(end - count, destination, count)) {
+            if (endPosition) {
+                *endPosition = end;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SpectrumTap::read(uint64_t start, float* destination, size_t count) const
+{
+    if (count > CAPACITY || start + count > position()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        destination[i] = std::atomic_ref<float>(const_cast<float&>(m_ring[(start + i) & MASK]))
+                             .load(std::memory_order_relaxed);
+    }
+
+    // Valid if nothing written (or being written) since reached our window
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_reserved.load(std::memory_order_relaxed) - start <= CAPACITY;
+}
@@ -0,0 +1,250 @@
+#include "vsynth/SpectrumWidget.h"
+#include <QPainter>
+#include <QPen>
+#include <QRegion>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int DEFAULT_HISTORY_LENGTH = 256;
+const int MARGIN = 4;
+
+// Palette stops from silence to full scale (dark blue, purple, red, yellow, white)
+QRgb paletteColor(float level)
+{
+    static const float stops[][3] = {
+        {0.0f, 0.0f, 0.05f},
+        {0.25f, 0.0f, 0.45f},
+        {0.75f, 0.1f, 0.25f},
+        {1.0f, 0.7f, 0.0f},
+        {1.0f, 1.0f, 0.85f}
+    };
+    const int segments = 4;
+
+    const float position = std::max(0.0f, std::min(1.0f, level)) * segments;
+    const int segment = std::min(segments - 1, static_cast<int>(position));
+    const float t = position - segment;
+
+    int rgb[3];
+    for (int c = 0; c < 3; ++c) {
+        const float value = stops[segment][c] + (stops[segment + 1][c] - stops[segment][c]) * t;
+        rgb[c] = static_cast<int>(value * 255.0f + 0.5f);
+    }
+    return qRgb(rgb[0], rgb[1], rgb[2]);
+}
+
+} // namespace
+
+SpectrumWidget::SpectrumWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_viewMode(ViewMode::BOTH)
+    , m_historyLength(DEFAULT_HISTORY_LENGTH)
+    , m_newestRow(0)
+    , m_curveTop(0)
+    , m_backgroundColor(16, 16, 24)
+    , m_gridColor(48, 48, 64)
+    , m_curveColor(120, 220, 255)
+    , m_fillColor(120, 220, 255, 60)
+{
+    for (int i = 0; i < 256; ++i) {
+        m_palette[i] = paletteColor(i / 255.0f);
+    }
+
+    // Everything is painted here; Qt doesn't need to clear the background first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(256, 160);
+    updateLayout();
+}
+
+void SpectrumWidget::setViewMode(ViewMode mode)
+{
+    m_viewMode = mode;
+    updateLayout();
+    update();
+}
+
+void SpectrumWidget::setHistoryLength(int rows)
+{
+    m_historyLength = std::max(1, rows);
+    resetHistory(static_cast<int>(m_current.size()));
+    update();
+}
+
+void SpectrumWidget::clear()
+{
+    std::fill(m_current.begin(), m_current.end(), 0.0f);
+    if (!m_history.isNull()) {
+        m_history.fill(m_palette[0]);
+    }
+    updateCurve();
+    update();
+}
+
+void SpectrumWidget::addSpectrum(const std::vector<float>& spectrum)
+{
+    if (spectrum.empty()) {
+        return;
+    }
+
+    const int columns = static_cast<int>(spectrum.size());
+    if (columns != m_history.width()) {
+        resetHistory(columns);
+    }
+
+    std::copy(spectrum.begin(), spectrum.end(), m_current.begin());
+
+    // New scanline; rows are written upwards so the newest row leads when read downwards
+    m_newestRow = (m_newestRow + m_historyLength - 1) % m_historyLength;
+    QRgb* line = reinterpret_cast<QRgb*>(m_history.scanLine(m_newestRow));
+    for (int x = 0; x < columns; ++x) {
+        const float level = std::max(0.0f, std::min(1.0f, spectrum[x]));
+        line[x] = m_palette[static_cast<int>(level * 255.0f)];
+    }
+
+    // The curve only dirties the part it covers now or covered before
+    if (m_viewMode != ViewMode::WATERFALL) {
+        const int previousTop = m_curveTop;
+        updateCurve();
+        const int top = std::min(previousTop, m_curveTop) - 1;
+        update(QRect(m_curveRect.left(), top, m_curveRect.width(), m_curveRect.bottom() - top + 1));
+    }
+    if (m_viewMode != ViewMode::SPECTRUM) {
+        update(m_waterfallRect);
+    }
+}
+
+void SpectrumWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    const QRect dirty = event->rect();
+
+    if (m_viewMode != ViewMode::WATERFALL && dirty.intersects(m_curveRect.adjusted(-MARGIN, -MARGIN, MARGIN, MARGIN))) {
+        drawCurve(painter);
+    }
+    if (m_viewMode != ViewMode::SPECTRUM && dirty.intersects(m_waterfallRect)) {
+        drawWaterfall(painter);
+    }
+
+    // Margins and the gap between the views
+    QRegion border = QRegion(rect()) - QRegion(m_curveRect) - QRegion(m_waterfallRect);
+    painter.setClipRegion(border.intersected(dirty));
+    painter.fillRect(rect(), m_backgroundColor);
+}
+
+void SpectrumWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updateLayout();
+}
+
+void SpectrumWidget::resetHistory(int columns)
+{
+    columns = std::max(1, columns);
+    m_history = QImage(columns, m_historyLength, QImage::Format_RGB32);
+    m_history.fill(m_palette[0]);
+    m_newestRow = 0;
+
+    m_current.assign(columns, 0.0f);
+    // Room for the two closing points drawCurve() appends
+    m_curve.reserve(columns + 2);
+    m_curve.resize(columns);
+    updateCurve();
+}
+
+void SpectrumWidget::updateLayout()
+{
+    const QRect area = rect().adjusted(MARGIN, MARGIN, -MARGIN, -MARGIN);
+
+    switch (m_viewMode) {
+        case ViewMode::SPECTRUM:
+            m_curveRect = area;
+            m_waterfallRect = QRect();
+            break;
+        case ViewMode::WATERFALL:
+            m_curveRect = QRect();
+            m_waterfallRect = area;
+            break;
+        case ViewMode::BOTH: {
+            const int curveHeight = area.height() * 2 / 5;
+            m_curveRect = QRect(area.left(), area.top(), area.width(), curveHeight);
+            m_waterfallRect = QRect(area.left(), area.top() + curveHeight + MARGIN,
+                                    area.width(), area.height() - curveHeight - MARGIN);
+            break;
+        }
+    }
+
+    updateCurve();
+}
+
+void SpectrumWidget::updateCurve()
+{
+    const int columns = static_cast<int>(m_current.size());
+    m_curveTop = m_curveRect.bottom();
+    if (columns == 0 || m_curveRect.isEmpty()) {
+        return;
+    }
+
+    const double step = columns > 1 ? static_cast<double>(m_curveRect.width() - 1) / (columns - 1) : 0.0;
+    const double height = m_curveRect.height() - 1;
+    for (int i = 0; i < columns; ++i) {
+        const double y = m_curveRect.bottom() - m_current[i] * height;
+        m_curve[i] = QPointF(m_curveRect.left() + i * step, y);
+        m_curveTop = std::min(m_curveTop, static_cast<int>(std::floor(y)));
+    }
+}
+
+void SpectrumWidget::drawCurve(QPainter& painter)
+{
+    painter.fillRect(m_curveRect, m_backgroundColor);
+
+    // Grid every 10 dB of the 60 dB display range
+    painter.setPen(QPen(m_gridColor, 1));
+    for (int i = 1; i < 6; ++i) {
+        const int y = m_curveRect.top() + m_curveRect.height() * i / 6;
+        painter.drawLine(m_curveRect.left(), y, m_curveRect.right(), y);
+    }
+
+    if (m_curve.isEmpty()) {
+        return;
+    }
+
+    painter.save();
+    painter.setClipRect(m_curveRect);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // Fill under the curve: close the polyline along the bottom edge
+    m_curve.append(QPointF(m_curve.last().x(), m_curveRect.bottom()));
+    m_curve.append(QPointF(m_curve.first().x(), m_curveRect.bottom()));
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(m_fillColor);
+    painter.drawPolygon(m_curve);
+    m_curve.resize(m_curve.size() - 2);
+
+    painter.setPen(QPen(m_curveColor, 1.5));
+    painter.drawPolyline(m_curve);
+    painter.restore();
+}
+
+void SpectrumWidget::drawWaterfall(QPainter& painter)
+{
+    if (m_history.isNull()) {
+        painter.fillRect(m_waterfallRect, QColor(m_palette[0]));
+        return;
+    }
+
+    // Newest spectrum at the top: rows [newest, end) then [0, newest)
+    const int rows = m_history.height();
+    const int firstRows = rows - m_newestRow;
+    const int splitY = m_waterfallRect.top() + m_waterfallRect.height() * firstRows / rows;
+
+    const QRect top(m_waterfallRect.left(), m_waterfallRect.top(), m_waterfallRect.width(),
+                    splitY - m_waterfallRect.top());
+    painter.drawImage(top, m_history, QRect(0, m_newestRow, m_history.width(), firstRows));
+
+    if (m_newestRow > 0) {
+        const QRect bottom(m_waterfallRect.left(), splitY, m_waterfallRect.width(),
+                           m_waterfallRect.bottom() + 1 - splitY);
+        painter.drawImage(bottom, m_history, QRect(0, 0, m_history.width(), m_newestRow));
+    }
+}
@@ -0,0 +1,159 @@
+#include "vsynth/StreamingRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// The writer wakes this often; the ring holds seconds, so this is far from tight
+const auto WRITER_INTERVAL = std::chrono::milliseconds(20);
+// Largest chunk (in frames) handed to the file at once
+const size_t WRITE_CHUNK = 1 << 15;
+
+} // namespace
+
+StreamingRecorder::StreamingRecorder(int sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(std::max(1, channels))
+    , m_ringSize(RING_FRAMES * m_channels)
+    , m_writePosition(0)
+    , m_readPosition(0)
+    , m_capturing(false)
+    , m_writeInFlight(false)
+    , m_writerRunning(false)
+    , m_framesRecorded(0)
+    , m_droppedFrames(0)
+{
+    m_ring.resize(m_ringSize, 0.0f);
+}
+
+StreamingRecorder::~StreamingRecorder()
+{
+    stop();
+}
+
+bool StreamingRecorder::start(const std::string& filename)
+{
+    stop();
+
+    if (!m_file.open(filename, m_sampleRate, m_channels)) {
+        return false;
+    }
+
+    m_writePosition.store(0, std::memory_order_relaxed);
+    m_readPosition.store(0, std::memory_order_relaxed);
+    m_framesRecorded.store(0, std::memory_order_relaxed);
+    m_droppedFrames.store(0, std::memory_order_relaxed);
+
+    m_writerRunning.store(true, std::memory_order_relaxed);
+    m_writerThread = std::thread(&StreamingRecorder::writerLoop, this);
+
+    // Publish the reset ring before the audio thread may write
+    m_capturing.store(true, std::memory_order_seq_cst);
+    return true;
+}
+
+void StreamingRecorder::stop()
+{
+    if (!m_writerThread.joinable()) {
+        return;
+    }
+
+    // Pairs with write(): after this loop no write() can still be in the ring
+    m_capturing.store(false, std::memory_order_seq_cst);
+    while (m_writeInFlight.load(std::memory_order_seq_cst)) {
+        std::this_thread::yield();
+    }
+
+    m_writerRunning.store(false, std::memory_order_release);
+    m_writerThread.join();
+
+    const uint64_t dropped = m_droppedFrames.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        std::cerr << "Streaming recorder dropped " << dropped << " frames (disk too slow)" << std::endl;
+    }
+}
+
+template <typename Copy>
+void StreamingRecorder::push(int frames, Copy copy)
+{
+    m_writeInFlight.store(true, std::memory_order_seq_cst);
+
+    if (m_capturing.load(std::memory_order_seq_cst)) {
+        const size_t count = static_cast<size_t>(frames) * m_channels;
+        const uint64_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+        const uint64_t readPosition = m_readPosition.load(std::memory_order_acquire);
+
+        if (writePosition - readPosition + count > m_ringSize) {
+            m_droppedFrames.store(m_droppedFrames.load(std::memory_order_relaxed) + frames,
+                                  std::memory_order_relaxed);
+        } else {
+            // Copy in at most two pieces around the end of the ring
+            const size_t start = writePosition % m_ringSize;
+            const int first = static_cast<int>(std::min(count, m_ringSize - start) / m_channels);
+            copy(start, 0, first);
+            copy(0, first, frames - first);
+
+            m_writePosition.store(writePosition + count, std::memory_order_release);
+        }
+    }
+
+    m_writeInFlight.store(false, std::memory_order_release);
+}
+
+void StreamingRecorder::write(const float* samples, int frames)
+{
+    push(frames, [this, samples](size_t offset, int firstFrame, int count) {
+        std::memcpy(m_ring.data() + offset, samples + static_cast<size_t>(firstFrame) * m_channels,
+                    static_cast<size_t>(count) * m_channels * sizeof(float));
+    });
+}
+
+void StreamingRecorder::writePlanar(const float* const* planes, int frames)
+{
+    push(frames, [this, planes](size_t offset, int firstFrame, int count) {
+        float* out = m_ring.data() + offset;
+        for (int c = 0; c < m_channels; ++c) {
+            const float* in = planes[c] + firstFrame;
+            for (int i = 0; i < count; ++i) {
+                out[i * m_channels + c] = in[i];
+            }
+        }
+    });
+}
+
+void StreamingRecorder::writerLoop()
+{
+    while (m_writerRunning.load(std::memory_order_acquire)) {
+        if (drain() == 0) {
+            std::this_thread::sleep_for(WRITER_INTERVAL);
+        }
+    }
+
+    // Whatever the audio thread pushed before stop()
+    drain();
+    m_file.close();
+}
+
+size_t StreamingRecorder::drain()
+{
+    const uint64_t writePosition = m_writePosition.load(std::memory_order_acquire);
+    uint64_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+    size_t written = 0;
+
+    while (readPosition < writePosition) {
+        const size_t start = readPosition % m_ringSize;
+        size_t count = std::min<uint64_t>(writePosition - readPosition, WRITE_CHUNK * m_channels);
+        count = std::min(count, m_ringSize - start);
+
+        m_file.write(m_ring.data() + start, static_cast<int>(count / m_channels));
+
+        readPosition += count;
+        written += count;
+        m_readPosition.store(readPosition, std::memory_order_release);
+        m_framesRecorded.store(m_file.framesWritten(), std::memory_order_relaxed);
+    }
+
+    return written;
+}
@@ -1,77 +1,75 @@
 #include "vsynth/Synthesizer.h"
+#include "vsynth/Wavetable.h"
 #include <cmath>
 #include <algorithm>
-#include <ranges>
+#include <thread>
 
-// Voice Implementation
-Voice::Voice(int n, float v, int oscillatorCount, int sampleRate)
-    : note(n), velocity(v), isActive(true), phase(0.0f)
+// Synthesizer Implementation
+Synthesizer::Synthesizer(int sampleRate, int maxVoices, int renderThreads)
+    : m_sampleRate(sampleRate)
+    , m_deltaTime(1.0f / static_cast<float>(sampleRate))
+    , m_voices(std::max(1, std::min(MAX_VOICES, maxVoices)), sampleRate)
+    , m_stealPolicy(VoiceStealPolicy::OLDEST)
+    , m_activeVoices(0)
+    , m_voiceSteals(0)
+    , m_parameters(sampleRate)
+    , m_waveform(0)
+    , m_oscillatorCount(2)
+    , m_pan(0.0f)
+    , m_spread(0.0f)
+    , m_vibratoPhase(0.0f)
+    , m_profiler(nullptr)
+    , m_voiceBus(CHANNELS, MAX_BLOCK_SIZE)
+    , m_outputBus(CHANNELS, MAX_BLOCK_SIZE)
 {
-    float frequency = 440.0f * std::pow(2.0f, (n - 69) / 12.0f);
+    m_effects = std::make_unique<Effects>(sampleRate);
     
-    // Create oscillators
-    for (int i = 0; i < oscillatorCount; ++i) {
-        auto osc = std::make_unique<Oscillator>(frequency, sampleRate);
-        // Slightly detune additional oscillators for richness
-        if (i > 0) {
-            float detune = 1.0f + (i * 0.01f);
-            osc->setFrequency(frequency * detune);
-        }
-        oscillators.push_back(std::move(osc));
-    }
+    // Build the shared band-limited tables now rather than on the audio thread
+    Wavetable::initialize();
     
-    envelope = std::make_unique<ADSREnvelope>(sampleRate);
-    envelope->trigger();
-}
-
-float Voice::process(float deltaTime)
-{
-    if (!isActive) return 0.0f;
+    m_vibratoBuffer.resize(MAX_BLOCK_SIZE, 1.0f);
     
-    float output = 0.0f;
+    // Times only change a ramp's slope, so they take effect at once; levels
+    // and mixes glide. Everything is pushed to the voices and effects on
+    // the first render.
+    m_parameters.configure(ParameterId::ATTACK, RampType::NONE, 0.0f, 0.1f);
+    m_parameters.configure(ParameterId::DECAY, RampType::NONE, 0.0f, 0.2f);
+    m_parameters.configure(ParameterId::SUSTAIN, RampType::LINEAR, 0.02f, 0.7f);
+    m_parameters.configure(ParameterId::RELEASE, RampType::NONE, 0.0f, 0.5f);
+    m_parameters.configure(ParameterId::VIBRATO_RATE, RampType::ONE_POLE, 0.02f, 5.0f);
+    m_parameters.configure(ParameterId::VIBRATO_DEPTH, RampType::ONE_POLE, 0.02f, 0.02f);
+    m_parameters.configure(ParameterId::FILTER_CUTOFF, RampType::ONE_POLE, 0.02f, 2000.0f);
+    m_parameters.configure(ParameterId::FILTER_RESONANCE, RampType::ONE_POLE, 0.02f, 0.2f);
+    m_parameters.configure(ParameterId::FILTER_ENVELOPE_AMOUNT, RampType::ONE_POLE, 0.02f, 0.0f);
+    m_parameters.configure(ParameterId::FILTER_KEY_TRACKING, RampType::ONE_POLE, 0.02f, 0.0f);
+    m_parameters.configure(ParameterId::FILTER_ATTACK, RampType::NONE, 0.0f, 0.01f);
+    m_parameters.configure(ParameterId::FILTER_DECAY, RampType::NONE, 0.0f, 0.3f);
+    m_parameters.configure(ParameterId::FILTER_SUSTAIN, RampType::LINEAR, 0.02f, 0.5f);
+    m_parameters.configure(ParameterId::FILTER_RELEASE, RampType::NONE, 0.0f, 0.5f);
+    m_parameters.configure(ParameterId::REVERB_MIX, RampType::LINEAR, 0.05f, 0.3f);
+    m_parameters.configure(ParameterId::REVERB_ROOM_SIZE, RampType::ONE_POLE, 0.05f, 0.5f);
+    m_parameters.configure(ParameterId::REVERB_DAMPING, RampType::ONE_POLE, 0.05f, 0.5f);
+    m_parameters.configure(ParameterId::REVERB_WIDTH, RampType::ONE_POLE, 0.05f, 1.0f);
+    m_parameters.configure(ParameterId::DELAY_MIX, RampType::LINEAR, 0.05f, 0.3f);
+    m_parameters.configure(ParameterId::DELAY_FEEDBACK, RampType::ONE_POLE, 0.05f, 0.3f);
+    m_parameters.configure(ParameterId::CONVOLUTION_MIX, RampType::LINEAR, 0.05f, 0.3f);
     
-    // Mix all oscillators
-    for (auto& osc : oscillators) {
-        output += osc->process();
+    for (int c = 0; c < CHANNELS; ++c) {
+        m_voiceOversamplers.emplace_back(MAX_BLOCK_SIZE);
+        m_effectsOversamplers.emplace_back(MAX_BLOCK_SIZE);
     }
+    setOversampling(1, OversamplingQuality::BALANCED);
     
-    // Average the oscillators
-    if (!oscillators.empty()) {
-        output /= static_cast<float>(oscillators.size());
+    // More workers than spare cores would only preempt the audio thread
+    renderThreads = std::max(0, std::min(MAX_RENDER_THREADS, renderThreads));
+    const unsigned int cores = std::thread::hardware_concurrency();
+    if (cores > 0) {
+        renderThreads = std::min(renderThreads, static_cast<int>(cores) - 1);
     }
-    
-    // Apply envelope
-    float envLevel = envelope->process();
-    output *= envLevel * velocity;
-    
-    // Check if voice should be deactivated
-    if (!envelope->isActive()) {
-        isActive = false;
+    if (renderThreads > 0) {
+        m_renderThreads = std::make_unique<RenderThreadPool>(renderThreads);
+        m_voices.setRenderThreads(m_renderThreads.get());
     }
-    
-    return output;
-}
-
-void Voice::release()
-{
-    envelope->release();
-}
-
-// Synthesizer Implementation
-Synthesizer::Synthesizer(int sampleRate)
-    : m_sampleRate(sampleRate)
-    , m_deltaTime(1.0f / static_cast<float>(sampleRate))
-    , m_attack(0.1f)
-    , m_decay(0.2f)
-    , m_sustain(0.7f)
-    , m_release(0.5f)
-    , m_waveform(0)
-    , m_oscillatorCount(2)
-    , m_vibratoRate(5.0f)
-    , m_vibratoDepth(0.02f)
-    , m_vibratoPhase(0.0f)
-{
-    m_effects = std::make_unique<Effects>(sampleRate);
 }
 
 Synthesizer::~Synthesizer() = default;
@@ -79,129 +77,201 @@ Synthesizer::~Synthesizer() = default;
 void Synthesizer::noteOn(int note, float velocity)
 {
     // Check if we already have this note playing
-    for (auto& voice : m_voices) {
-        if (voice->note == note && voice->isActive) {
-            voice->release(); // Release the old one
+    for (int slot = 0; slot < m_voices.activeCount(); ++slot) {
+        if (m_voices.note(slot) == note && !m_voices.isReleasing(slot)) {
+            if (m_stealPolicy == VoiceStealPolicy::SAME_NOTE) {
+                m_voices.retrigger(slot, velocity);
+                return;
+            }
+            m_voices.release(slot); // Release the old one
             break;
         }
     }
     
-    // Remove inactive voices if we're at the limit
-    if (m_voices.size() >= MAX_VOICES) {
-        cleanupVoices();
-        
-        // If still at limit, remove the oldest voice
-        if (m_voices.size() >= MAX_VOICES) {
-            m_voices.erase(m_voices.begin());
-        }
+    int slot;
+    if (!m_voices.isFull()) {
+        slot = m_voices.allocate();
+    } else {
+        slot = findVoiceToSteal(note);
+        m_voiceSteals.fetch_add(1, std::memory_order_relaxed);
     }
     
-    // Create new voice
-    auto voice = std::make_unique<Voice>(note, velocity, m_oscillatorCount, m_sampleRate);
-    
-    // Set voice parameters
-    voice->envelope->setAttack(m_attack);
-    voice->envelope->setDecay(m_decay);
-    voice->envelope->setSustain(m_sustain);
-    voice->envelope->setRelease(m_release);
+    m_voices.startVoice(slot, note, velocity, m_oscillatorCount, m_pan, m_spread);
+    m_voices.trigger(slot);
     
-    for (auto& osc : voice->oscillators) {
-        osc->setWaveform(static_cast<WaveformType>(m_waveform));
-    }
-    
-    m_voices.push_back(std::move(voice));
+    m_activeVoices.store(m_voices.activeCount(), std::memory_order_relaxed);
 }
 
 void Synthesizer::noteOff(int note)
 {
-    for (auto& voice : m_voices) {
-        if (voice->note == note && voice->isActive) {
-            voice->release();
+    for (int slot = 0; slot < m_voices.activeCount(); ++slot) {
+        if (m_voices.note(slot) == note) {
+            m_voices.release(slot);
         }
     }
 }
 
 float Synthesizer::process()
 {
-    float output = 0.0f;
+    float output;
+    renderBlock(&output, 1);
+    return output;
+}
+
+void Synthesizer::renderBlock(float* out, int frames)
+{
+    for (int offset = 0; offset < frames; offset += MAX_BLOCK_SIZE) {
+        const int count = std::min(MAX_BLOCK_SIZE, frames - offset);
+        renderBlock(m_outputBus.channel(0), m_outputBus.channel(1), count);
+        m_outputBus.writeInterleaved(out + offset, 1, count);
+    }
+}
+
+void Synthesizer::renderBlock(float* left, float* right, int frames)
+{
+    // The voices render chunk * factor samples per chunk
+    const int chunk = MAX_BLOCK_SIZE / getOversampling();
+    int offset = 0;
+    while (offset < frames) {
+        int count = std::min(chunk, frames - offset);
+        if (m_parameters.isSmoothing()) {
+            count = std::min(count, ParameterStore::SUB_BLOCK_SIZE);
+        }
+        applyParameters(count);
+        renderChunk(left + offset, right + offset, count);
+        offset += count;
+    }
+}
+
+void Synthesizer::applyParameters(int frames)
+{
+    const uint32_t changed = m_parameters.advance(frames);
+    if (changed == 0) {
+        return;
+    }
     
-    // Calculate vibrato
-    float vibrato = std::sin(m_vibratoPhase) * m_vibratoDepth;
-    m_vibratoPhase += (2.0f * M_PI * m_vibratoRate) * m_deltaTime;
-    if (m_vibratoPhase >= 2.0f * M_PI) {
-        m_vibratoPhase -= 2.0f * M_PI;
+    auto update = [&](ParameterId id, auto apply) {
+        if (changed & ParameterStore::bit(id)) {
+            apply(m_parameters.get(id));
+        }
+    };
+    
+    ADSRParameters& envelope = m_voices.envelopeParameters();
+    update(ParameterId::ATTACK, [&](float value) { envelope.setAttack(value); });
+    update(ParameterId::DECAY, [&](float value) { envelope.setDecay(value); });
+    update(ParameterId::SUSTAIN, [&](float value) { envelope.setSustain(value); });
+    update(ParameterId::RELEASE, [&](float value) { envelope.setRelease(value); });
+    ADSRParameters& filterEnvelope = m_voices.filterEnvelopeParameters();
+    update(ParameterId::FILTER_CUTOFF, [&](float value) { m_voices.setFilterCutoff(value); });
+    update(ParameterId::FILTER_RESONANCE, [&](float value) { m_voices.setFilterResonance(value); });
+    update(ParameterId::FILTER_ENVELOPE_AMOUNT, [&](float value) { m_voices.setFilterEnvelopeAmount(value); });
+    update(ParameterId::FILTER_KEY_TRACKING, [&](float value) { m_voices.setFilterKeyTracking(value); });
+    update(ParameterId::FILTER_ATTACK, [&](float value) { filterEnvelope.setAttack(value); });
+    update(ParameterId::FILTER_DECAY, [&](float value) { filterEnvelope.setDecay(value); });
+    update(ParameterId::FILTER_SUSTAIN, [&](float value) { filterEnvelope.setSustain(value); });
+    update(ParameterId::FILTER_RELEASE, [&](float value) { filterEnvelope.setRelease(value); });
+    update(ParameterId::REVERB_MIX, [&](float value) { m_effects->setReverbAmount(value); });
+    update(ParameterId::REVERB_ROOM_SIZE, [&](float value) { m_effects->setReverbRoomSize(value); });
+    update(ParameterId::REVERB_DAMPING, [&](float value) { m_effects->setReverbDamping(value); });
+    update(ParameterId::REVERB_WIDTH, [&](float value) { m_effects->setReverbWidth(value); });
+    update(ParameterId::DELAY_MIX, [&](float value) { m_effects->setDelayAmount(value); });
+    update(ParameterId::DELAY_FEEDBACK, [&](float value) { m_effects->setDelayFeedback(value); });
+    update(ParameterId::CONVOLUTION_MIX, [&](float value) { m_effects->setConvolutionMix(value); });
+}
+
+void Synthesizer::renderChunk(float* left, float* right, int frames)
+{
+    {
+        CallbackProfiler::ScopedStage stage(m_profiler, ProfilerStage::VOICES);
+        renderVoices(left, right, frames);
     }
     
-    // Process all voices
-    for (auto& voice : m_voices) {
-        if (voice->isActive) {
-            // Apply vibrato to oscillators
-            float baseFreq = noteToFrequency(voice->note);
-            float vibratoFreq = baseFreq * (1.0f + vibrato);
-            
-            for (size_t i = 0; i < voice->oscillators.size(); ++i) {
-                float detune = (i > 0) ? (1.0f + (i * 0.01f)) : 1.0f;
-                voice->oscillators[i]->setFrequency(vibratoFreq * detune);
+    CallbackProfiler::ScopedStage stage(m_profiler, ProfilerStage::EFFECTS);
+    
+    // Apply effects
+    m_effects->processStereo(left, right, frames);
+    
+    // Limit output, at the oversampled rate so the clipped edges do not alias
+    float* const channels[CHANNELS] = {left, right};
+    for (int c = 0; c < CHANNELS; ++c) {
+        float* out = channels[c];
+        Oversampler& oversampler = m_effectsOversamplers[c];
+        const int factor = oversampler.factor();
+        if (factor > 1) {
+            float* upsampled = oversampler.upsample(out, frames);
+            for (int i = 0; i < frames * factor; ++i) {
+                upsampled[i] = std::max(-1.0f, std::min(1.0f, upsampled[i]));
             }
-            
-            output += voice->process(m_deltaTime);
+            oversampler.downsample(upsampled, out, frames);
+        }
+        // The decimation filter's ripple can overshoot slightly
+        for (int i = 0; i < frames; ++i) {
+            out[i] = std::max(-1.0f, std::min(1.0f, out[i]));
         }
     }
+}
+
+void Synthesizer::renderVoices(float* left, float* right, int frames)
+{
+    const int factor = getOversampling();
+    float* voiceLeft = (factor > 1) ? m_voiceBus.channel(0) : left;
+    float* voiceRight = (factor > 1) ? m_voiceBus.channel(1) : right;
+    const int voiceFrames = frames * factor;
     
-    // Clean up inactive voices periodically
-    static int cleanupCounter = 0;
-    if (++cleanupCounter > 1000) {
-        cleanupVoices();
-        cleanupCounter = 0;
+    // Calculate vibrato once per sample for all voices
+    const float vibratoRate = m_parameters.get(ParameterId::VIBRATO_RATE);
+    const float vibratoDepth = m_parameters.get(ParameterId::VIBRATO_DEPTH);
+    const float vibratoIncrement = (2.0f * M_PI * vibratoRate) * m_deltaTime / static_cast<float>(factor);
+    for (int i = 0; i < voiceFrames; ++i) {
+        m_vibratoBuffer[i] = 1.0f + std::sin(m_vibratoPhase) * vibratoDepth;
+        m_vibratoPhase += vibratoIncrement;
+        if (m_vibratoPhase >= 2.0f * M_PI) {
+            m_vibratoPhase -= 2.0f * M_PI;
+        }
     }
     
-    // Apply effects
-    output = m_effects->process(output);
+    std::fill(voiceLeft, voiceLeft + voiceFrames, 0.0f);
+    std::fill(voiceRight, voiceRight + voiceFrames, 0.0f);
+    
+    // Process all voices (finished voices are returned to the pool)
+    m_voices.renderBlock(voiceLeft, voiceRight, voiceFrames, static_cast<WaveformType>(m_waveform),
+                         m_vibratoBuffer.data());
+    m_activeVoices.store(m_voices.activeCount(), std::memory_order_relaxed);
     
-    // Limit output
-    return std::max(-1.0f, std::min(1.0f, output));
+    if (factor > 1) {
+        m_voiceOversamplers[0].downsample(voiceLeft, left, frames);
+        m_voiceOversamplers[1].downsample(voiceRight, right, frames);
+    }
 }
 
 void Synthesizer::setAttack(float attack)
 {
-    m_attack = attack;
-    for (auto& voice : m_voices) {
-        voice->envelope->setAttack(attack);
-    }
+    m_parameters.set(ParameterId::ATTACK, attack);
 }
 
 void Synthesizer::setDecay(float decay)
 {
-    m_decay = decay;
-    for (auto& voice : m_voices) {
-        voice->envelope->setDecay(decay);
-    }
+    m_parameters.set(ParameterId::DECAY, decay);
 }
 
 void Synthesizer::setSustain(float sustain)
 {
-    m_sustain = sustain;
-    for (auto& voice : m_voices) {
-        voice->envelope->setSustain(sustain);
-    }
+    m_parameters.set(ParameterId::SUSTAIN, std::clamp(sustain, 0.0f, 1.0f));
 }
 
 void Synthesizer::setRelease(float release)
 {
-    m_release = release;
-    for (auto& voice : m_voices) {
-        voice->envelope->setRelease(release);
-    }
+    m_parameters.set(ParameterId::RELEASE, release);
+}
+
+void Synthesizer::setEnvelopeCurve(EnvelopeCurve curve)
+{
+    m_voices.envelopeParameters().setCurve(curve);
 }
 
 void Synthesizer::setWaveform(int waveform)
 {
-    m_waveform = waveform;
-    for (auto& voice : m_voices) {
-        for (auto& osc : voice->oscillators) {
-            osc->setWaveform(static_cast<WaveformType>(waveform));
-        }
-    }
+    m_waveform = std::max(0, std::min(static_cast<int>(WaveformType::BANDLIMITED_TRIANGLE), waveform));
 }
 
 void Synthesizer::setOscillatorCount(int count)
@@ -212,36 +282,205 @@ void Synthesizer::setOscillatorCount(int count)
 
 void Synthesizer::setVibratoRate(float rate)
 {
-    m_vibratoRate = rate;
+    m_parameters.set(ParameterId::VIBRATO_RATE, rate);
 }
 
 void Synthesizer::setVibratoDepth(float depth)
 {
-    m_vibratoDepth = depth;
+    m_parameters.set(ParameterId::VIBRATO_DEPTH, depth);
+}
+
+void Synthesizer::setPan(float pan)
+{
+    m_pan = std::max(-1.0f, std::min(1.0f, pan));
+}
+
+void Synthesizer::setStereoSpread(float spread)
+{
+    m_spread = std::max(0.0f, std::min(1.0f, spread));
+}
+
+void Synthesizer::setFilterType(FilterType type)
+{
+    m_voices.setFilterType(type);
+}
+
+void Synthesizer::setFilterCutoff(float cutoff)
+{
+    m_parameters.set(ParameterId::FILTER_CUTOFF, std::clamp(cutoff, VoiceFilterBank::MIN_CUTOFF, 20000.0f));
+}
+
+void Synthesizer::setFilterResonance(float resonance)
+{
+    m_parameters.set(ParameterId::FILTER_RESONANCE, std::clamp(resonance, 0.0f, 1.0f));
+}
+
+void Synthesizer::setFilterEnvelopeAmount(float octaves)
+{
+    m_parameters.set(ParameterId::FILTER_ENVELOPE_AMOUNT, std::clamp(octaves, -8.0f, 8.0f));
+}
+
+void Synthesizer::setFilterKeyTracking(float amount)
+{
+    m_parameters.set(ParameterId::FILTER_KEY_TRACKING, std::clamp(amount, 0.0f, 1.0f));
+}
+
+void Synthesizer::setFilterAttack(float attack)
+{
+    m_parameters.set(ParameterId::FILTER_ATTACK, attack);
+}
+
+void Synthesizer::setFilterDecay(float decay)
+{
+    m_parameters.set(ParameterId::FILTER_DECAY, decay);
+}
+
+void Synthesizer::setFilterSustain(float sustain)
+{
+    m_parameters.set(ParameterId::FILTER_SUSTAIN, std::clamp(sustain, 0.0f, 1.0f));
+}
+
+void Synthesizer::setFilterRelease(float release)
+{
+    m_parameters.set(ParameterId::FILTER_RELEASE, release);
 }
 
 void Synthesizer::setReverb(float reverb)
 {
-    m_effects->setReverbAmount(reverb);
+    m_parameters.set(ParameterId::REVERB_MIX, std::clamp(reverb, 0.0f, 1.0f));
 }
 
 void Synthesizer::setDelay(float delay)
 {
-    m_effects->setDelayAmount(delay);
+    m_parameters.set(ParameterId::DELAY_MIX, std::clamp(delay, 0.0f, 1.0f));
+}
+
+void Synthesizer::setDelayMode(DelayMode mode)
+{
+    m_effects->setDelayMode(mode);
+}
+
+void Synthesizer::setDelayTime(float time)
+{
+    m_effects->setDelayTime(time);
+}
+
+void Synthesizer::setDelayFeedback(float feedback)
+{
+    m_parameters.set(ParameterId::DELAY_FEEDBACK, feedback);
+}
+
+void Synthesizer::setDelayModulationRate(float rate)
+{
+    m_effects->setDelayModulationRate(rate);
+}
+
+void Synthesizer::setDelayModulationDepth(float depth)
+{
+    m_effects->setDelayModulationDepth(depth);
+}
+
+void Synthesizer::setTempo(float bpm)
+{
+    m_effects->setTempo(bpm);
 }
 
-void Synthesizer::cleanupVoices()
+void Synthesizer::setDelaySync(float beats)
 {
-    m_voices.erase(
-        std::remove_if(m_voices.begin(), m_voices.end(),
-            [](const std::unique_ptr<Voice>& voice) {
-                return !voice->isActive;
-            }),
-        m_voices.end()
-    );
+    m_effects->setDelaySync(beats);
 }
 
-float Synthesizer::noteToFrequency(int note)
+void Synthesizer::setReverbRoomSize(float roomSize)
 {
-    return 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+    m_parameters.set(ParameterId::REVERB_ROOM_SIZE, std::clamp(roomSize, 0.0f, 1.0f));
+}
+
+void Synthesizer::setReverbDamping(float damping)
+{
+    m_parameters.set(ParameterId::REVERB_DAMPING, std::clamp(damping, 0.0f, 1.0f));
+}
+
+void Synthesizer::setReverbWidth(float width)
+{
+    m_parameters.set(ParameterId::REVERB_WIDTH, std::clamp(width, 0.0f, 1.0f));
+}
+
+void Synthesizer::loadImpulseResponse(const std::string& filename)
+{
+    m_effects->loadImpulseResponse(filename);
+}
+
+bool Synthesizer::waitForImpulseResponse()
+{
+    return m_effects->waitForImpulseResponse();
+}
+
+void Synthesizer::setConvolutionMix(float mix)
+{
+    m_parameters.set(ParameterId::CONVOLUTION_MIX, std::clamp(mix, 0.0f, 1.0f));
+}
+
+void Synthesizer::setStealPolicy(VoiceStealPolicy policy)
+{
+    m_stealPolicy = policy;
+}
+
+void Synthesizer::setOversampling(int factor, OversamplingQuality quality)
+{
+    for (int c = 0; c < CHANNELS; ++c) {
+        m_voiceOversamplers[c].configure(factor, quality);
+        m_effectsOversamplers[c].configure(factor, quality);
+    }
+    m_voices.setSampleRate(m_sampleRate * getOversampling());
+}
+
+int Synthesizer::findVoiceToSteal(int note) const
+{
+    switch (m_stealPolicy) {
+        case VoiceStealPolicy::QUIETEST:
+            return findQuietestVoice();
+            
+        case VoiceStealPolicy::SAME_NOTE:
+            // A released voice of the same note is the least audible choice
+            for (int slot = 0; slot < m_voices.activeCount(); ++slot) {
+                if (m_voices.note(slot) == note) {
+                    return slot;
+                }
+            }
+            return findOldestVoice(false);
+            
+        case VoiceStealPolicy::RELEASED_FIRST: {
+            int slot = findOldestVoice(true);
+            return slot >= 0 ? slot : findOldestVoice(false);
+        }
+            
+        case VoiceStealPolicy::OLDEST:
+        default:
+            return findOldestVoice(false);
+    }
+}
+
+int Synthesizer::findOldestVoice(bool releasedOnly) const
+{
+    int oldest = -1;
+    for (int slot = 0; slot < m_voices.activeCount(); ++slot) {
+        if (releasedOnly && !m_voices.isReleasing(slot)) {
+            continue;
+        }
+        if (oldest < 0 || m_voices.age(slot) < m_voices.age(oldest)) {
+            oldest = slot;
+        }
+    }
+    return oldest;
+}
+
+int Synthesizer::findQuietestVoice() const
+{
+    int quietest = 0;
+    for (int slot = 1; slot < m_voices.activeCount(); ++slot) {
+        if (m_voices.level(slot) < m_voices.level(quietest)) {
+            quietest = slot;
+        }
+    }
+    return quietest;
 }
@@ -0,0 +1,589 @@
+#include "vsynth/VoiceFilterBank.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef VSYNTH_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Highest cutoff as a fraction of the sample rate (tan() grows without
+// bound towards Nyquist)
+constexpr float MAX_CUTOFF_RATIO = 0.45f;
+// Full resonance: a state-variable Q of 50, and ladder feedback just short
+// of self-oscillation (4), since the ladder here is linear
+constexpr float SVF_MAX_RESONANCE = 0.99f;
+constexpr float LADDER_MAX_FEEDBACK = 3.9f;
+
+// Damping k of the state-variable filter (1 / k is its Q), or the ladder's
+// feedback gain
+float feedbackFor(FilterType type, float resonance)
+{
+    resonance = std::max(0.0f, std::min(1.0f, resonance));
+    if (type == FilterType::LADDER) {
+        return LADDER_MAX_FEEDBACK * resonance;
+    }
+    return 2.0f - 2.0f * SVF_MAX_RESONANCE * resonance;
+}
+
+// Scalar filter steps. The state-variable filter is Simper's trapezoidal
+// SVF with a1 = 1 / (1 + g * (g + k)), a2 = g * a1 and a3 = g * a2. The
+// ladder is four trapezoidal one-poles (gain G = g / (1 + g)) whose
+// feedback loop is solved for the output in closed form.
+
+template <FilterType T>
+inline float svfScalar(float x, float& s1, float& s2, float a1, float a2, float a3, float k)
+{
+    const float v3 = x - s2;
+    const float v1 = a1 * s1 + a2 * v3;
+    const float v2 = s2 + a2 * s1 + a3 * v3;
+    s1 = 2.0f * v1 - s1;
+    s2 = 2.0f * v2 - s2;
+    if constexpr (T == FilterType::LOWPASS) {
+        return v2;
+    } else if constexpr (T == FilterType::BANDPASS) {
+        return k * v1;
+    } else {
+        return x - k * v1 - v2;
+    }
+}
+
+inline float ladderScalar(float x, float* s, float G, float G4, float scale, float k)
+{
+    // The stages' stored contribution to the output, then the output that
+    // satisfies y = G^4 * (x - k * y) + stored
+    const float stored = (1.0f - G) * (s[3] + G * (s[2] + G * (s[1] + G * s[0])));
+    float y = x - k * (G4 * x + stored) * scale;
+    for (int stage = 0; stage < 4; ++stage) {
+        const float v = (y - s[stage]) * G;
+        y = v + s[stage];
+        s[stage] = y + v;
+    }
+    return y;
+}
+
+template <FilterType T>
+void filterVoiceScalar(float* const* states, float& tuning, float k, const float* tunings, int stride,
+                       int firstUpdate, const float* leftLanes, const float* rightLanes,
+                       const float* gains, float* left, float* right, int frames)
+{
+    float g = tuning;
+    float leftState[4];
+    float rightState[4];
+    for (int j = 0; j < 4; ++j) {
+        leftState[j] = states[j][0];
+        rightState[j] = states[4 + j][0];
+    }
+
+    int t = 0;
+    int next = firstUpdate;
+    while (t < frames) {
+        if (t == next) {
+            g = *tunings;
+            tunings += stride;
+            next += VoiceFilterBank::CONTROL_INTERVAL;
+        }
+        const int stop = std::min(frames, next);
+
+        if constexpr (T == FilterType::LADDER) {
+            const float G = g / (1.0f + g);
+            const float G2 = G * G;
+            const float G4 = G2 * G2;
+            const float scale = 1.0f / (1.0f + k * G4);
+            for (; t < stop; ++t) {
+                const float gain = gains[t * stride];
+                left[t] += ladderScalar(leftLanes[t * stride], leftState, G, G4, scale, k) * gain;
+                right[t] += ladderScalar(rightLanes[t * stride], rightState, G, G4, scale, k) * gain;
+            }
+        } else {
+            const float a1 = 1.0f / (1.0f + g * (g + k));
+            const float a2 = g * a1;
+            const float a3 = g * a2;
+            for (; t < stop; ++t) {
+                const float gain = gains[t * stride];
+                left[t] += svfScalar<T>(leftLanes[t * stride], leftState[0], leftState[1],
+                                        a1, a2, a3, k) * gain;
+                right[t] += svfScalar<T>(rightLanes[t * stride], rightState[0], rightState[1],
+                                         a1, a2, a3, k) * gain;
+            }
+        }
+    }
+
+    for (int j = 0; j < 4; ++j) {
+        states[j][0] = leftState[j];
+        states[4 + j][0] = rightState[j];
+    }
+    tuning = g;
+}
+
+#ifdef VSYNTH_X86
+
+// SSE2 filter steps, same algorithms as the scalar versions
+
+template <FilterType T>
+inline __m128 svfSSE2(__m128 x, __m128& s1, __m128& s2, __m128 a1, __m128 a2, __m128 a3, __m128 k)
+{
+    __m128 v3 = _mm_sub_ps(x, s2);
+    __m128 v1 = _mm_add_ps(_mm_mul_ps(a1, s1), _mm_mul_ps(a2, v3));
+    __m128 v2 = _mm_add_ps(s2, _mm_add_ps(_mm_mul_ps(a2, s1), _mm_mul_ps(a3, v3)));
+    s1 = _mm_sub_ps(_mm_add_ps(v1, v1), s1);
+    s2 = _mm_sub_ps(_mm_add_ps(v2, v2), s2);
+    if constexpr (T == FilterType::LOWPASS) {
+        return v2;
+    } else if constexpr (T == FilterType::BANDPASS) {
+        return _mm_mul_ps(k, v1);
+    } else {
+        return _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, v1)), v2);
+    }
+}
+
+inline __m128 ladderSSE2(__m128 x, __m128* s, __m128 G, __m128 G4, __m128 scale, __m128 k)
+{
+    __m128 stored = _mm_add_ps(s[1], _mm_mul_ps(G, s[0]));
+    stored = _mm_add_ps(s[2], _mm_mul_ps(G, stored));
+    stored = _mm_add_ps(s[3], _mm_mul_ps(G, stored));
+    stored = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), G), stored);
+
+    __m128 feedback = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(G4, x), stored), scale);
+    __m128 y = _mm_sub_ps(x, _mm_mul_ps(k, feedback));
+    for (int stage = 0; stage < 4; ++stage) {
+        __m128 v = _mm_mul_ps(_mm_sub_ps(y, s[stage]), G);
+        y = _mm_add_ps(v, s[stage]);
+        s[stage] = _mm_add_ps(y, v);
+    }
+    return y;
+}
+
+inline float horizontalSum(__m128 v)
+{
+    __m128 high = _mm_movehl_ps(v, v);
+    __m128 sum = _mm_add_ps(v, high);
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+template <FilterType T>
+void filterLanesSSE2(float* states, float* currentTunings, int stride, float feedback, int begin,
+                     int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                     const float* rightLanes, const float* gains, float* left, float* right, int frames)
+{
+    alignas(16) float leftAccumulators[OscillatorBank::MAX_FRAMES * 4];
+    alignas(16) float rightAccumulators[OscillatorBank::MAX_FRAMES * 4];
+    std::fill(leftAccumulators, leftAccumulators + frames * 4, 0.0f);
+    std::fill(rightAccumulators, rightAccumulators + frames * 4, 0.0f);
+
+    const __m128 k = _mm_set1_ps(feedback);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (int voice = begin; voice < end; voice += 4) {
+        __m128 leftState[4];
+        __m128 rightState[4];
+        for (int j = 0; j < 4; ++j) {
+            leftState[j] = _mm_load_ps(states + j * stride + voice);
+            rightState[j] = _mm_load_ps(states + (4 + j) * stride + voice);
+        }
+        __m128 g = _mm_load_ps(currentTunings + voice);
+
+        int t = 0;
+        int next = firstUpdate;
+        const float* row = tunings + voice;
+        while (t < frames) {
+            if (t == next) {
+                g = _mm_load_ps(row);
+                row += stride;
+                next += VoiceFilterBank::CONTROL_INTERVAL;
+            }
+            const int stop = std::min(frames, next);
+
+            if constexpr (T == FilterType::LADDER) {
+                const __m128 G = _mm_div_ps(g, _mm_add_ps(one, g));
+                const __m128 G2 = _mm_mul_ps(G, G);
+                const __m128 G4 = _mm_mul_ps(G2, G2);
+                const __m128 scale = _mm_div_ps(one, _mm_add_ps(one, _mm_mul_ps(k, G4)));
+                for (; t < stop; ++t) {
+                    const __m128 gain = _mm_load_ps(gains + t * stride + voice);
+                    __m128 l = ladderSSE2(_mm_load_ps(leftLanes + t * stride + voice), leftState,
+                                          G, G4, scale, k);
+                    __m128 r = ladderSSE2(_mm_load_ps(rightLanes + t * stride + voice), rightState,
+                                          G, G4, scale, k);
+                    _mm_store_ps(leftAccumulators + t * 4,
+                                 _mm_add_ps(_mm_load_ps(leftAccumulators + t * 4), _mm_mul_ps(l, gain)));
+                    _mm_store_ps(rightAccumulators + t * 4,
+                                 _mm_add_ps(_mm_load_ps(rightAccumulators + t * 4), _mm_mul_ps(r, gain)));
+                }
+            } else {
+                const __m128 a1 = _mm_div_ps(one, _mm_add_ps(one, _mm_mul_ps(g, _mm_add_ps(g, k))));
+                const __m128 a2 = _mm_mul_ps(g, a1);
+                const __m128 a3 = _mm_mul_ps(g, a2);
+                for (; t < stop; ++t) {
+                    const __m128 gain = _mm_load_ps(gains + t * stride + voice);
+                    __m128 l = svfSSE2<T>(_mm_load_ps(leftLanes + t * stride + voice),
+                                          leftState[0], leftState[1], a1, a2, a3, k);
+                    __m128 r = svfSSE2<T>(_mm_load_ps(rightLanes + t * stride + voice),
+                                          rightState[0], rightState[1], a1, a2, a3, k);
+                    _mm_store_ps(leftAccumulators + t * 4,
+                                 _mm_add_ps(_mm_load_ps(leftAccumulators + t * 4), _mm_mul_ps(l, gain)));
+                    _mm_store_ps(rightAccumulators + t * 4,
+                                 _mm_add_ps(_mm_load_ps(rightAccumulators + t * 4), _mm_mul_ps(r, gain)));
+                }
+            }
+        }
+
+        for (int j = 0; j < 4; ++j) {
+            _mm_store_ps(states + j * stride + voice, leftState[j]);
+            _mm_store_ps(states + (4 + j) * stride + voice, rightState[j]);
+        }
+        _mm_store_ps(currentTunings + voice, g);
+    }
+
+    for (int t = 0; t < frames; ++t) {
+        left[t] += horizontalSum(_mm_load_ps(leftAccumulators + t * 4));
+        right[t] += horizontalSum(_mm_load_ps(rightAccumulators + t * 4));
+    }
+}
+
+// AVX2/FMA filter steps
+
+template <FilterType T>
+VSYNTH_TARGET_AVX2 inline __m256 svfAVX2(__m256 x, __m256& s1, __m256& s2, __m256 a1, __m256 a2,
+                                         __m256 a3, __m256 k)
+{
+    __m256 v3 = _mm256_sub_ps(x, s2);
+    __m256 v1 = _mm256_fmadd_ps(a1, s1, _mm256_mul_ps(a2, v3));
+    __m256 v2 = _mm256_add_ps(s2, _mm256_fmadd_ps(a2, s1, _mm256_mul_ps(a3, v3)));
+    s1 = _mm256_sub_ps(_mm256_add_ps(v1, v1), s1);
+    s2 = _mm256_sub_ps(_mm256_add_ps(v2, v2), s2);
+    if constexpr (T == FilterType::LOWPASS) {
+        return v2;
+    } else if constexpr (T == FilterType::BANDPASS) {
+        return _mm256_mul_ps(k, v1);
+    } else {
+        return _mm256_sub_ps(_mm256_fnmadd_ps(k, v1, x), v2);
+    }
+}
+
+VSYNTH_TARGET_AVX2 inline __m256 ladderAVX2(__m256 x, __m256* s, __m256 G, __m256 G4, __m256 scale,
+                                            __m256 k)
+{
+    __m256 stored = _mm256_fmadd_ps(G, s[0], s[1]);
+    stored = _mm256_fmadd_ps(G, stored, s[2]);
+    stored = _mm256_fmadd_ps(G, stored, s[3]);
+    stored = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), G), stored);
+
+    __m256 feedback = _mm256_mul_ps(_mm256_fmadd_ps(G4, x, stored), scale);
+    __m256 y = _mm256_fnmadd_ps(k, feedback, x);
+    for (int stage = 0; stage < 4; ++stage) {
+        __m256 v = _mm256_mul_ps(_mm256_sub_ps(y, s[stage]), G);
+        y = _mm256_add_ps(v, s[stage]);
+        s[stage] = _mm256_add_ps(y, v);
+    }
+    return y;
+}
+
+VSYNTH_TARGET_AVX2 inline float horizontalSumAVX2(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+// Two 8-voice groups are filtered side by side (a whole LANE_PADDING of
+// lanes), so one group's serial filter chain runs while the other waits on
+// its latency
+template <FilterType T>
+VSYNTH_TARGET_AVX2 void filterLanesAVX2(float* states, float* currentTunings, int stride, float feedback,
+                                        int begin, int end, const float* tunings, int firstUpdate,
+                                        const float* leftLanes, const float* rightLanes,
+                                        const float* gains, float* left, float* right, int frames)
+{
+    constexpr int GROUPS = OscillatorBank::LANE_PADDING / 8;
+    alignas(32) float leftAccumulators[OscillatorBank::MAX_FRAMES * 8];
+    alignas(32) float rightAccumulators[OscillatorBank::MAX_FRAMES * 8];
+    std::fill(leftAccumulators, leftAccumulators + frames * 8, 0.0f);
+    std::fill(rightAccumulators, rightAccumulators + frames * 8, 0.0f);
+
+    const __m256 k = _mm256_set1_ps(feedback);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for (int voice = begin; voice < end; voice += 8 * GROUPS) {
+        __m256 leftState[GROUPS][4];
+        __m256 rightState[GROUPS][4];
+        __m256 g[GROUPS];
+        for (int group = 0; group < GROUPS; ++group) {
+            const int lane = voice + 8 * group;
+            for (int j = 0; j < 4; ++j) {
+                leftState[group][j] = _mm256_load_ps(states + j * stride + lane);
+                rightState[group][j] = _mm256_load_ps(states + (4 + j) * stride + lane);
+            }
+            g[group] = _mm256_load_ps(currentTunings + lane);
+        }
+
+        int t = 0;
+        int next = firstUpdate;
+        const float* row = tunings + voice;
+        while (t < frames) {
+            if (t == next) {
+                for (int group = 0; group < GROUPS; ++group) {
+                    g[group] = _mm256_load_ps(row + 8 * group);
+                }
+                row += stride;
+                next += VoiceFilterBank::CONTROL_INTERVAL;
+            }
+            const int stop = std::min(frames, next);
+
+            if constexpr (T == FilterType::LADDER) {
+                __m256 G[GROUPS];
+                __m256 G4[GROUPS];
+                __m256 scale[GROUPS];
+                for (int group = 0; group < GROUPS; ++group) {
+                    G[group] = _mm256_div_ps(g[group], _mm256_add_ps(one, g[group]));
+                    const __m256 G2 = _mm256_mul_ps(G[group], G[group]);
+                    G4[group] = _mm256_mul_ps(G2, G2);
+                    scale[group] = _mm256_div_ps(one, _mm256_fmadd_ps(k, G4[group], one));
+                }
+                for (; t < stop; ++t) {
+                    __m256 l = _mm256_load_ps(leftAccumulators + t * 8);
+                    __m256 r = _mm256_load_ps(rightAccumulators + t * 8);
+                    for (int group = 0; group < GROUPS; ++group) {
+                        const int lane = t * stride + voice + 8 * group;
+                        const __m256 gain = _mm256_load_ps(gains + lane);
+                        l = _mm256_fmadd_ps(ladderAVX2(_mm256_load_ps(leftLanes + lane), leftState[group],
+                                                       G[group], G4[group], scale[group], k), gain, l);
+                        r = _mm256_fmadd_ps(ladderAVX2(_mm256_load_ps(rightLanes + lane), rightState[group],
+                                                       G[group], G4[group], scale[group], k), gain, r);
+                    }
+                    _mm256_store_ps(leftAccumulators + t * 8, l);
+                    _mm256_store_ps(rightAccumulators + t * 8, r);
+                }
+            } else {
+                __m256 a1[GROUPS];
+                __m256 a2[GROUPS];
+                __m256 a3[GROUPS];
+                for (int group = 0; group < GROUPS; ++group) {
+                    a1[group] = _mm256_div_ps(one, _mm256_fmadd_ps(g[group], _mm256_add_ps(g[group], k), one));
+                    a2[group] = _mm256_mul_ps(g[group], a1[group]);
+                    a3[group] = _mm256_mul_ps(g[group], a2[group]);
+                }
+                for (; t < stop; ++t) {
+                    __m256 l = _mm256_load_ps(leftAccumulators + t * 8);
+                    __m256 r = _mm256_load_ps(rightAccumulators + t * 8);
+                    for (int group = 0; group < GROUPS; ++group) {
+                        const int lane = t * stride + voice + 8 * group;
+                        const __m256 gain = _mm256_load_ps(gains + lane);
+                        l = _mm256_fmadd_ps(svfAVX2<T>(_mm256_load_ps(leftLanes + lane), leftState[group][0],
+                                                       leftState[group][1], a1[group], a2[group], a3[group], k),
+                                            gain, l);
+                        r = _mm256_fmadd_ps(svfAVX2<T>(_mm256_load_ps(rightLanes + lane), rightState[group][0],
+                                                       rightState[group][1], a1[group], a2[group], a3[group], k),
+                                            gain, r);
+                    }
+                    _mm256_store_ps(leftAccumulators + t * 8, l);
+                    _mm256_store_ps(rightAccumulators + t * 8, r);
+                }
+            }
+        }
+
+        for (int group = 0; group < GROUPS; ++group) {
+            const int lane = voice + 8 * group;
+            for (int j = 0; j < 4; ++j) {
+                _mm256_store_ps(states + j * stride + lane, leftState[group][j]);
+                _mm256_store_ps(states + (4 + j) * stride + lane, rightState[group][j]);
+            }
+            _mm256_store_ps(currentTunings + lane, g[group]);
+        }
+    }
+
+    for (int t = 0; t < frames; ++t) {
+        left[t] += horizontalSumAVX2(_mm256_load_ps(leftAccumulators + t * 8));
+        right[t] += horizontalSumAVX2(_mm256_load_ps(rightAccumulators + t * 8));
+    }
+}
+
+#endif // VSYNTH_X86
+
+} // namespace
+
+VoiceFilterBank::VoiceFilterBank(int stride, int sampleRate)
+    : m_stride(stride)
+    , m_instructionSet(simd::detect())
+{
+    setSampleRate(sampleRate);
+
+    m_states.resize(2 * STATES * m_stride, 0.0f);
+    m_tunings.resize(m_stride, 0.0f);
+
+    switch (m_instructionSet) {
+#ifdef VSYNTH_X86
+        case simd::InstructionSet::AVX2:
+            m_kernel = processAVX2;
+            break;
+        case simd::InstructionSet::SSE2:
+            m_kernel = processSSE2;
+            break;
+#endif
+        default:
+            m_kernel = processScalar;
+            break;
+    }
+}
+
+void VoiceFilterBank::setSampleRate(int sampleRate)
+{
+    // g = tan(pi * cutoff / sampleRate) of the trapezoidal integrators
+    const double maxCutoff = MAX_CUTOFF_RATIO * sampleRate;
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        const double cutoff = std::min(maxCutoff, MIN_CUTOFF * std::exp2(static_cast<double>(i) / STEPS_PER_OCTAVE));
+        m_tuningTable[i] = static_cast<float>(std::tan(M_PI * cutoff / sampleRate));
+    }
+}
+
+float VoiceFilterBank::octavesFor(float cutoff)
+{
+    return std::log2(std::max(MIN_CUTOFF, cutoff) / MIN_CUTOFF);
+}
+
+void VoiceFilterBank::resetVoice(int voice, float tuning)
+{
+    for (int plane = 0; plane < 2 * STATES; ++plane) {
+        m_states[plane * m_stride + voice] = 0.0f;
+    }
+    m_tunings[voice] = tuning;
+}
+
+void VoiceFilterBank::copyVoice(int from, int to)
+{
+    for (int plane = 0; plane < 2 * STATES; ++plane) {
+        m_states[plane * m_stride + to] = m_states[plane * m_stride + from];
+    }
+    m_tunings[to] = m_tunings[from];
+}
+
+void VoiceFilterBank::clear()
+{
+    std::fill(m_states.begin(), m_states.end(), 0.0f);
+}
+
+void VoiceFilterBank::process(FilterType type, float resonance, int begin, int end, const float* tunings,
+                              int firstUpdate, const float* leftLanes, const float* rightLanes,
+                              const float* gains, float* left, float* right, int frames)
+{
+    if (type == FilterType::OFF || begin >= end || frames <= 0) {
+        return;
+    }
+    m_kernel(*this, type, resonance, begin, end, tunings, firstUpdate, leftLanes, rightLanes, gains,
+             left, right, std::min(OscillatorBank::MAX_FRAMES, frames));
+}
+
+void VoiceFilterBank::processScalar(VoiceFilterBank& bank, FilterType type, float resonance, int begin,
+                                    int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                                    const float* rightLanes, const float* gains, float* left, float* right,
+                                    int frames)
+{
+    const float k = feedbackFor(type, resonance);
+    const int stride = bank.m_stride;
+
+    for (int voice = begin; voice < end; ++voice) {
+        float* states[2 * STATES];
+        for (int plane = 0; plane < 2 * STATES; ++plane) {
+            states[plane] = bank.m_states.data() + plane * stride + voice;
+        }
+        float& tuning = bank.m_tunings[voice];
+
+        switch (type) {
+            case FilterType::LOWPASS:
+                filterVoiceScalar<FilterType::LOWPASS>(states, tuning, k, tunings + voice, stride,
+                                                       firstUpdate, leftLanes + voice, rightLanes + voice,
+                                                       gains + voice, left, right, frames);
+                break;
+            case FilterType::BANDPASS:
+                filterVoiceScalar<FilterType::BANDPASS>(states, tuning, k, tunings + voice, stride,
+                                                        firstUpdate, leftLanes + voice, rightLanes + voice,
+                                                        gains + voice, left, right, frames);
+                break;
+            case FilterType::HIGHPASS:
+                filterVoiceScalar<FilterType::HIGHPASS>(states, tuning, k, tunings + voice, stride,
+                                                        firstUpdate, leftLanes + voice, rightLanes + voice,
+                                                        gains + voice, left, right, frames);
+                break;
+            default:
+                filterVoiceScalar<FilterType::LADDER>(states, tuning, k, tunings + voice, stride,
+                                                      firstUpdate, leftLanes + voice, rightLanes + voice,
+                                                      gains + voice, left, right, frames);
+                break;
+        }
+    }
+}
+
+#ifdef VSYNTH_X86
+
+void VoiceFilterBank::processSSE2(VoiceFilterBank& bank, FilterType type, float resonance, int begin,
+                                  int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                                  const float* rightLanes, const float* gains, float* left, float* right,
+                                  int frames)
+{
+    float* states = bank.m_states.data();
+    float* currentTunings = bank.m_tunings.data();
+    const float k = feedbackFor(type, resonance);
+    const int stride = bank.m_stride;
+
+    switch (type) {
+        case FilterType::LOWPASS:
+            filterLanesSSE2<FilterType::LOWPASS>(states, currentTunings, stride, k, begin, end, tunings,
+                                                 firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                 frames);
+            break;
+        case FilterType::BANDPASS:
+            filterLanesSSE2<FilterType::BANDPASS>(states, currentTunings, stride, k, begin, end, tunings,
+                                                  firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                  frames);
+            break;
+        case FilterType::HIGHPASS:
+            filterLanesSSE2<FilterType::HIGHPASS>(states, currentTunings, stride, k, begin, end, tunings,
+                                                  firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                  frames);
+            break;
+        default:
+            filterLanesSSE2<FilterType::LADDER>(states, currentTunings, stride, k, begin, end, tunings,
+                                                firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                frames);
+            break;
+    }
+}
+
+void VoiceFilterBank::processAVX2(VoiceFilterBank& bank, FilterType type, float resonance, int begin,
+                                  int end, const float* tunings, int firstUpdate, const float* leftLanes,
+                                  const float* rightLanes, const float* gains, float* left, float* right,
+                                  int frames)
+{
+    float* states = bank.m_states.data();
+    float* currentTunings = bank.m_tunings.data();
+    const float k = feedbackFor(type, resonance);
+    const int stride = bank.m_stride;
+
+    switch (type) {
+        case FilterType::LOWPASS:
+            filterLanesAVX2<FilterType::LOWPASS>(states, currentTunings, stride, k, begin, end, tunings,
+                                                 firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                 frames);
+            break;
+        case FilterType::BANDPASS:
+            filterLanesAVX2<FilterType::BANDPASS>(states, currentTunings, stride, k, begin, end, tunings,
+                                                  firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                  frames);
+            break;
+        case FilterType::HIGHPASS:
+            filterLanesAVX2<FilterType::HIGHPASS>(states, currentTunings, stride, k, begin, end, tunings,
+                                                  firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                  frames);
+            break;
+        default:
+            filterLanesAVX2<FilterType::LADDER>(states, currentTunings, stride, k, begin, end, tunings,
+                                                firstUpdate, leftLanes, rightLanes, gains, left, right,
+                                                frames);
+            break;
+    }
+}
+
+#endif // VSYNTH_X86
@@ -0,0 +1,328 @@
+#include "vsynth/VoicePool.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+// Key tracking pivots around middle C
+constexpr int KEY_TRACKING_CENTRE = 60;
+}
+
+VoicePool::VoicePool(int capacity, int sampleRate)
+    : m_capacity(std::max(1, capacity))
+    , m_sampleRate(sampleRate)
+    , m_activeCount(0)
+    , m_nextAge(0)
+    , m_envelopeParameters(sampleRate)
+    , m_filterEnvelopeParameters(controlRate(sampleRate))
+    , m_oscillators(m_capacity, MAX_OSCILLATORS)
+    , m_filters(m_oscillators.stride(), sampleRate)
+    , m_filterType(FilterType::OFF)
+    , m_filterCutoffOctaves(VoiceFilterBank::octavesFor(2000.0f))
+    , m_filterResonance(0.2f)
+    , m_filterEnvelopeAmount(0.0f)
+    , m_filterKeyTracking(0.0f)
+    , m_controlPhase(0)
+    , m_threads(nullptr)
+    , m_nanosPerVoiceFrame(0.0)
+    , m_threaded(false)
+    , m_jobTime(0)
+    , m_blockLeft(nullptr)
+    , m_blockRight(nullptr)
+    , m_blockFrames(0)
+    , m_voicesPerJob(0)
+    , m_oscillatorCount(1)
+    , m_waveform(WaveformType::SINE)
+    , m_frequencyScale(nullptr)
+{
+    m_notes.resize(m_capacity, -1);
+    m_velocities.resize(m_capacity, 0.0f);
+    m_oscillatorCounts.resize(m_capacity, 0);
+    m_ages.resize(m_capacity, 0);
+    m_envelopes.resize(m_capacity, ADSREnvelope(&m_envelopeParameters));
+    m_filterEnvelopes.resize(m_capacity, ADSREnvelope(&m_filterEnvelopeParameters));
+    
+    setRenderThreads(nullptr);
+}
+
+void VoicePool::setRenderThreads(RenderThreadPool* threads)
+{
+    m_threads = threads;
+    
+    // The calling thread renders job 0 straight into the output
+    const int jobCount = threads ? threads->threadCount() + 1 : 1;
+    m_jobs.resize(jobCount);
+    for (int i = 0; i < jobCount; ++i) {
+        m_jobs[i].gains.assign(OscillatorBank::MAX_FRAMES * m_oscillators.stride(), 0.0f);
+        m_jobs[i].envelopeBuffer.assign(OscillatorBank::MAX_FRAMES, 0.0f);
+        m_jobs[i].leftLanes.assign(OscillatorBank::MAX_FRAMES * m_oscillators.stride(), 0.0f);
+        m_jobs[i].rightLanes.assign(OscillatorBank::MAX_FRAMES * m_oscillators.stride(), 0.0f);
+        m_jobs[i].tunings.assign(VoiceFilterBank::MAX_UPDATES * m_oscillators.stride(), 0.0f);
+        m_jobs[i].filterEnvelopeBuffer.assign(VoiceFilterBank::MAX_UPDATES, 0.0f);
+        m_jobs[i].leftOutput.assign(i == 0 ? 0 : MAX_BLOCK_SIZE, 0.0f);
+        m_jobs[i].rightOutput.assign(i == 0 ? 0 : MAX_BLOCK_SIZE, 0.0f);
+    }
+}
+
+void VoicePool::setSampleRate(int sampleRate)
+{
+    if (sampleRate == m_sampleRate) {
+        return;
+    }
+    m_oscillators.scaleIncrements(static_cast<float>(m_sampleRate) / static_cast<float>(sampleRate));
+    m_sampleRate = sampleRate;
+    m_envelopeParameters.setSampleRate(sampleRate);
+    m_filterEnvelopeParameters.setSampleRate(controlRate(sampleRate));
+    m_filters.setSampleRate(sampleRate);
+}
+
+void VoicePool::setFilterType(FilterType type)
+{
+    if (type != m_filterType) {
+        // The filters keep different state, so start from silence
+        m_filters.clear();
+        m_filterType = type;
+    }
+}
+
+void VoicePool::setFilterCutoff(float cutoff)
+{
+    m_filterCutoffOctaves = VoiceFilterBank::octavesFor(cutoff);
+}
+
+float VoicePool::filterOctaves(int slot, float envelope) const
+{
+    return m_filterCutoffOctaves + m_filterEnvelopeAmount * envelope
+           + m_filterKeyTracking * static_cast<float>(m_notes[slot] - KEY_TRACKING_CENTRE) / 12.0f;
+}
+
+int VoicePool::allocate()
+{
+    return m_activeCount++;
+}
+
+void VoicePool::startVoice(int slot, int note, float velocity, int oscillatorCount,
+                           float pan, float spread)
+{
+    const float twoPi = 2.0f * static_cast<float>(M_PI);
+    const float frequency = 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+    
+    m_notes[slot] = note;
+    m_velocities[slot] = velocity;
+    m_oscillatorCounts[slot] = std::max(1, std::min(MAX_OSCILLATORS, oscillatorCount));
+    m_ages[slot] = m_nextAge++;
+    
+    // The detuned oscillators go to either side of the voice, a single
+    // pair straddles it
+    static constexpr float SPREAD_POSITIONS[MAX_OSCILLATORS + 1][MAX_OSCILLATORS] = {
+        {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {-1.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 1.0f}
+    };
+    
+    float increments[MAX_OSCILLATORS];
+    float pans[MAX_OSCILLATORS];
+    for (int osc = 0; osc < MAX_OSCILLATORS; ++osc) {
+        // Slightly detune additional oscillators for richness
+        float detune = 1.0f + (osc * 0.01f);
+        increments[osc] = twoPi * frequency * detune / static_cast<float>(m_sampleRate);
+        pans[osc] = pan + spread * SPREAD_POSITIONS[m_oscillatorCounts[slot]][osc];
+    }
+    m_oscillators.setVoice(slot, m_oscillatorCounts[slot], increments, pans);
+    
+    m_envelopes[slot].reset();
+    m_filterEnvelopes[slot].reset();
+    m_filters.resetVoice(slot, m_filters.tuning(filterOctaves(slot, 0.0f)));
+}
+
+void VoicePool::trigger(int slot)
+{
+    m_envelopes[slot].trigger();
+    m_filterEnvelopes[slot].trigger();
+}
+
+void VoicePool::retrigger(int slot, float velocity)
+{
+    m_velocities[slot] = velocity;
+    m_ages[slot] = m_nextAge++;
+    trigger(slot);
+}
+
+void VoicePool::release(int slot)
+{
+    m_envelopes[slot].release();
+    m_filterEnvelopes[slot].release();
+}
+
+void VoicePool::free(int slot)
+{
+    const int last = --m_activeCount;
+    if (slot != last) {
+        m_notes[slot] = m_notes[last];
+        m_velocities[slot] = m_velocities[last];
+        m_oscillatorCounts[slot] = m_oscillatorCounts[last];
+        m_ages[slot] = m_ages[last];
+        m_envelopes[slot] = m_envelopes[last];
+        m_filterEnvelopes[slot] = m_filterEnvelopes[last];
+        m_oscillators.copyVoice(last, slot);
+        m_filters.copyVoice(last, slot);
+    }
+    m_notes[last] = -1;
+}
+
+void VoicePool::renderBlock(float* left, float* right, int frames, WaveformType waveform,
+                            const float* frequencyScale)
+{
+    m_oscillatorCount = 1;
+    for (int slot = 0; slot < m_activeCount; ++slot) {
+        m_oscillatorCount = std::max(m_oscillatorCount, m_oscillatorCounts[slot]);
+    }
+    m_waveform = waveform;
+    
+    // Split the active voices into whole lane groups, one range per job, but
+    // only once their measured cost would eat too much of the block period
+    // on this thread alone; a split costs a hand-off and a mix
+    int jobCount = std::min(static_cast<int>(m_jobs.size()), m_activeCount / MIN_VOICES_PER_JOB);
+    if (jobCount >= 2) {
+        const double periodNanos = 1e9 * frames / m_sampleRate;
+        const double predictedNanos = m_nanosPerVoiceFrame * m_activeCount * frames;
+        m_threaded = predictedNanos > THREADED_LOAD * periodNanos * (m_threaded ? 0.5 : 1.0);
+    } else {
+        m_threaded = false;
+    }
+    
+    if (!m_threaded) {
+        if (m_activeCount > 0) {
+            m_frequencyScale = frequencyScale;
+            const auto start = std::chrono::steady_clock::now();
+            renderVoices(0, m_activeCount, m_jobs[0], left, right, frames);
+            if (m_threads) {
+                measureRenderTime(std::chrono::steady_clock::now() - start, m_activeCount, frames);
+            }
+        }
+        m_controlPhase = (m_controlPhase + frames) % VoiceFilterBank::CONTROL_INTERVAL;
+    } else {
+        const int perJob = (m_activeCount + jobCount - 1) / jobCount;
+        m_voicesPerJob = (perJob + OscillatorBank::LANE_PADDING - 1)
+                         / OscillatorBank::LANE_PADDING * OscillatorBank::LANE_PADDING;
+        jobCount = (m_activeCount + m_voicesPerJob - 1) / m_voicesPerJob;
+        
+        for (int offset = 0; offset < frames; offset += MAX_BLOCK_SIZE) {
+            const int count = std::min(MAX_BLOCK_SIZE, frames - offset);
+            m_blockLeft = left + offset;
+            m_blockRight = right + offset;
+            m_blockFrames = count;
+            m_frequencyScale = frequencyScale + offset;
+            
+            m_threads->run(jobCount, &VoicePool::renderJob, this);
+            measureRenderTime(m_jobTime, m_voicesPerJob, count);
+            m_controlPhase = (m_controlPhase + count) % VoiceFilterBank::CONTROL_INTERVAL;
+            
+            for (int job = 1; job < jobCount; ++job) {
+                const float* leftPartial = m_jobs[job].leftOutput.data();
+                const float* rightPartial = m_jobs[job].rightOutput.data();
+                for (int i = 0; i < count; ++i) {
+                    left[offset + i] += leftPartial[i];
+                    right[offset + i] += rightPartial[i];
+                }
+            }
+        }
+    }
+    
+    // Walk backwards so the voice swapped into a freed slot was already checked
+    for (int slot = m_activeCount - 1; slot >= 0; --slot) {
+        if (!m_envelopes[slot].isActive()) {
+            free(slot);
+        }
+    }
+}
+
+void VoicePool::renderJob(void* context, int job)
+{
+    VoicePool& pool = *static_cast<VoicePool*>(context);
+    const int begin = job * pool.m_voicesPerJob;
+    const int end = std::min(pool.m_activeCount, begin + pool.m_voicesPerJob);
+    RenderJob& scratch = pool.m_jobs[job];
+    
+    float* left = pool.m_blockLeft;
+    float* right = pool.m_blockRight;
+    if (job > 0) {
+        left = scratch.leftOutput.data();
+        right = scratch.rightOutput.data();
+        std::fill(left, left + pool.m_blockFrames, 0.0f);
+        std::fill(right, right + pool.m_blockFrames, 0.0f);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    pool.renderVoices(begin, end, scratch, left, right, pool.m_blockFrames);
+    if (job == 0) {
+        pool.m_jobTime = std::chrono::steady_clock::now() - start;
+    }
+}
+
+void VoicePool::measureRenderTime(std::chrono::steady_clock::duration time, int voices, int frames)
+{
+    const double nanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count())
+                         / (static_cast<double>(voices) * frames);
+    // Start from the first measurement, then smooth over a few dozen blocks
+    m_nanosPerVoiceFrame = m_nanosPerVoiceFrame > 0.0
+                           ? m_nanosPerVoiceFrame + 0.05 * (nanos - m_nanosPerVoiceFrame)
+                           : nanos;
+}
+
+void VoicePool::renderVoices(int begin, int end, RenderJob& job, float* left, float* right, int frames)
+{
+    const int stride = m_oscillators.stride();
+    const int lanes = std::min(stride, (end + OscillatorBank::LANE_PADDING - 1)
+                                       / OscillatorBank::LANE_PADDING * OscillatorBank::LANE_PADDING);
+    const bool filtered = m_filterType != FilterType::OFF;
+    float* gains = job.gains.data();
+    float* envelope = job.envelopeBuffer.data();
+    float* tunings = job.tunings.data();
+    float* filterEnvelope = job.filterEnvelopeBuffer.data();
+    
+    for (int offset = 0; offset < frames; offset += OscillatorBank::MAX_FRAMES) {
+        const int count = std::min(OscillatorBank::MAX_FRAMES, frames - offset);
+        
+        // Filter cutoffs change at the frames of this chunk on the control grid
+        const int phase = (m_controlPhase + offset) % VoiceFilterBank::CONTROL_INTERVAL;
+        const int firstUpdate = (VoiceFilterBank::CONTROL_INTERVAL - phase) % VoiceFilterBank::CONTROL_INTERVAL;
+        const int updates = (filtered && firstUpdate < count)
+                            ? (count - firstUpdate - 1) / VoiceFilterBank::CONTROL_INTERVAL + 1 : 0;
+        
+        // Envelopes are rendered per voice, then transposed into the gain lanes
+        for (int slot = begin; slot < end; ++slot) {
+            const float velocity = m_velocities[slot];
+            m_envelopes[slot].renderBlock(envelope, count);
+            for (int t = 0; t < count; ++t) {
+                gains[t * stride + slot] = envelope[t] * velocity;
+            }
+            
+            if (updates > 0) {
+                m_filterEnvelopes[slot].renderBlock(filterEnvelope, updates);
+                for (int update = 0; update < updates; ++update) {
+                    tunings[update * stride + slot] = m_filters.tuning(filterOctaves(slot, filterEnvelope[update]));
+                }
+            }
+        }
+        
+        // Padding lanes of the last group stay silent
+        for (int t = 0; t < count; ++t) {
+            std::fill(gains + t * stride + end, gains + t * stride + lanes, 0.0f);
+        }
+        
+        if (!filtered) {
+            m_oscillators.render(m_waveform, begin, end, m_oscillatorCount,
+                                 m_frequencyScale + offset, gains, left + offset, right + offset, count);
+            continue;
+        }
+        
+        // Filtered voices are scaled by their envelope after the filter.
+        // A few lane groups at a time, so the unmixed lanes stay in cache.
+        float* leftLanes = job.leftLanes.data();
+        float* rightLanes = job.rightLanes.data();
+        for (int first = begin; first < end; first += FILTER_VOICES_PER_PASS) {
+            const int last = std::min(end, first + FILTER_VOICES_PER_PASS);
+            m_oscillators.renderPerVoice(m_waveform, first, last, m_oscillatorCount,
+                                         m_frequencyScale + offset, leftLanes, rightLanes, count);
+            m_filters.process(m_filterType, m_filterResonance, first, last, tunings, firstUpdate,
+                              leftLanes, rightLanes, gains, left + offset, right + offset, count);
+        }
+    }
+}
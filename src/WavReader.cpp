@@ -0,0 +1,125 @@
+#include "vsynth/WavReader.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+constexpr uint16_t FORMAT_PCM = 1;
+constexpr uint16_t FORMAT_FLOAT = 3;
+constexpr uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+uint16_t read16(const uint8_t* bytes)
+{
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+uint32_t read32(const uint8_t* bytes)
+{
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8)
+         | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+} // namespace
+
+WavReader::WavReader()
+    : m_sampleRate(0)
+    , m_channels(0)
+{
+}
+
+bool WavReader::load(const std::string& filename)
+{
+    m_samples.clear();
+    m_sampleRate = 0;
+    m_channels = 0;
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not open file for reading: " << filename << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0
+        || std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        std::cerr << "Not a RIFF/WAVE file: " << filename << std::endl;
+        return false;
+    }
+
+    uint16_t format = 0;
+    int bitsPerSample = 0;
+    const uint8_t* data = nullptr;
+    size_t dataSize = 0;
+
+    // Walk the chunks; each is padded to an even size
+    size_t offset = 12;
+    while (offset + 8 <= bytes.size()) {
+        const uint8_t* chunk = bytes.data() + offset;
+        const size_t size = read32(chunk + 4);
+        const size_t available = std::min(size, bytes.size() - offset - 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            format = read16(chunk + 8);
+            m_channels = read16(chunk + 10);
+            m_sampleRate = static_cast<int>(read32(chunk + 12));
+            bitsPerSample = read16(chunk + 22);
+            // The real format is the first two bytes of the subformat GUID
+            if (format == FORMAT_EXTENSIBLE && available >= 26) {
+                format = read16(chunk + 32);
+            }
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            dataSize = available;
+        }
+
+        offset += 8 + size + (size & 1);
+    }
+
+    const bool supported = (format == FORMAT_PCM && (bitsPerSample == 8 || bitsPerSample == 16
+                                                     || bitsPerSample == 24 || bitsPerSample == 32))
+                        || (format == FORMAT_FLOAT && bitsPerSample == 32);
+    if (!data || m_channels < 1 || m_sampleRate < 1 || !supported) {
+        std::cerr << "Unsupported or incomplete WAV file: " << filename << std::endl;
+        m_channels = 0;
+        m_sampleRate = 0;
+        return false;
+    }
+
+    const int bytesPerSample = bitsPerSample / 8;
+    const size_t count = dataSize / (bytesPerSample * m_channels) * m_channels;
+    m_samples.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* sample = data + i * bytesPerSample;
+        switch (bitsPerSample) {
+            case 8:
+                // 8-bit WAV is unsigned
+                m_samples[i] = (static_cast<int>(sample[0]) - 128) / 128.0f;
+                break;
+            case 16:
+                m_samples[i] = static_cast<int16_t>(read16(sample)) / 32768.0f;
+                break;
+            case 24: {
+                // Sign-extend through the top byte of a 32-bit value
+                const int32_t value = static_cast<int32_t>(static_cast<uint32_t>(sample[0]) << 8
+                                                         | static_cast<uint32_t>(sample[1]) << 16
+                                                         | static_cast<uint32_t>(sample[2]) << 24) >> 8;
+                m_samples[i] = value / 8388608.0f;
+                break;
+            }
+            default:
+                if (format == FORMAT_FLOAT) {
+                    const uint32_t bits = read32(sample);
+                    std::memcpy(&m_samples[i], &bits, sizeof(float));
+                } else {
+                    m_samples[i] = static_cast<int32_t>(read32(sample)) / 2147483648.0f;
+                }
+                break;
+        }
+    }
+
+    return true;
+}
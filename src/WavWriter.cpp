@@ -0,0 +1,106 @@
+#include "vsynth/WavWriter.h"
+#include <iostream>
+#include <algorithm>
+
+WavWriter::WavWriter()
+    : m_sampleRate(44100)
+    , m_channels(1)
+    , m_framesWritten(0)
+{
+}
+
+WavWriter::~WavWriter()
+{
+    close();
+}
+
+bool WavWriter::open(const std::string& filename, int sampleRate, int channels)
+{
+    close();
+
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        std::cerr << "Could not open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    m_sampleRate = sampleRate;
+    m_channels = std::max(1, channels);
+    m_framesWritten = 0;
+
+    // Placeholder sizes until close()
+    writeHeader(0);
+    return static_cast<bool>(m_file);
+}
+
+bool WavWriter::write(const float* samples, int frames)
+{
+    if (!m_file.is_open()) {
+        return false;
+    }
+
+    const size_t count = static_cast<size_t>(frames) * m_channels;
+    m_pcmBuffer.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        float sample = std::max(-1.0f, std::min(1.0f, samples[i]));
+        m_pcmBuffer[i] = static_cast<int16_t>(sample * 32767.0f);
+    }
+
+    m_file.write(reinterpret_cast<const char*>(m_pcmBuffer.data()), count * sizeof(int16_t));
+    m_framesWritten += frames;
+    return static_cast<bool>(m_file);
+}
+
+void WavWriter::close()
+{
+    if (!m_file.is_open()) {
+        return;
+    }
+    
+    m_file.seekp(0);
+    writeHeader(m_framesWritten * m_channels * sizeof(int16_t));
+    m_file.close();
+}
+
+void WavWriter::writeHeader(uint64_t dataSize)
+{
+    auto write32 = [this](uint32_t value) {
+        m_file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    auto write64 = [this](uint64_t value) {
+        m_file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    auto write16 = [this](uint16_t value) {
+        m_file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    
+    // RIFF header, a 28 byte chunk reserved for the RF64 sizes, fmt and data.
+    // Files over 4 GB become RF64: the 32-bit sizes are set to 0xFFFFFFFF
+    // and the reserved JUNK chunk turns into ds64 holding the real sizes.
+    const uint64_t riffSize = HEADER_SIZE - 8 + dataSize;
+    const bool rf64 = riffSize > 0xFFFFFFFFull;
+    const uint16_t blockAlign = static_cast<uint16_t>(m_channels * sizeof(int16_t));
+    
+    m_file.write(rf64 ? "RF64" : "RIFF", 4);
+    write32(rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(riffSize));
+    m_file.write("WAVE", 4);
+    
+    m_file.write(rf64 ? "ds64" : "JUNK", 4);
+    write32(28);
+    write64(rf64 ? riffSize : 0);
+    write64(rf64 ? dataSize : 0);
+    write64(rf64 ? m_framesWritten : 0);
+    write32(0); // No table entries
+    
+    m_file.write("fmt ", 4);
+    write32(16);
+    write16(1); // PCM
+    write16(static_cast<uint16_t>(m_channels));
+    write32(static_cast<uint32_t>(m_sampleRate));
+    write32(static_cast<uint32_t>(m_sampleRate) * blockAlign);
+    write16(blockAlign);
+    write16(16);
+    
+    m_file.write("data", 4);
+    write32(rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(dataSize));
+}
@@ -0,0 +1,121 @@
+#include "vsynth/Wavetable.h"
+#include "vsynth/FFTAnalyzer.h"
+#include <fftw3.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace {
+
+// Level 0 covers increments up to this many cycles per sample: the
+// highest harmonic of a TABLE_SIZE table lands exactly on Nyquist
+constexpr float LEVEL0_CYCLES = 0.5f / (Wavetable::TABLE_SIZE / 2);
+
+} // namespace
+
+void Wavetable::initialize()
+{
+    forWaveform(WaveformType::BANDLIMITED_SQUARE);
+}
+
+bool Wavetable::isWavetable(WaveformType waveform)
+{
+    return waveform == WaveformType::BANDLIMITED_SQUARE ||
+           waveform == WaveformType::BANDLIMITED_SAWTOOTH ||
+           waveform == WaveformType::BANDLIMITED_TRIANGLE;
+}
+
+const Wavetable* Wavetable::forWaveform(WaveformType waveform)
+{
+    // Built together on first use; function-local static init is thread-safe
+    static const Wavetable square(WaveformType::BANDLIMITED_SQUARE);
+    static const Wavetable sawtooth(WaveformType::BANDLIMITED_SAWTOOTH);
+    static const Wavetable triangle(WaveformType::BANDLIMITED_TRIANGLE);
+    
+    switch (waveform) {
+        case WaveformType::BANDLIMITED_SQUARE:
+            return &square;
+        case WaveformType::BANDLIMITED_SAWTOOTH:
+            return &sawtooth;
+        case WaveformType::BANDLIMITED_TRIANGLE:
+            return &triangle;
+        default:
+            return nullptr;
+    }
+}
+
+int Wavetable::levelFor(float increment) const
+{
+    float cycles = increment / (2.0f * static_cast<float>(M_PI));
+    if (cycles <= LEVEL0_CYCLES) {
+        return 0;
+    }
+    int level = static_cast<int>(std::ceil(std::log2(cycles / LEVEL0_CYCLES)));
+    return std::min(level, NUM_LEVELS - 1);
+}
+
+Wavetable::Wavetable(WaveformType waveform)
+{
+    m_samples.resize(NUM_LEVELS * LEVEL_STRIDE, 0.0f);
+    
+    // Each level is synthesized from its harmonic series with an inverse real FFT
+    const int bins = TABLE_SIZE / 2 + 1;
+    fftwf_complex* spectrum = fftwf_alloc_complex(bins);
+    float* cycle = fftwf_alloc_real(TABLE_SIZE);
+    fftwf_plan plan;
+    {
+        std::lock_guard<std::mutex> lock(FFTAnalyzer::plannerMutex());
+        plan = fftwf_plan_dft_c2r_1d(TABLE_SIZE, spectrum, cycle, FFTW_ESTIMATE);
+    }
+    
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        // Harmonics strictly below Nyquist at the top of this level's octave
+        const int maxHarmonic = std::max(1, (TABLE_SIZE / 2 >> level) - 1);
+        
+        for (int k = 0; k < bins; ++k) {
+            float cosine = 0.0f;
+            float sine = 0.0f;
+            if (k >= 1 && k <= maxHarmonic) {
+                harmonic(waveform, k, cosine, sine);
+            }
+            // c2r evaluates X0 + sum 2*Re(Xk * e^(i*k*x)) for the interior bins
+            spectrum[k][0] = 0.5f * cosine;
+            spectrum[k][1] = -0.5f * sine;
+        }
+        
+        fftwf_execute(plan);
+        
+        float* table = m_samples.data() + level * LEVEL_STRIDE;
+        std::copy(cycle, cycle + TABLE_SIZE, table);
+        table[TABLE_SIZE] = table[0];
+        table[TABLE_SIZE + 1] = table[1];
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(FFTAnalyzer::plannerMutex());
+        fftwf_destroy_plan(plan);
+    }
+    fftwf_free(cycle);
+    fftwf_free(spectrum);
+}
+
+void Wavetable::harmonic(WaveformType waveform, int k, float& cosine, float& sine)
+{
+    const float pi = static_cast<float>(M_PI);
+    const bool odd = (k % 2) == 1;
+    
+    // Series match the naive waveforms in Oscillator (same phase and polarity)
+    switch (waveform) {
+        case WaveformType::BANDLIMITED_SQUARE:
+            sine = odd ? 4.0f / (pi * k) : 0.0f;
+            break;
+        case WaveformType::BANDLIMITED_SAWTOOTH:
+            sine = -2.0f / (pi * k);
+            break;
+        case WaveformType::BANDLIMITED_TRIANGLE:
+            cosine = odd ? -8.0f / (pi * pi * k * k) : 0.0f;
+            break;
+        default:
+            break;
+    }
+}
@@ -1,12 +1,25 @@
 #include <QApplication>
+#include <QDir>
+#include <QStandardPaths>
 #include "vsynth/MainWindow.h"
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
     
-    MainWindow window;
-    window.show();
+    // FFTW wisdom from earlier runs makes FFTW_MEASURE planning instant
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(cacheDir);
+    const std::string wisdomFile = QDir(cacheDir).filePath("fftw_wisdom").toStdString();
+    FFTAnalyzer::importWisdom(wisdomFile);
     
-    return app.exec();
+    int result = 0;
+    {
+        MainWindow window;
+        window.show();
+        result = app.exec();
+    }
+    
+    FFTAnalyzer::exportWisdom(wisdomFile);
+    return result;
 }
@@ -0,0 +1,294 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "vsynth/OfflineRenderer.h"
+#include "vsynth/Recorder.h"
+
+// Headless renderer: note event file (Recorder's note export format) to WAV
+
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options] <events.txt> <output.wav>\n"
+              << "Options:\n"
+              << "  --sample-rate <hz>     Output sample rate (default 44100)\n"
+              << "  --block-size <frames>  Render block size (default 4096)\n"
+              << "  --voices <n>           Polyphony (default 64)\n"
+              << "  --threads <n>          Voice render worker threads (default 0)\n"
+              << "  --tail <seconds>       Time rendered after the last event (default 2)\n"
+              << "  --channels <n>         Output channels: 2 stereo (default), 1 mono downmix\n"
+              << "  --waveform <0-7>       Sine, square, saw, triangle, noise, band-limited square/saw/triangle\n"
+              << "  --oscillators <1-3>    Oscillators per voice (default 2)\n"
+              << "  --pan <-1-1>           Voice pan, -1 left to 1 right (default 0)\n"
+              << "  --spread <0-1>         Stereo spread of the detuned oscillators\n"
+              << "  --attack/--decay/--sustain/--release <value>\n"
+              << "  --envelope-curve <linear|exponential|analog>\n"
+              << "  --filter <off|lowpass|bandpass|highpass|ladder>\n"
+              << "  --cutoff <hz>          Filter cutoff (default 2000)\n"
+              << "  --resonance <0-1>      Filter resonance (default 0.2)\n"
+              << "  --filter-env <octaves> Cutoff shift at full filter envelope, -8 to 8 (default 0)\n"
+              << "  --key-tracking <0-1>   How far the cutoff follows the note (default 0)\n"
+              << "  --filter-attack/--filter-decay/--filter-sustain/--filter-release <value>\n"
+              << "  --reverb <0-1>         Reverb mix\n"
+              << "  --room-size <0-1>      Reverb room size (default 0.5)\n"
+              << "  --damping <0-1>        Reverb high-frequency damping (default 0.5)\n"
+              << "  --ir <file.wav>        Impulse response for the convolution reverb\n"
+              << "  --ir-mix <0-1>         Convolution reverb mix (default 0.3)\n"
+              << "  --delay <0-1>          Delay mix\n"
+              << "  --delay-mode <echo|pingpong|chorus|flanger>\n"
+              << "  --delay-time <seconds> Echo time (default 0.3)\n"
+              << "  --delay-feedback <0-0.95>\n"
+              << "  --tempo <bpm>          Tempo for --delay-sync (default 120)\n"
+              << "  --delay-sync <beats>   Echo length in quarter notes, 0 for --delay-time\n"
+              << "  --oversample <1|2|4|8> Oversampling factor (default 1)\n"
+              << "  --oversample-quality <fast|balanced|high>\n";
+}
+
+int main(int argc, char *argv[])
+{
+    int sampleRate = 44100;
+    int blockSize = OfflineRenderer::DEFAULT_BLOCK_SIZE;
+    int voices = Synthesizer::DEFAULT_VOICES;
+    int threads = 0;
+    float tail = 2.0f;
+    int channels = Synthesizer::CHANNELS;
+
+    // Synth parameters are applied after construction, -1 keeps the default
+    int waveform = -1;
+    int oscillators = -1;
+    float pan = 0.0f, spread = -1.0f;
+    float attack = -1.0f, decay = -1.0f, sustain = -1.0f, release = -1.0f;
+    int envelopeCurve = -1;
+    int filterType = -1;
+    float cutoff = -1.0f, resonance = -1.0f, keyTracking = -1.0f;
+    float filterEnvelope = 0.0f;
+    float filterAttack = -1.0f, filterDecay = -1.0f, filterSustain = -1.0f, filterRelease = -1.0f;
+    float reverb = -1.0f, delay = -1.0f;
+    float roomSize = -1.0f, damping = -1.0f;
+    int delayMode = -1;
+    float delayTime = -1.0f, delayFeedback = -1.0f;
+    float tempo = -1.0f, delaySync = -1.0f;
+    std::string impulseResponse;
+    float impulseResponseMix = -1.0f;
+    int oversample = 1;
+    OversamplingQuality oversampleQuality = OversamplingQuality::BALANCED;
+
+    std::string inputFile;
+    std::string outputFile;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg.rfind("--", 0) == 0 && !hasValue) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        } else if (arg == "--sample-rate") {
+            sampleRate = std::atoi(argv[++i]);
+        } else if (arg == "--block-size") {
+            blockSize = std::atoi(argv[++i]);
+        } else if (arg == "--voices") {
+            voices = std::atoi(argv[++i]);
+        } else if (arg == "--threads") {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--tail") {
+            tail = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--channels") {
+            channels = std::atoi(argv[++i]);
+        } else if (arg == "--waveform") {
+            waveform = std::atoi(argv[++i]);
+        } else if (arg == "--oscillators") {
+            oscillators = std::atoi(argv[++i]);
+        } else if (arg == "--pan") {
+            pan = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--spread") {
+            spread = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--attack") {
+            attack = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--decay") {
+            decay = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--sustain") {
+            sustain = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--release") {
+            release = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--envelope-curve") {
+            std::string curve = argv[++i];
+            if (curve == "linear") {
+                envelopeCurve = static_cast<int>(EnvelopeCurve::LINEAR);
+            } else if (curve == "exponential") {
+                envelopeCurve = static_cast<int>(EnvelopeCurve::EXPONENTIAL);
+            } else if (curve == "analog") {
+                envelopeCurve = static_cast<int>(EnvelopeCurve::ANALOG);
+            } else {
+                std::cerr << "Unknown envelope curve: " << curve << std::endl;
+                return 1;
+            }
+        } else if (arg == "--filter") {
+            std::string type = argv[++i];
+            if (type == "off") {
+                filterType = static_cast<int>(FilterType::OFF);
+            } else if (type == "lowpass") {
+                filterType = static_cast<int>(FilterType::LOWPASS);
+            } else if (type == "bandpass") {
+                filterType = static_cast<int>(FilterType::BANDPASS);
+            } else if (type == "highpass") {
+                filterType = static_cast<int>(FilterType::HIGHPASS);
+            } else if (type == "ladder") {
+                filterType = static_cast<int>(FilterType::LADDER);
+            } else {
+                std::cerr << "Unknown filter type: " << type << std::endl;
+                return 1;
+            }
+        } else if (arg == "--cutoff") {
+            cutoff = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--resonance") {
+            resonance = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--filter-env") {
+            filterEnvelope = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--key-tracking") {
+            keyTracking = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--filter-attack") {
+            filterAttack = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--filter-decay") {
+            filterDecay = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--filter-sustain") {
+            filterSustain = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--filter-release") {
+            filterRelease = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--reverb") {
+            reverb = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--delay") {
+            delay = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--delay-mode") {
+            std::string mode = argv[++i];
+            if (mode == "echo") {
+                delayMode = static_cast<int>(DelayMode::ECHO);
+            } else if (mode == "pingpong") {
+                delayMode = static_cast<int>(DelayMode::PING_PONG);
+            } else if (mode == "chorus") {
+                delayMode = static_cast<int>(DelayMode::CHORUS);
+            } else if (mode == "flanger") {
+                delayMode = static_cast<int>(DelayMode::FLANGER);
+            } else {
+                std::cerr << "Unknown delay mode: " << mode << std::endl;
+                return 1;
+            }
+        } else if (arg == "--delay-time") {
+            delayTime = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--delay-feedback") {
+            delayFeedback = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--tempo") {
+            tempo = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--delay-sync") {
+            delaySync = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--room-size") {
+            roomSize = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--damping") {
+            damping = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--ir") {
+            impulseResponse = argv[++i];
+        } else if (arg == "--ir-mix") {
+            impulseResponseMix = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--oversample") {
+            oversample = std::atoi(argv[++i]);
+        } else if (arg == "--oversample-quality") {
+            std::string quality = argv[++i];
+            if (quality == "fast") {
+                oversampleQuality = OversamplingQuality::FAST;
+            } else if (quality == "balanced") {
+                oversampleQuality = OversamplingQuality::BALANCED;
+            } else if (quality == "high") {
+                oversampleQuality = OversamplingQuality::HIGH;
+            } else {
+                std::cerr << "Unknown oversampling quality: " << quality << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else if (inputFile.empty()) {
+            inputFile = arg;
+        } else if (outputFile.empty()) {
+            outputFile = arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (inputFile.empty() || outputFile.empty() || sampleRate <= 0 || channels <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Recorder recorder(sampleRate);
+    if (!recorder.importNoteEvents(inputFile)) {
+        return 1;
+    }
+
+    OfflineRenderer renderer(sampleRate, voices, threads);
+    renderer.setBlockSize(blockSize);
+    renderer.setTailSeconds(tail);
+    renderer.setChannels(channels);
+
+    Synthesizer& synth = renderer.synthesizer();
+    if (waveform >= 0) synth.setWaveform(waveform);
+    if (oscillators >= 0) synth.setOscillatorCount(oscillators);
+    synth.setPan(pan);
+    if (spread >= 0.0f) synth.setStereoSpread(spread);
+    if (attack >= 0.0f) synth.setAttack(attack);
+    if (decay >= 0.0f) synth.setDecay(decay);
+    if (sustain >= 0.0f) synth.setSustain(sustain);
+    if (release >= 0.0f) synth.setRelease(release);
+    if (envelopeCurve >= 0) synth.setEnvelopeCurve(static_cast<EnvelopeCurve>(envelopeCurve));
+    if (filterType >= 0) synth.setFilterType(static_cast<FilterType>(filterType));
+    if (cutoff >= 0.0f) synth.setFilterCutoff(cutoff);
+    if (resonance >= 0.0f) synth.setFilterResonance(resonance);
+    synth.setFilterEnvelopeAmount(filterEnvelope);
+    if (keyTracking >= 0.0f) synth.setFilterKeyTracking(keyTracking);
+    if (filterAttack >= 0.0f) synth.setFilterAttack(filterAttack);
+    if (filterDecay >= 0.0f) synth.setFilterDecay(filterDecay);
+    if (filterSustain >= 0.0f) synth.setFilterSustain(filterSustain);
+    if (filterRelease >= 0.0f) synth.setFilterRelease(filterRelease);
+    if (reverb >= 0.0f) synth.setReverb(reverb);
+    if (delay >= 0.0f) synth.setDelay(delay);
+    if (delayMode >= 0) synth.setDelayMode(static_cast<DelayMode>(delayMode));
+    if (delayTime >= 0.0f) synth.setDelayTime(delayTime);
+    if (delayFeedback >= 0.0f) synth.setDelayFeedback(delayFeedback);
+    if (tempo > 0.0f) synth.setTempo(tempo);
+    if (delaySync >= 0.0f) synth.setDelaySync(delaySync);
+    if (roomSize >= 0.0f) synth.setReverbRoomSize(roomSize);
+    if (damping >= 0.0f) synth.setReverbDamping(damping);
+    synth.setOversampling(oversample, oversampleQuality);
+    if (impulseResponseMix >= 0.0f) synth.setConvolutionMix(impulseResponseMix);
+    if (!impulseResponse.empty()) {
+        synth.loadImpulseResponse(impulseResponse);
+        if (!synth.waitForImpulseResponse()) {
+            return 1;
+        }
+    }
+
+    if (!renderer.renderToWAV(recorder.getNoteEvents(), outputFile)) {
+        std::cerr << "Render failed" << std::endl;
+        return 1;
+    }
+
+    double seconds = renderer.getLastRenderSeconds();
+    double audioSeconds = 0.0;
+    if (!recorder.getNoteEvents().empty()) {
+        audioSeconds = static_cast<double>(recorder.getNoteEvents().back().samplePosition) / sampleRate;
+    }
+    audioSeconds += tail;
+
+    std::cout << "Rendered " << recorder.getNoteEvents().size() << " events ("
+              << audioSeconds << " s of audio) to " << outputFile << " in " << seconds << " s";
+    if (seconds > 0.0) {
+        std::cout << " (" << audioSeconds / seconds << "x real time)";
+    }
+    std::cout << std::endl;
+
+    return 0;
+}